@@ -0,0 +1,35 @@
+﻿// ConsoleQueue.c : O ciclo só copia o relatório do passo (sem formatação nem chamadas ao sistema); com a fila
+// cheia perde o relatório em vez de esperar pela consola.
+
+#include "ConsoleQueue.h"
+
+void consoleQueueInit(ConsoleQueue* queue) {
+	atomic_init(&queue->head, 0);
+	atomic_init(&queue->tail, 0);
+	atomic_init(&queue->dropped, 0);
+}
+
+// Função para pôr um relatório na fila (chamada pelo ciclo de controlo)
+bool consoleQueuePush(ConsoleQueue* queue, const StepReport* report) {
+	uint64_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+	if (head - tail >= CONSOLE_QUEUE_SIZE) {
+		atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+		return false;
+	}
+	queue->reports[head & (CONSOLE_QUEUE_SIZE - 1)] = *report;
+	atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+	return true;
+}
+
+// Função para tirar o relatório mais antigo (chamada pela consola)
+bool consoleQueuePop(ConsoleQueue* queue, StepReport* report) {
+	uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	uint64_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+	if (tail == head) {
+		return false;
+	}
+	*report = queue->reports[tail & (CONSOLE_QUEUE_SIZE - 1)];
+	atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+	return true;
+}
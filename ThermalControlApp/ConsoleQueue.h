@@ -0,0 +1,25 @@
+﻿// ConsoleQueue.h : Fila sem locks dos relatórios de cada passo, do ciclo de tempo real para a thread da consola.
+
+#ifndef CONSOLE_QUEUE_H
+#define CONSOLE_QUEUE_H
+
+#include "ThermalControlApp.h"
+#include <stdatomic.h>
+
+#define CONSOLE_QUEUE_SIZE 1024     // Relatórios em espera (potência de 2)
+#define CONSOLE_IDLE_MS 10          // Espera máxima da consola pelo terminal antes de voltar à fila
+
+// Estrutura ConsoleQueue: um produtor (o ciclo) e um consumidor (a consola)
+typedef struct {
+	_Alignas(64) _Atomic uint64_t head;     // Escrito só pelo ciclo de controlo
+	_Alignas(64) _Atomic uint64_t tail;     // Escrito só pela consola
+	_Alignas(64) StepReport reports[CONSOLE_QUEUE_SIZE];
+	_Atomic unsigned long dropped;          // Relatórios perdidos com a fila cheia
+} ConsoleQueue;
+
+// Funções da fila
+void consoleQueueInit(ConsoleQueue* queue);
+bool consoleQueuePush(ConsoleQueue* queue, const StepReport* report);
+bool consoleQueuePop(ConsoleQueue* queue, StepReport* report);
+
+#endif // CONSOLE_QUEUE_H
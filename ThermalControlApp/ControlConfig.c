@@ -0,0 +1,89 @@
+﻿// ControlConfig.c : O escritor aloca, troca e adia a libertação; nunca espera pelos leitores.
+// A lista de versões retiradas cresce se um leitor se atrasar, em vez de bloquear quem reconfigura.
+
+#include "ControlConfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int configDomainInit(ConfigDomain* domain, const ControlConfig* initial, size_t readerCount) {
+	ControlConfig* config = malloc(sizeof(*config));
+	if (config == NULL || readerCount > CONFIG_MAX_READERS) {
+		free(config);
+		return -1;
+	}
+	*config = *initial;
+	config->version = 1;
+	atomic_init(&domain->current, config);
+	atomic_init(&domain->epoch, 1);
+	for (size_t i = 0; i < CONFIG_MAX_READERS; i++) {
+		atomic_init(&domain->readerEpochs[i], i < readerCount ? 1 : CONFIG_READER_OFFLINE);
+	}
+	domain->readerCount = readerCount;
+	domain->retired = NULL;
+	domain->retiredCount = 0;
+	domain->retiredCapacity = 0;
+	domain->published = 1;
+	domain->reclaimed = 0;
+	return 0;
+}
+
+// Função para libertar as versões que nenhum leitor pode ainda estar a usar
+void configReclaim(ConfigDomain* domain) {
+	uint64_t oldest = CONFIG_READER_OFFLINE;
+	for (size_t i = 0; i < domain->readerCount; i++) {
+		uint64_t seen = atomic_load(&domain->readerEpochs[i]);
+		oldest = seen < oldest ? seen : oldest;
+	}
+	size_t kept = 0;
+	for (size_t i = 0; i < domain->retiredCount; i++) {
+		if (domain->retired[i].epoch <= oldest) {
+			free(domain->retired[i].config);
+			domain->reclaimed++;
+		}
+		else {
+			domain->retired[kept++] = domain->retired[i];
+		}
+	}
+	domain->retiredCount = kept;
+}
+
+// Função para publicar uma cópia de config; a versão anterior fica retirada até ao fim do período de graça
+int configPublish(ConfigDomain* domain, const ControlConfig* config) {
+	if (domain->retiredCount == domain->retiredCapacity) {
+		size_t capacity = domain->retiredCapacity > 0 ? domain->retiredCapacity * 2 : 8;
+		RetiredConfig* retired = realloc(domain->retired, capacity * sizeof(*retired));
+		if (retired == NULL) {
+			perror("Failed to publish configuration");
+			return -1;
+		}
+		domain->retired = retired;
+		domain->retiredCapacity = capacity;
+	}
+	ControlConfig* next = malloc(sizeof(*next));
+	if (next == NULL) {
+		perror("Failed to publish configuration");
+		return -1;
+	}
+	*next = *config;
+
+	ControlConfig* previous = atomic_load_explicit(&domain->current, memory_order_relaxed);
+	next->version = previous->version + 1;
+	atomic_store_explicit(&domain->current, next, memory_order_release);
+	// Um leitor que anuncie esta época (ou posterior) já não tem o ponteiro anterior
+	uint64_t epoch = atomic_fetch_add(&domain->epoch, 1) + 1;
+	domain->retired[domain->retiredCount++] = (RetiredConfig){ previous, epoch };
+	domain->published++;
+	configReclaim(domain);
+	return 0;
+}
+
+// Função para libertar tudo (os leitores já terminaram)
+void configDomainDestroy(ConfigDomain* domain) {
+	for (size_t i = 0; i < domain->retiredCount; i++) {
+		free(domain->retired[i].config);
+	}
+	free(domain->retired);
+	free(atomic_load(&domain->current));
+	domain->retired = NULL;
+	domain->retiredCount = 0;
+}
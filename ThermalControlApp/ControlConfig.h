@@ -0,0 +1,69 @@
+﻿// ControlConfig.h : Configuração do controlador (setpoint, ganhos, ritmo) partilhada por read-copy-update.
+//
+// Cada publicação cria uma ControlConfig nova e imutável e troca o ponteiro de forma atómica. Os leitores
+// (o ciclo de simulação) só carregam o ponteiro e, no fim de cada passo, anunciam um estado quiescente;
+// a versão antiga é libertada quando todos os leitores passaram por um estado quiescente depois da troca.
+
+#ifndef CONTROL_CONFIG_H
+#define CONTROL_CONFIG_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CONFIG_MAX_READERS 4
+#define CONFIG_READER_OFFLINE UINT64_MAX   // Leitor parado: não impede a libertação
+
+// Estrutura ControlConfig: nunca é alterada depois de publicada
+typedef struct {
+	float setpoint;
+	float Kp;
+	float Ki;
+	float Kd;
+	double timeWarp;            // Ritmo do ciclo: timeWarp / SIMULATION_DT passos por segundo (0 = sem limite)
+	bool thermalControlEnabled;
+	uint32_t version;           // Incrementada a cada publicação
+	uint32_t gainsVersion;      // Muda quando os ganhos mudam (o estado do PID é reposto)
+} ControlConfig;
+
+// Estrutura RetiredConfig: versão substituída à espera do fim do período de graça
+typedef struct {
+	ControlConfig* config;
+	uint64_t epoch;             // Época da troca; liberta-se quando todos os leitores a tiverem visto
+} RetiredConfig;
+
+// Estrutura ConfigDomain
+typedef struct {
+	_Atomic(ControlConfig*) current;
+	_Atomic uint64_t epoch;
+	_Atomic uint64_t readerEpochs[CONFIG_MAX_READERS];
+	size_t readerCount;
+	RetiredConfig* retired;     // Só usado pelo escritor
+	size_t retiredCount;
+	size_t retiredCapacity;
+	unsigned long published;
+	unsigned long reclaimed;
+} ConfigDomain;
+
+// Funções do escritor (um de cada vez)
+int configDomainInit(ConfigDomain* domain, const ControlConfig* initial, size_t readerCount);
+int configPublish(ConfigDomain* domain, const ControlConfig* config);
+void configReclaim(ConfigDomain* domain);
+void configDomainDestroy(ConfigDomain* domain);
+
+// Funções dos leitores: sem espera nem locks
+static inline const ControlConfig* configRead(ConfigDomain* domain) {
+	return atomic_load_explicit(&domain->current, memory_order_acquire);
+}
+
+// O leitor deixou de usar os ponteiros obtidos até aqui
+static inline void configQuiescent(ConfigDomain* domain, size_t reader) {
+	atomic_store(&domain->readerEpochs[reader], atomic_load(&domain->epoch));
+}
+
+static inline void configReaderOffline(ConfigDomain* domain, size_t reader) {
+	atomic_store(&domain->readerEpochs[reader], CONFIG_READER_OFFLINE);
+}
+
+#endif // CONTROL_CONFIG_H
@@ -0,0 +1,75 @@
+﻿// ControllerVariants.c : Cada variante é gerada a partir do mesmo corpo com os termos
+// fixados em compilação, pelo que os termos e testes não usados não existem no ciclo.
+
+#include "ControllerVariants.h"
+#include "PIDBatch.h"
+
+// Gera um kernel em lote; USE_INTEGRAL e USE_ANTIWINDUP são constantes literais,
+// o que elimina os ramos correspondentes mesmo sem otimização
+#define DEFINE_CONTROLLER_KERNEL(NAME, USE_INTEGRAL, USE_ANTIWINDUP)                                  \
+static void NAME(size_t count, const float* restrict error, const float* restrict temperature,        \
+	const float* restrict Kp, const float* restrict Ki, const float* restrict Kd,                     \
+	const uint8_t* restrict enabled, float* restrict previousError, float* restrict integral,         \
+	float* restrict output) {                                                                         \
+	(void)temperature; (void)Ki; (void)Kd; (void)previousError; (void)integral;                       \
+	for (size_t i = 0; i < count; i++) {                                                              \
+		bool active = enabled == NULL || enabled[i] != 0;                                             \
+		float e = error[i];                                                                           \
+		float out = Kp[i] * e;                                                                        \
+		if (USE_INTEGRAL) {                                                                           \
+			float accumulated = integral[i];                                                          \
+			if (USE_ANTIWINDUP && temperature[i] >= MAX_TEMPERATURE && e > 0) {                       \
+				accumulated = (accumulated > 0.0f) ? accumulated : 0.0f;                              \
+			}                                                                                         \
+			else if (USE_ANTIWINDUP && temperature[i] <= MIN_TEMPERATURE && e < 0) {                  \
+				accumulated = (accumulated < 0.0f) ? accumulated : 0.0f;                              \
+			}                                                                                         \
+			else {                                                                                    \
+				accumulated += e;                                                                     \
+			}                                                                                         \
+			out += Ki[i] * accumulated;                                                               \
+			integral[i] = active ? accumulated : integral[i];                                         \
+		}                                                                                             \
+		out = (out > MAX_OUTPUT) ? MAX_OUTPUT : ((out < MIN_OUTPUT) ? MIN_OUTPUT : out);              \
+		output[i] = active ? out : 0.0f;                                                              \
+	}                                                                                                 \
+}
+
+DEFINE_CONTROLLER_KERNEL(controllerKernelP, 0, 0)
+DEFINE_CONTROLLER_KERNEL(controllerKernelPI, 1, 0)
+DEFINE_CONTROLLER_KERNEL(controllerKernelPIAntiWindup, 1, 1)
+
+// Tabela de despacho, indexada por ControllerKind
+static const ControllerKernel controllerKernels[CONTROLLER_KIND_COUNT] = {
+	controllerKernelP,
+	controllerKernelPI,
+	controllerKernelPIAntiWindup,
+	calculatePIDControlBatch
+};
+
+static const char* const controllerNames[CONTROLLER_KIND_COUNT] = {
+	"p",
+	"pi",
+	"pi-aw",
+	"pid"
+};
+
+// Função para obter o kernel de uma variante
+ControllerKernel controllerGetKernel(ControllerKind kind) {
+	return kind < CONTROLLER_KIND_COUNT ? controllerKernels[kind] : calculatePIDControlBatch;
+}
+
+const char* controllerKindName(ControllerKind kind) {
+	return kind < CONTROLLER_KIND_COUNT ? controllerNames[kind] : "pid";
+}
+
+// Função para converter um nome (p, pi, pi-aw, pid) numa variante
+int controllerKindFromName(const char* name, ControllerKind* kind) {
+	for (int i = 0; i < CONTROLLER_KIND_COUNT; i++) {
+		if (strcmp(name, controllerNames[i]) == 0) {
+			*kind = (ControllerKind)i;
+			return 0;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,28 @@
+﻿// ControllerVariants.h : Variantes de controlador (P, PI, PID, PI com anti-windup) especializadas em compilação.
+
+#ifndef CONTROLLER_VARIANTS_H
+#define CONTROLLER_VARIANTS_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+
+// Tipos de controlador; a escolha é feita uma vez por grupo de zonas
+typedef enum {
+	CONTROLLER_P,
+	CONTROLLER_PI,
+	CONTROLLER_PI_ANTIWINDUP,
+	CONTROLLER_PID,            // Lei completa de calculatePIDControl() (kernel vetorizado)
+	CONTROLLER_KIND_COUNT
+} ControllerKind;
+
+// Kernel em lote com a mesma assinatura de calculatePIDControlBatch()
+typedef void (*ControllerKernel)(size_t count, const float* error, const float* temperature,
+	const float* Kp, const float* Ki, const float* Kd, const uint8_t* enabled,
+	float* previousError, float* integral, float* output);
+
+// Funções das variantes de controlador
+ControllerKernel controllerGetKernel(ControllerKind kind);
+const char* controllerKindName(ControllerKind kind);
+int controllerKindFromName(const char* name, ControllerKind* kind);
+
+#endif // CONTROLLER_VARIANTS_H
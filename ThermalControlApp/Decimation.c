@@ -0,0 +1,488 @@
+﻿// Decimation.c : Cada nível só soma os pontos completos do nível de baixo, por isso acrescentar uma
+// amostra custa O(1) amortizado. Mínimo e máximo são exatos; a média usa somas em double.
+
+#include "Decimation.h"
+#include <sys/stat.h>
+
+uint32_t decimationLevelFactor(int level) {
+	uint32_t factor = DECIMATION_FACTOR;
+	for (int l = 0; l < level; l++) {
+		factor *= DECIMATION_FACTOR;
+	}
+	return factor;
+}
+
+static void resetAccumulator(DecimationAccumulator* accumulator) {
+	memset(accumulator, 0, sizeof(*accumulator));
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		accumulator->point.minimum[s] = INFINITY;
+		accumulator->point.maximum[s] = -INFINITY;
+	}
+}
+
+void decimationInit(DecimationPyramid* pyramid) {
+	memset(pyramid, 0, sizeof(*pyramid));
+	for (int l = 0; l < DECIMATION_LEVELS; l++) {
+		resetAccumulator(&pyramid->pending[l]);
+	}
+}
+
+void decimationFree(DecimationPyramid* pyramid) {
+	for (int l = 0; l < DECIMATION_LEVELS; l++) {
+		free(pyramid->points[l]);
+		pyramid->points[l] = NULL;
+	}
+}
+
+// Função para somar um intervalo (amostra ou ponto completo) ao ponto em construção
+static void accumulate(DecimationAccumulator* accumulator, int64_t firstTimestamp, int64_t lastTimestamp,
+	uint64_t offset, uint32_t count, const float* minimum, const float* maximum, const double* sum,
+	const double* heaterSum) {
+	DecimationPoint* point = &accumulator->point;
+	if (point->count == 0) {
+		point->firstTimestamp = firstTimestamp;
+		point->offset = offset;
+	}
+	point->lastTimestamp = lastTimestamp;
+	point->count += count;
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		point->minimum[s] = minimum[s] < point->minimum[s] ? minimum[s] : point->minimum[s];
+		point->maximum[s] = maximum[s] > point->maximum[s] ? maximum[s] : point->maximum[s];
+		accumulator->sum[s] += sum[s];
+		accumulator->heaterSum[s] += heaterSum[s];
+	}
+	accumulator->children++;
+}
+
+// Função para guardar um ponto completo: no fim do .pyr em acréscimo, senão na memória
+static int storePoint(DecimationPyramid* pyramid, const DecimationPoint* point) {
+	uint32_t level = point->level;
+	if (pyramid->file != NULL) {
+		if (fwrite(point, sizeof(*point), 1, pyramid->file) != 1) {
+			perror("Failed to append decimation point");
+			return -1;
+		}
+		pyramid->pointCount[level]++;
+		return 0;
+	}
+	if (pyramid->pointCount[level] == pyramid->capacity[level]) {
+		size_t capacity = pyramid->capacity[level] > 0 ? pyramid->capacity[level] * 2 : 256;
+		DecimationPoint* points = realloc(pyramid->points[level], capacity * sizeof(*points));
+		if (points == NULL) {
+			perror("Failed to grow decimation level");
+			return -1;
+		}
+		pyramid->points[level] = points;
+		pyramid->capacity[level] = capacity;
+	}
+	pyramid->points[level][pyramid->pointCount[level]++] = *point;
+	return 0;
+}
+
+// Função para fechar o ponto de um nível e somá-lo ao nível de cima
+static int emit(DecimationPyramid* pyramid, int level) {
+	DecimationAccumulator* accumulator = &pyramid->pending[level];
+	DecimationPoint* point = &accumulator->point;
+	point->level = (uint32_t)level;
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		point->mean[s] = (float)(accumulator->sum[s] / point->count);
+		point->heaterDuty[s] = (float)(accumulator->heaterSum[s] / point->count);
+	}
+	if (storePoint(pyramid, point) != 0) {
+		return -1;
+	}
+
+	if (level + 1 < DECIMATION_LEVELS) {
+		accumulate(&pyramid->pending[level + 1], point->firstTimestamp, point->lastTimestamp, point->offset,
+			point->count, point->minimum, point->maximum, accumulator->sum, accumulator->heaterSum);
+	}
+	resetAccumulator(accumulator);
+	return 0;
+}
+
+// Função para acrescentar uma amostra; as linhas de erro não têm temperaturas e são ignoradas
+int decimationAdd(DecimationPyramid* pyramid, const TelemetryRecord* record, uint64_t offset) {
+	if (record->error) {
+		return 0;
+	}
+	double sum[STORE_SENSORS], heaterSum[STORE_SENSORS];
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		sum[s] = record->temperatures[s];
+		heaterSum[s] = (record->heaters >> s) & 1;
+	}
+	accumulate(&pyramid->pending[0], record->timestamp, record->timestamp, offset, 1, record->temperatures,
+		record->temperatures, sum, heaterSum);
+	pyramid->sampleCount++;
+
+	for (int l = 0; l < DECIMATION_LEVELS && pyramid->pending[l].children == DECIMATION_FACTOR; l++) {
+		if (emit(pyramid, l) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// Função para fechar os pontos incompletos do fim (de baixo para cima), só para mostrar a pirâmide em memória
+int decimationFinish(DecimationPyramid* pyramid) {
+	for (int l = 0; l < DECIMATION_LEVELS; l++) {
+		if (pyramid->pending[l].children > 0 && emit(pyramid, l) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int addCsvRecord(const TelemetryRecord* record, uint64_t offset, void* context) {
+	return decimationAdd(context, record, offset);
+}
+
+static char* sidecarPath(const char* sourcePath) {
+	char* path = malloc(strlen(sourcePath) + sizeof(DECIMATION_SUFFIX));
+	if (path != NULL) {
+		sprintf(path, "%s%s", sourcePath, DECIMATION_SUFFIX);
+	}
+	return path;
+}
+
+static void fillHeader(const DecimationPyramid* pyramid, uint64_t sourceSize, DecimationHeader* header) {
+	memset(header, 0, sizeof(*header));
+	header->magic = DECIMATION_MAGIC;
+	header->version = DECIMATION_VERSION;
+	header->levelCount = DECIMATION_LEVELS;
+	header->factor = DECIMATION_FACTOR;
+	header->sampleCount = pyramid->sampleCount;
+	header->sourceSize = sourceSize;
+	for (int l = 0; l < DECIMATION_LEVELS; l++) {
+		header->pointCounts[l] = pyramid->pointCount[l];
+		header->pending[l] = pyramid->pending[l];
+	}
+}
+
+// Função para ler e validar o cabeçalho do .pyr contra o tamanho atual da origem
+static bool readHeader(FILE* file, uint64_t sourceSize, DecimationHeader* header) {
+	bool valid = fread(header, sizeof(*header), 1, file) == 1 && header->magic == DECIMATION_MAGIC &&
+		header->version == DECIMATION_VERSION && header->levelCount == DECIMATION_LEVELS &&
+		header->factor == DECIMATION_FACTOR && header->sourceSize == sourceSize;
+	for (int l = 0; l < DECIMATION_LEVELS && valid; l++) {
+		// Cada nível tem no máximo um ponto completo por cada DECIMATION_FACTOR^(l+1) amostras
+		valid = header->pointCounts[l] <= header->sampleCount / decimationLevelFactor(l) &&
+			header->pending[l].children < DECIMATION_FACTOR;
+	}
+	return valid;
+}
+
+static uint64_t storedPoints(const DecimationHeader* header) {
+	uint64_t total = 0;
+	for (int l = 0; l < DECIMATION_LEVELS; l++) {
+		total += header->pointCounts[l];
+	}
+	return total;
+}
+
+// Função para gravar de uma vez uma pirâmide feita em memória, com os pontos incompletos no cabeçalho
+int decimationSave(const DecimationPyramid* pyramid, const char* sourcePath, uint64_t sourceSize) {
+	char* path = sidecarPath(sourcePath);
+	FILE* file = path != NULL ? fopen(path, "wb") : NULL;
+	if (file == NULL) {
+		perror("Failed to create decimation pyramid");
+		free(path);
+		return -1;
+	}
+	DecimationHeader header;
+	fillHeader(pyramid, sourceSize, &header);
+	int result = fwrite(&header, sizeof(header), 1, file) == 1 ? 0 : -1;
+	for (int l = 0; l < DECIMATION_LEVELS && result == 0; l++) {
+		if (fwrite(pyramid->points[l], sizeof(DecimationPoint), pyramid->pointCount[l], file) != pyramid->pointCount[l]) {
+			result = -1;
+		}
+	}
+	if (fclose(file) != 0 || result != 0) {
+		perror(path);
+		result = -1;
+	}
+	free(path);
+	return result;
+}
+
+// Função para carregar a pirâmide em memória; falha se faltar ou não corresponder à origem
+int decimationLoad(DecimationPyramid* pyramid, const char* sourcePath, uint64_t sourceSize) {
+	decimationInit(pyramid);
+	char* path = sidecarPath(sourcePath);
+	FILE* file = path != NULL ? fopen(path, "rb") : NULL;
+	free(path);
+	if (file == NULL) {
+		return -1;
+	}
+	DecimationHeader header;
+	bool valid = readHeader(file, sourceSize, &header);
+	for (int l = 0; l < DECIMATION_LEVELS && valid; l++) {
+		pyramid->capacity[l] = (size_t)header.pointCounts[l] + 1;
+		pyramid->points[l] = malloc(pyramid->capacity[l] * sizeof(DecimationPoint));
+		valid = pyramid->points[l] != NULL;
+	}
+	// Os níveis vêm intercalados, pela ordem em que os pontos fecharam
+	uint64_t total = valid ? storedPoints(&header) : 0;
+	for (uint64_t i = 0; i < total && valid; i++) {
+		DecimationPoint point;
+		valid = fread(&point, sizeof(point), 1, file) == 1 && point.level < DECIMATION_LEVELS &&
+			pyramid->pointCount[point.level] < header.pointCounts[point.level];
+		if (valid) {
+			pyramid->points[point.level][pyramid->pointCount[point.level]++] = point;
+		}
+	}
+	fclose(file);
+	if (!valid) {
+		decimationFree(pyramid);
+		decimationInit(pyramid);
+		return -1;
+	}
+	memcpy(pyramid->pending, header.pending, sizeof(pyramid->pending));
+	pyramid->sampleCount = header.sampleCount;
+	return 0;
+}
+
+// Função para continuar a pirâmide do CSV do registo em acréscimo; se faltar ou não corresponder ao CSV
+// (csvSize bytes já escritos) é refeita a partir dele
+int decimationOpenLog(DecimationPyramid* pyramid, const char* csvPath, uint64_t csvSize) {
+	decimationInit(pyramid);
+	char* path = sidecarPath(csvPath);
+	if (path == NULL) {
+		return -1;
+	}
+	FILE* file = fopen(path, "r+b");
+	DecimationHeader header;
+	if (file != NULL && readHeader(file, csvSize, &header)) {
+		// Pontos escritos depois da última sincronização não contam: são cortados e voltam a ser escritos
+		off_t end = (off_t)(sizeof(header) + storedPoints(&header) * sizeof(DecimationPoint));
+		if (ftruncate(fileno(file), end) == 0 && fseeko(file, end, SEEK_SET) == 0) {
+			memcpy(pyramid->pending, header.pending, sizeof(pyramid->pending));
+			for (int l = 0; l < DECIMATION_LEVELS; l++) {
+				pyramid->pointCount[l] = (size_t)header.pointCounts[l];
+			}
+			pyramid->sampleCount = header.sampleCount;
+			pyramid->file = file;
+			free(path);
+			return 0;
+		}
+	}
+	if (file != NULL) {
+		fprintf(stderr, "Decimation pyramid %s stale, rebuilding\n", path);
+		fclose(file);
+	}
+
+	pyramid->file = fopen(path, "w+b");
+	if (pyramid->file == NULL) {
+		perror(path);
+		free(path);
+		return -1;
+	}
+	free(path);
+	fillHeader(pyramid, 0, &header);
+	if (fwrite(&header, sizeof(header), 1, pyramid->file) != 1 ||
+		telemetryStoreScanCsv(csvPath, 0, csvSize, addCsvRecord, pyramid) != 0 || decimationSync(pyramid, csvSize) != 0) {
+		decimationClose(pyramid);
+		return -1;
+	}
+	return 0;
+}
+
+// Função para reescrever o cabeçalho depois dos pontos acrescentados; a origem já tem de ter sourceSize bytes
+int decimationSync(DecimationPyramid* pyramid, uint64_t sourceSize) {
+	DecimationHeader header;
+	fillHeader(pyramid, sourceSize, &header);
+	// fseek escreve primeiro os pontos do buffer, por isso o cabeçalho nunca conta pontos que faltam
+	if (fseek(pyramid->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, pyramid->file) != 1 ||
+		fflush(pyramid->file) != 0 || fseek(pyramid->file, 0, SEEK_END) != 0) {
+		perror("Failed to update decimation pyramid");
+		return -1;
+	}
+	return 0;
+}
+
+void decimationClose(DecimationPyramid* pyramid) {
+	if (pyramid->file != NULL) {
+		fclose(pyramid->file);
+		pyramid->file = NULL;
+	}
+	decimationFree(pyramid);
+}
+
+// Função para refazer a pirâmide a partir dos blocos do ficheiro colunar
+static int rebuildFromStore(DecimationPyramid* pyramid, const TelemetryStoreReader* reader) {
+	TelemetryBlock* block = malloc(sizeof(*block));
+	if (block == NULL) {
+		return -1;
+	}
+	int result = 0;
+	uint64_t row = 0;
+	for (uint32_t b = 0; b < reader->header.blockCount && result == 0; b++) {
+		result = telemetryStoreReadBlock(reader, b, block);
+		for (uint32_t i = 0; i < block->rowCount && result == 0; i++) {
+			TelemetryRecord record = { block->timestamps[i], block->errors[i],
+				{ block->temperatures[0][i], block->temperatures[1][i], block->temperatures[2][i], block->temperatures[3][i] },
+				block->heaters[i], NULL, NULL };
+			result = decimationAdd(pyramid, &record, row++);
+		}
+	}
+	free(block);
+	return result;
+}
+
+// Função para carregar a pirâmide; se faltar ou não corresponder à origem é refeita (dos blocos do ficheiro
+// colunar ou do CSV) e gravada
+static int loadPyramid(DecimationPyramid* pyramid, const char* path, uint64_t size, const TelemetryStoreReader* reader) {
+	if (decimationLoad(pyramid, path, size) == 0) {
+		return 0;
+	}
+	fprintf(stderr, "Decimation pyramid %s%s missing or stale, rebuilding\n", path, DECIMATION_SUFFIX);
+	decimationInit(pyramid);
+	int result = reader != NULL ? rebuildFromStore(pyramid, reader) : telemetryStoreScanCsv(path, 0, size, addCsvRecord, pyramid);
+	if (result == 0) {
+		decimationSave(pyramid, path, size); // Para a próxima vez; sem permissão de escrita continua em memória
+	}
+	return result;
+}
+
+// Função para verificar se o ficheiro é colunar (senão é lido como data.csv, do TSL ou do --log)
+static bool isStoreFile(const char* path) {
+	FILE* file = fopen(path, "rb");
+	uint32_t magic = 0;
+	if (file != NULL) {
+		if (fread(&magic, sizeof(magic), 1, file) != 1) {
+			magic = 0;
+		}
+		fclose(file);
+	}
+	return magic == STORE_MAGIC;
+}
+
+// Função para encontrar o primeiro ponto de um nível que termina depois de from
+static size_t firstPoint(const DecimationPoint* points, size_t count, int64_t from) {
+	size_t low = 0, high = count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (points[middle].lastTimestamp < from) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+static void printSample(int64_t time, float value, bool heaterOn) {
+	char timestamp[STORE_TIMESTAMP_LENGTH + 1];
+	telemetryStoreFormatTimestamp(timestamp, time);
+	printf("%s, 1, %f, %f, %f, %.3f\n", timestamp, value, value, value, heaterOn ? 1.0 : 0.0);
+}
+
+static void printRawPoint(const TelemetryBlock* block, uint32_t row, void* context) {
+	int sensor = *(const int*)context;
+	printSample(block->timestamps[row], block->temperatures[sensor][row], (block->heaters[row] >> sensor) & 1);
+}
+
+// Estrutura RawCsvRange: filtro das linhas do CSV na vista sem resumo
+typedef struct {
+	int sensor;
+	int64_t from;
+	int64_t to;
+} RawCsvRange;
+
+static int printCsvPoint(const TelemetryRecord* record, uint64_t offset, void* context) {
+	const RawCsvRange* range = context;
+	(void)offset;
+	if (!record->error && record->timestamp >= range->from && record->timestamp <= range->to) {
+		printSample(record->timestamp, record->temperatures[range->sensor], (record->heaters >> range->sensor) & 1);
+	}
+	return 0;
+}
+
+// Função da vista resumida (--plot): escolhe o nível mais fino com no máximo maxPoints pontos no intervalo
+int runDecimatedView(const char* path, const TelemetryQuery* query, size_t maxPoints) {
+	// O ficheiro colunar tem o índice de blocos para as linhas; no CSV lê-se só entre os pontos de 16x do intervalo
+	bool store = isStoreFile(path);
+	TelemetryDataset dataset;
+	uint64_t size;
+	if (store) {
+		if (telemetryDatasetOpen(&dataset, path) != 0) {
+			return EXIT_FAILURE;
+		}
+		size = dataset.reader.size;
+	}
+	else {
+		struct stat info;
+		if (stat(path, &info) != 0) {
+			perror(path);
+			return EXIT_FAILURE;
+		}
+		size = (uint64_t)info.st_size;
+	}
+	DecimationPyramid pyramid;
+	if (loadPyramid(&pyramid, path, size, store ? &dataset.reader : NULL) != 0 || decimationFinish(&pyramid) != 0) {
+		decimationFree(&pyramid);
+		if (store) {
+			telemetryDatasetClose(&dataset);
+		}
+		return EXIT_FAILURE;
+	}
+
+	int sensor = query->sensor < 0 ? 0 : query->sensor;
+	size_t begin[DECIMATION_LEVELS], end[DECIMATION_LEVELS];
+	uint64_t samples = 0;
+	for (int l = 0; l < DECIMATION_LEVELS; l++) {
+		begin[l] = firstPoint(pyramid.points[l], pyramid.pointCount[l], query->from);
+		end[l] = begin[l];
+		while (end[l] < pyramid.pointCount[l] && pyramid.points[l][end[l]].firstTimestamp <= query->to) {
+			if (l == 0) {
+				samples += pyramid.points[l][end[l]].count;
+			}
+			end[l]++;
+		}
+	}
+
+	int result = EXIT_SUCCESS;
+	printf("TIMESTAMP, SAMPLES, MIN, MEAN, MAX, HTR-%d DUTY\n", sensor + 1);
+	if (samples <= maxPoints) {
+		// Poucas amostras: as próprias linhas
+		if (store) {
+			TelemetryQuery raw = *query;
+			raw.environment = NULL;
+			TelemetryQueryStats stats;
+			if (telemetryQueryRange(&dataset, &raw, printRawPoint, &sensor, &stats) != 0) {
+				result = EXIT_FAILURE;
+			}
+			fprintf(stderr, "Level 1x: about %llu samples (%u blocks decoded)\n", (unsigned long long)samples, stats.decoded);
+		}
+		else {
+			uint64_t from = begin[0] < pyramid.pointCount[0] ? pyramid.points[0][begin[0]].offset : size;
+			uint64_t to = end[0] < pyramid.pointCount[0] ? pyramid.points[0][end[0]].offset : size;
+			RawCsvRange range = { sensor, query->from, query->to };
+			if (telemetryStoreScanCsv(path, from, to, printCsvPoint, &range) != 0) {
+				result = EXIT_FAILURE;
+			}
+			fprintf(stderr, "Level 1x: about %llu samples (%llu CSV bytes read)\n", (unsigned long long)samples,
+				(unsigned long long)(to - from));
+		}
+	}
+	else {
+		int level = 0;
+		while (level + 1 < DECIMATION_LEVELS && end[level] - begin[level] > maxPoints) {
+			level++;
+		}
+		for (size_t i = begin[level]; i < end[level]; i++) {
+			const DecimationPoint* point = &pyramid.points[level][i];
+			char timestamp[STORE_TIMESTAMP_LENGTH + 1];
+			telemetryStoreFormatTimestamp(timestamp, point->firstTimestamp);
+			printf("%s, %u, %f, %f, %f, %.3f\n", timestamp, point->count, point->minimum[sensor], point->mean[sensor],
+				point->maximum[sensor], point->heaterDuty[sensor]);
+		}
+		fprintf(stderr, "Level %ux: %zu points for %llu samples\n", decimationLevelFactor(level),
+			end[level] - begin[level], (unsigned long long)samples);
+	}
+	decimationFree(&pyramid);
+	if (store) {
+		telemetryDatasetClose(&dataset);
+	}
+	return result;
+}
@@ -0,0 +1,83 @@
+﻿// Decimation.h : Pirâmide de resumos min/máx/média da telemetria para desenhar períodos longos.
+//
+// Nível 0 resume 16 amostras, o nível 1 256 e o nível 2 4096 (as amostras em si são o nível 1x do ficheiro
+// de origem). A pirâmide é atualizada amostra a amostra e gravada ao lado do ficheiro (<ficheiro>.pyr), seja
+// ele o ficheiro colunar (--store-import) ou o CSV do registo (--log).
+//
+// O .pyr é um DecimationHeader seguido dos pontos completos pela ordem em que fecham, com os níveis
+// intercalados. O cabeçalho guarda os pontos ainda incompletos e o tamanho da origem, por isso o registo
+// continua a pirâmide só acrescentando pontos e reescrevendo o cabeçalho.
+
+#ifndef DECIMATION_H
+#define DECIMATION_H
+
+#include "TelemetryQuery.h"
+
+#define DECIMATION_FACTOR 16
+#define DECIMATION_LEVELS 3         // 16x, 256x, 4096x
+#define DECIMATION_MAGIC 0x50435453u    // "STCP"
+#define DECIMATION_VERSION 2
+#define DECIMATION_SUFFIX ".pyr"
+
+// Estrutura DecimationPoint: resumo de um intervalo de amostras
+typedef struct {
+	int64_t firstTimestamp;
+	int64_t lastTimestamp;
+	uint64_t offset;                // Primeira amostra na origem: byte da linha no CSV, linha no ficheiro colunar
+	uint32_t count;                 // Amostras resumidas (menos de DECIMATION_FACTOR^(nível+1) só no fim)
+	uint32_t level;
+	float minimum[STORE_SENSORS];
+	float maximum[STORE_SENSORS];
+	float mean[STORE_SENSORS];
+	float heaterDuty[STORE_SENSORS];    // Fração das amostras com o aquecedor ligado
+} DecimationPoint;
+
+// Estrutura DecimationAccumulator: ponto ainda incompleto de um nível
+typedef struct {
+	DecimationPoint point;
+	double sum[STORE_SENSORS];
+	double heaterSum[STORE_SENSORS];
+	uint32_t children;              // Amostras ou pontos do nível de baixo já somados
+	uint32_t reserved;
+} DecimationAccumulator;
+
+// Estrutura DecimationHeader: início do ficheiro .pyr (reescrito a cada sincronização)
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t levelCount;
+	uint32_t factor;
+	uint32_t reserved;
+	uint64_t sampleCount;
+	uint64_t sourceSize;            // Bytes da origem já resumidos; outro tamanho torna a pirâmide obsoleta
+	uint64_t pointCounts[DECIMATION_LEVELS];
+	DecimationAccumulator pending[DECIMATION_LEVELS];
+} DecimationHeader;
+
+// Estrutura DecimationPyramid
+typedef struct {
+	DecimationAccumulator pending[DECIMATION_LEVELS];
+	DecimationPoint* points[DECIMATION_LEVELS];
+	size_t pointCount[DECIMATION_LEVELS];
+	size_t capacity[DECIMATION_LEVELS];
+	uint64_t sampleCount;
+	FILE* file;                     // Em acréscimo (decimationOpenLog) os pontos vão para o .pyr e não para a memória
+} DecimationPyramid;
+
+// Funções da pirâmide
+void decimationInit(DecimationPyramid* pyramid);
+void decimationFree(DecimationPyramid* pyramid);
+int decimationAdd(DecimationPyramid* pyramid, const TelemetryRecord* record, uint64_t offset);
+int decimationFinish(DecimationPyramid* pyramid);
+int decimationSave(const DecimationPyramid* pyramid, const char* sourcePath, uint64_t sourceSize);
+int decimationLoad(DecimationPyramid* pyramid, const char* sourcePath, uint64_t sourceSize);
+uint32_t decimationLevelFactor(int level);
+
+// Funções da pirâmide do registo CSV, continuada entre execuções
+int decimationOpenLog(DecimationPyramid* pyramid, const char* csvPath, uint64_t csvSize);
+int decimationSync(DecimationPyramid* pyramid, uint64_t sourceSize);
+void decimationClose(DecimationPyramid* pyramid);
+
+int runDecimatedView(const char* path, const TelemetryQuery* query, size_t maxPoints);
+
+#endif // DECIMATION_H
@@ -0,0 +1,191 @@
+﻿// EventLoop.c : Ciclo de eventos sobre epoll com temporizadores timerfd.
+
+#include "EventLoop.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <sys/timerfd.h>
+
+// Função para inicializar um ciclo vazio
+int eventLoopInit(EventLoop* loop) {
+	memset(loop, 0, sizeof(*loop));
+	atomic_init(&loop->running, true); // Um eventLoopStop antes de eventLoopRun não se perde
+	loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (loop->epollFd == -1) {
+		perror("Failed to create epoll instance");
+		return -1;
+	}
+	return 0;
+}
+
+// Função para fechar o ciclo (os descritores registados pertencem a quem os registou)
+void eventLoopClose(EventLoop* loop) {
+	if (loop->epollFd != -1) {
+		close(loop->epollFd);
+	}
+	loop->epollFd = -1;
+	atomic_store(&loop->running, false);
+}
+
+// Função para procurar o handler de um descritor
+static EventHandler* findHandler(EventLoop* loop, int fd) {
+	for (int i = 0; i < EVENT_LOOP_MAX_HANDLERS; i++) {
+		if (loop->handlers[i].active && loop->handlers[i].fd == fd) {
+			return &loop->handlers[i];
+		}
+	}
+	return NULL;
+}
+
+// Função para registar um descritor no ciclo
+int eventLoopAdd(EventLoop* loop, int fd, uint32_t events, EventCallback callback, void* context) {
+	EventHandler* handler = NULL;
+	for (int i = 0; i < EVENT_LOOP_MAX_HANDLERS; i++) {
+		if (!loop->handlers[i].active) {
+			handler = &loop->handlers[i];
+			break;
+		}
+	}
+	if (handler == NULL) {
+		fprintf(stderr, "Event loop is full\n");
+		return -1;
+	}
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.ptr = handler;
+	if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+		perror("Failed to add descriptor to event loop");
+		return -1;
+	}
+
+	handler->fd = fd;
+	handler->callback = callback;
+	handler->context = context;
+	handler->active = true;
+	return 0;
+}
+
+// Função para alterar os eventos pedidos para um descritor
+int eventLoopModify(EventLoop* loop, int fd, uint32_t events) {
+	EventHandler* handler = findHandler(loop, fd);
+	if (handler == NULL) {
+		return -1;
+	}
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.ptr = handler;
+	return epoll_ctl(loop->epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
+// Função para retirar um descritor do ciclo
+int eventLoopRemove(EventLoop* loop, int fd) {
+	EventHandler* handler = findHandler(loop, fd);
+	if (handler == NULL) {
+		return -1;
+	}
+	handler->active = false;
+	return epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+// Função para definir o trabalho contínuo; com idle definido o ciclo não bloqueia
+void eventLoopSetIdle(EventLoop* loop, EventIdleCallback idle, void* context) {
+	loop->idle = idle;
+	loop->idleContext = context;
+}
+
+// Função para esperar e tratar um lote de eventos
+int eventLoopRunOnce(EventLoop* loop, int timeoutMs) {
+	struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+	int count = epoll_wait(loop->epollFd, events, EVENT_LOOP_MAX_EVENTS, loop->idle != NULL ? 0 : timeoutMs);
+	if (count == -1) {
+		if (errno == EINTR) {
+			return 0;
+		}
+		perror("Failed to wait for events");
+		return -1;
+	}
+
+	for (int i = 0; i < count; i++) {
+		EventHandler* handler = (EventHandler*)events[i].data.ptr;
+		// Um callback anterior pode ter retirado este descritor
+		if (handler->active) {
+			handler->callback(handler->fd, events[i].events, handler->context);
+		}
+	}
+
+	if (loop->idle != NULL) {
+		loop->idle(loop->idleContext);
+	}
+	return count;
+}
+
+// Função para correr o ciclo até eventLoopStop()
+int eventLoopRun(EventLoop* loop) {
+	while (atomic_load_explicit(&loop->running, memory_order_acquire)) {
+		if (eventLoopRunOnce(loop, -1) == -1) {
+			atomic_store_explicit(&loop->running, false, memory_order_release);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void eventLoopStop(EventLoop* loop) {
+	atomic_store_explicit(&loop->running, false, memory_order_release);
+}
+
+// Função para criar um temporizador monotónico não bloqueante
+int eventTimerCreate() {
+	int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timerFd == -1) {
+		perror("Failed to create timer");
+	}
+	return timerFd;
+}
+
+// Função para armar um temporizador periódico (período 0 desarma)
+int eventTimerSetPeriod(int timerFd, double periodSeconds) {
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	if (periodSeconds > 0.0) {
+		long nanoseconds = (long)(periodSeconds * 1e9);
+		spec.it_interval.tv_sec = nanoseconds / 1000000000L;
+		spec.it_interval.tv_nsec = nanoseconds % 1000000000L;
+		if (spec.it_interval.tv_sec == 0 && spec.it_interval.tv_nsec == 0) {
+			spec.it_interval.tv_nsec = 1;
+		}
+		spec.it_value = spec.it_interval;
+	}
+	return timerfd_settime(timerFd, 0, &spec, NULL);
+}
+
+// Função para ler o número de expirações desde a última leitura (0 se nenhuma)
+uint64_t eventTimerRead(int timerFd) {
+	uint64_t expirations = 0;
+	if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+		return 0;
+	}
+	return expirations;
+}
+
+// Função para obter há quanto tempo (ns) expirou o prazo mais antigo das expirações lidas (-1 sem período)
+int64_t eventTimerLateness(int timerFd, uint64_t expirations) {
+	struct itimerspec spec;
+	if (expirations == 0 || timerfd_gettime(timerFd, &spec) != 0) {
+		return -1;
+	}
+	int64_t period = (int64_t)spec.it_interval.tv_sec * 1000000000LL + spec.it_interval.tv_nsec;
+	int64_t remaining = (int64_t)spec.it_value.tv_sec * 1000000000LL + spec.it_value.tv_nsec;
+	if (period == 0) {
+		return -1;
+	}
+	// O último prazo foi há (period - remaining); cada expiração anterior está um período mais atrás
+	return (int64_t)(expirations - 1) * period + (period - remaining);
+}
+
+#endif // __linux__
@@ -0,0 +1,59 @@
+﻿// EventLoop.h : Ciclo de eventos único (epoll) para temporizadores, stdin e pipes.
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "ThermalControlApp.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+
+#define EVENT_LOOP_MAX_HANDLERS 64   // Descritores registados por ciclo
+#define EVENT_LOOP_MAX_EVENTS 32     // Eventos tratados por chamada a epoll_wait
+
+// Função chamada quando um descritor fica pronto (events = EPOLLIN, EPOLLOUT, ...)
+typedef void (*EventCallback)(int fd, uint32_t events, void* context);
+
+// Função chamada em cada volta do ciclo quando há trabalho contínuo (ex.: simulação sem limite)
+typedef void (*EventIdleCallback)(void* context);
+
+// Estrutura EventHandler
+typedef struct {
+	int fd;
+	EventCallback callback;
+	void* context;
+	bool active;
+} EventHandler;
+
+// Estrutura EventLoop: cada instância é independente, pelo que um processo pode ter vários ciclos
+typedef struct {
+	int epollFd;
+	_Atomic bool running;       // eventLoopStop pode ser chamado por outra thread (consola com --rt)
+	EventHandler handlers[EVENT_LOOP_MAX_HANDLERS];
+	EventIdleCallback idle;
+	void* idleContext;
+} EventLoop;
+
+// Funções do ciclo de eventos
+int eventLoopInit(EventLoop* loop);
+void eventLoopClose(EventLoop* loop);
+int eventLoopAdd(EventLoop* loop, int fd, uint32_t events, EventCallback callback, void* context);
+int eventLoopModify(EventLoop* loop, int fd, uint32_t events);
+int eventLoopRemove(EventLoop* loop, int fd);
+void eventLoopSetIdle(EventLoop* loop, EventIdleCallback idle, void* context);
+int eventLoopRunOnce(EventLoop* loop, int timeoutMs);
+int eventLoopRun(EventLoop* loop);
+void eventLoopStop(EventLoop* loop);
+
+// Funções dos temporizadores (timerfd)
+int eventTimerCreate();
+int eventTimerSetPeriod(int timerFd, double periodSeconds);
+uint64_t eventTimerRead(int timerFd);
+int64_t eventTimerLateness(int timerFd, uint64_t expirations);
+
+#endif // __linux__
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,137 @@
+﻿// FixedPointPID.c : Mesma lei de calculatePIDControl() só com aritmética inteira,
+// e comparação de exatidão com a versão em float.
+
+#include "FixedPointPID.h"
+#include "PIDBatch.h"
+#include "ZoneEngine.h"
+
+#define COMPARISON_SCENARIOS 51   // Temperaturas iniciais de MIN a MAX em passos de 1 °C
+
+// Limites em vírgula fixa, calculados uma vez
+#define FIXED_MAX_TEMPERATURE ((FixedPoint)(MAX_TEMPERATURE * FIXED_ONE))
+#define FIXED_MIN_TEMPERATURE ((FixedPoint)(MIN_TEMPERATURE * FIXED_ONE))
+#define FIXED_MAX_OUTPUT ((FixedPoint)(MAX_OUTPUT * FIXED_ONE))
+#define FIXED_MIN_OUTPUT ((FixedPoint)(MIN_OUTPUT * FIXED_ONE))
+
+// Função para converter os parâmetros de um PIDController
+void setPIDParametersQ(PIDControllerQ* pid, const PIDController* source) {
+	pid->Kp = fixedGainFromFloat(source->Kp);
+	pid->Ki = fixedGainFromFloat(source->Ki);
+	pid->Kd = fixedGainFromFloat(source->Kd);
+	pid->previousError = fixedToError(fixedFromFloat(source->previousError));
+	pid->integral = fixedFromFloat(source->integral);
+}
+
+// Função para calcular a saída PID em vírgula fixa
+FixedPoint calculatePIDControlQ(PIDControllerQ* pid, FixedPoint error, FixedPoint temperature) {
+	FixedPoint derivative = fixedSub(error, fixedFromError(pid->previousError));
+	pid->previousError = fixedToError(error);
+
+	// Anti-windup igual ao da versão em float; a soma satura em vez de dar a volta
+	if (temperature >= FIXED_MAX_TEMPERATURE && error > 0) {
+		pid->integral = pid->integral > 0 ? pid->integral : 0;
+	}
+	else if (temperature <= FIXED_MIN_TEMPERATURE && error < 0) {
+		pid->integral = pid->integral < 0 ? pid->integral : 0;
+	}
+	else {
+		pid->integral = fixedAdd(pid->integral, error);
+	}
+
+	FixedPoint output = fixedAdd(fixedAdd(fixedMulGain(pid->Kp, error), fixedMulGain(pid->Ki, pid->integral)),
+		fixedMulGain(pid->Kd, derivative));
+
+	if (output > FIXED_MAX_OUTPUT) {
+		output = FIXED_MAX_OUTPUT;
+	}
+	else if (output < FIXED_MIN_OUTPUT) {
+		output = FIXED_MIN_OUTPUT;
+	}
+	return output;
+}
+
+// Função para comparar as duas versões lado a lado:
+// - em malha aberta, o controlador Q recebe exatamente as mesmas entradas que o float;
+// - em malha fechada, cada versão controla a sua própria planta.
+int runFixedPointComparison(const PIDController* gains, float setpoint, long steps) {
+	double maxOutputError = 0.0;
+	double sumSquaredError = 0.0;
+	long samples = 0;
+	double maxTemperatureDivergence = 0.0;
+	double finalTemperatureDivergence = 0.0;
+
+	for (int scenario = 0; scenario < COMPARISON_SCENARIOS; scenario++) {
+		float initial = MIN_TEMPERATURE + (MAX_TEMPERATURE - MIN_TEMPERATURE) * scenario / (COMPARISON_SCENARIOS - 1);
+
+		PIDController floatPid = *gains;
+		floatPid.previousError = 0.0f;
+		floatPid.integral = 0.0f;
+		PIDControllerQ shadowPid;
+		PIDControllerQ closedPid;
+		setPIDParametersQ(&shadowPid, &floatPid);
+		setPIDParametersQ(&closedPid, &floatPid);
+
+		float temperature = initial;
+		float closedTemperature = initial;
+		for (long step = 0; step < steps; step++) {
+			// Malha aberta: mesmas entradas
+			float error = setpoint - temperature;
+			float output = pidControlStep(error, temperature, floatPid.Kp, floatPid.Ki, floatPid.Kd,
+				&floatPid.previousError, &floatPid.integral);
+			FixedPoint shadow = calculatePIDControlQ(&shadowPid, fixedFromFloat(error), fixedFromFloat(temperature));
+
+			double difference = fabs((double)fixedToFloat(shadow) - output);
+			maxOutputError = fmax(maxOutputError, difference);
+			sumSquaredError += difference * difference;
+			samples++;
+			temperature = zonePlantStep(temperature, output);
+
+			// Malha fechada: a planta do controlador Q evolui de forma independente
+			float closedError = setpoint - closedTemperature;
+			FixedPoint closedOutput = calculatePIDControlQ(&closedPid, fixedFromFloat(closedError), fixedFromFloat(closedTemperature));
+			closedTemperature = zonePlantStep(closedTemperature, fixedToFloat(closedOutput));
+			maxTemperatureDivergence = fmax(maxTemperatureDivergence, fabs((double)closedTemperature - temperature));
+		}
+		finalTemperatureDivergence = fmax(finalTemperatureDivergence, fabs((double)closedTemperature - temperature));
+	}
+
+	// Custo por chamada de cada versão com as mesmas entradas
+	const long iterations = 1000000;
+	PIDController floatPid = *gains;
+	PIDControllerQ fixedPid;
+	setPIDParametersQ(&fixedPid, gains);
+	volatile float floatSink = 0.0f;
+	volatile FixedPoint fixedSink = 0;
+	struct timespec start, middle, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < iterations; i++) {
+		float error = (float)((i % 200) - 100) * 0.05f;
+		floatSink = pidControlStep(error, 0.0f, floatPid.Kp, floatPid.Ki, floatPid.Kd, &floatPid.previousError, &floatPid.integral);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+	for (long i = 0; i < iterations; i++) {
+		FixedPoint error = (FixedPoint)((i % 200) - 100) * (FIXED_ONE / 20);
+		fixedSink = calculatePIDControlQ(&fixedPid, error, 0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	(void)floatSink;
+	(void)fixedSink;
+
+	double floatNs = ((double)(middle.tv_sec - start.tv_sec) * 1e9 + (double)(middle.tv_nsec - start.tv_nsec)) / iterations;
+	double fixedNs = ((double)(end.tv_sec - middle.tv_sec) * 1e9 + (double)(end.tv_nsec - middle.tv_nsec)) / iterations;
+
+	printf("Fixed-point format: Q%d.%d values (resolution %.6f), Q%d.%d gains, Q%d.%d stored error\n",
+		31 - PID_Q_FRACTION_BITS, PID_Q_FRACTION_BITS, 1.0 / FIXED_ONE, 16 - PID_Q_GAIN_FRACTION_BITS,
+		PID_Q_GAIN_FRACTION_BITS, 15 - PID_Q_ERROR_FRACTION_BITS, PID_Q_ERROR_FRACTION_BITS);
+	printf("Quantized gains: Kp=%.6f, Ki=%.6f, Kd=%.6f\n", fixedGainToFloat(fixedPid.Kp), fixedGainToFloat(fixedPid.Ki),
+		fixedGainToFloat(fixedPid.Kd));
+	printf("Scenarios: %d, Steps: %ld, Kp=%.2f, Ki=%.2f, Kd=%.2f, Setpoint: %.2f\n", COMPARISON_SCENARIOS, steps,
+		gains->Kp, gains->Ki, gains->Kd, setpoint);
+	printf("Open loop output error: max %.6f, RMS %.6f\n", maxOutputError, samples > 0 ? sqrt(sumSquaredError / samples) : 0.0);
+	printf("Closed loop temperature divergence: max %.6f, final %.6f\n", maxTemperatureDivergence, finalTemperatureDivergence);
+	printf("Cost per call: float %.1f ns, fixed %.1f ns\n", floatNs, fixedNs);
+	printf("State size: float %zu bytes, fixed %zu bytes (%zu vs %zu controllers per 64-byte cache line)\n",
+		sizeof(PIDController), sizeof(PIDControllerQ), 64 / sizeof(PIDController), 64 / sizeof(PIDControllerQ));
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+﻿// FixedPointPID.h : Controlador PID em vírgula fixa (formato Q configurável, Q15.16 por omissão).
+
+#ifndef FIXED_POINT_PID_H
+#define FIXED_POINT_PID_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+
+// Número de bits fracionários; pode ser redefinido na compilação (-DPID_Q_FRACTION_BITS=12)
+#ifndef PID_Q_FRACTION_BITS
+#define PID_Q_FRACTION_BITS 16
+#endif
+
+// O erro guardado é Q7.8, por isso são precisos pelo menos 8 bits; acima de 24, MAX_OUTPUT (100)
+// e os outros limites deixam de caber em 32 bits
+_Static_assert(PID_Q_FRACTION_BITS >= 8 && PID_Q_FRACTION_BITS <= 24, "PID_Q_FRACTION_BITS must be between 8 and 24");
+
+#define PID_Q_GAIN_FRACTION_BITS 12   // Ganhos em Q4.12 sem sinal: 0 a 16, resolução 0.00024
+#define PID_Q_ERROR_FRACTION_BITS 8   // Erro anterior em Q7.8: ±128 °C, resolução 0.0039 °C
+
+#define FIXED_ONE ((int32_t)1 << PID_Q_FRACTION_BITS)
+
+typedef int32_t FixedPoint;   // Valores de trabalho (erro, temperatura, integral, saída)
+typedef uint16_t FixedGain;
+typedef int16_t FixedError;
+
+// Estrutura PIDControllerQ: estado de PIDController em 12 bytes (5 por linha de cache de 64 bytes, contra 3)
+// Só a integral precisa de 32 bits; os ganhos e o erro anterior cabem em 16
+typedef struct {
+	FixedPoint integral;
+	FixedGain Kp;
+	FixedGain Ki;
+	FixedGain Kd;
+	FixedError previousError;
+} PIDControllerQ;
+
+// Função para saturar um valor de 64 bits no intervalo de FixedPoint
+static inline FixedPoint fixedSaturate(int64_t value) {
+	if (value > INT32_MAX) {
+		return INT32_MAX;
+	}
+	if (value < INT32_MIN) {
+		return INT32_MIN;
+	}
+	return (FixedPoint)value;
+}
+
+static inline FixedPoint fixedFromFloat(float value) {
+	return fixedSaturate((int64_t)llroundf(value * (float)FIXED_ONE));
+}
+
+static inline float fixedToFloat(FixedPoint value) {
+	return (float)value / (float)FIXED_ONE;
+}
+
+// Conversões dos campos de 16 bits, com arredondamento e saturação
+static inline FixedGain fixedGainFromFloat(float value) {
+	long gain = lroundf(value * (float)(1 << PID_Q_GAIN_FRACTION_BITS));
+	return (FixedGain)(gain < 0 ? 0 : gain > UINT16_MAX ? UINT16_MAX : gain);
+}
+
+static inline float fixedGainToFloat(FixedGain gain) {
+	return (float)gain / (float)(1 << PID_Q_GAIN_FRACTION_BITS);
+}
+
+static inline FixedError fixedToError(FixedPoint value) {
+	const int shift = PID_Q_FRACTION_BITS - PID_Q_ERROR_FRACTION_BITS;
+	int64_t error = shift > 0 ? ((int64_t)value + ((int64_t)1 << shift >> 1)) >> shift : value;
+	return (FixedError)(error < INT16_MIN ? INT16_MIN : error > INT16_MAX ? INT16_MAX : error);
+}
+
+static inline FixedPoint fixedFromError(FixedError error) {
+	return (FixedPoint)error * ((FixedPoint)1 << (PID_Q_FRACTION_BITS - PID_Q_ERROR_FRACTION_BITS));
+}
+
+// Soma e subtração com saturação (sem overflow)
+static inline FixedPoint fixedAdd(FixedPoint a, FixedPoint b) {
+	return fixedSaturate((int64_t)a + b);
+}
+
+static inline FixedPoint fixedSub(FixedPoint a, FixedPoint b) {
+	return fixedSaturate((int64_t)a - b);
+}
+
+// Multiplicação de um ganho Q4.12 por um valor de trabalho, com arredondamento e saturação
+static inline FixedPoint fixedMulGain(FixedGain gain, FixedPoint value) {
+	int64_t product = (int64_t)gain * value;
+	product += (int64_t)1 << (PID_Q_GAIN_FRACTION_BITS - 1);
+	return fixedSaturate(product >> PID_Q_GAIN_FRACTION_BITS);
+}
+
+// Funções do controlador em vírgula fixa
+void setPIDParametersQ(PIDControllerQ* pid, const PIDController* source);
+FixedPoint calculatePIDControlQ(PIDControllerQ* pid, FixedPoint error, FixedPoint temperature);
+int runFixedPointComparison(const PIDController* gains, float setpoint, long steps);
+
+#endif // FIXED_POINT_PID_H
@@ -0,0 +1,273 @@
+﻿// FrameStream.c : As tramas já trazem o comprimento no cabeçalho (WireProtocol.h), o que
+// permite juntar várias num só writev e separar as que chegam juntas num só read.
+
+#include "FrameStream.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <unistd.h>
+
+void frameWriterInit(FrameWriter* writer, int fd, OverflowPolicy policy) {
+	writer->fd = fd;
+	writer->fifoPath = NULL;
+	writer->nextReconnect = 0;
+	writer->policy = policy;
+	writer->congested = false;
+	writer->head = 0;
+	writer->count = 0;
+	writer->highWater = 0;
+	writer->batches = 0;
+	writer->frames = 0;
+	writer->droppedFrames = 0;
+	writer->coalescedFrames = 0;
+	writer->wouldBlock = 0;
+	writer->reconnects = 0;
+}
+
+// Função para escrever num FIFO com nome sem esperar pelo leitor
+// A abertura é tentada já e depois em frameWriterReconnect; até lá as tramas ficam na fila
+void frameWriterOpenFifo(FrameWriter* writer, const char* path, OverflowPolicy policy) {
+	frameWriterInit(writer, -1, policy);
+	writer->fifoPath = path;
+	if (mkfifo(path, 0666) == -1 && errno != EEXIST) {
+		perror("Failed to create FIFO");
+	}
+	frameWriterReconnect(writer);
+}
+
+void frameWriterClose(FrameWriter* writer) {
+	if (writer->fd != -1) {
+		close(writer->fd);
+		writer->fd = -1;
+	}
+}
+
+// Função para tentar abrir o FIFO se estiver desligado; devolve verdadeiro se ficou ligado
+// Com O_NONBLOCK, open falha logo (ENXIO) quando ainda não há leitor
+bool frameWriterReconnect(FrameWriter* writer) {
+	if (writer->fd != -1 || writer->fifoPath == NULL) {
+		return writer->fd != -1;
+	}
+
+	uint64_t now = wireTimestampNow();
+	if (now < writer->nextReconnect) {
+		return false;
+	}
+	writer->nextReconnect = now + FRAME_RECONNECT_INTERVAL_NS;
+
+	writer->fd = open(writer->fifoPath, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+	if (writer->fd == -1) {
+		if (errno != ENXIO) {
+			perror("Failed to open FIFO");
+		}
+		return false;
+	}
+	writer->reconnects++;
+	return true;
+}
+
+static QueuedFrame* queuedAt(FrameWriter* writer, size_t position) {
+	return &writer->queue[(writer->head + position) % FRAME_QUEUE_SLOTS];
+}
+
+// Função para pôr uma trama na fila, aplicando a política se o leitor não acompanhar
+// Devolve falso se a trama nova foi descartada
+bool frameWriterAppend(FrameWriter* writer, const WireFrame* frame) {
+	QueuedFrame* slot = NULL;
+
+	// Com o leitor atrasado, só interessa o valor mais recente de cada tipo
+	if (writer->policy == OVERFLOW_COALESCE && writer->congested) {
+		for (size_t i = writer->count; i > 0 && slot == NULL; i--) {
+			if (queuedAt(writer, i - 1)->type == frame->type) {
+				slot = queuedAt(writer, i - 1);
+			}
+		}
+		if (slot != NULL) {
+			writer->coalescedFrames++;
+		}
+	}
+
+	if (slot == NULL) {
+		if (writer->count == FRAME_QUEUE_SLOTS) {
+			writer->droppedFrames++;
+			if (writer->policy == OVERFLOW_DROP_NEWEST) {
+				return false;
+			}
+			writer->head = (writer->head + 1) % FRAME_QUEUE_SLOTS;
+			writer->count--;
+		}
+		slot = queuedAt(writer, writer->count);
+		writer->count++;
+		if (writer->count > writer->highWater) {
+			writer->highWater = writer->count;
+		}
+	}
+
+	slot->size = (uint16_t)wireEncodeFrame(frame, slot->data, sizeof(slot->data));
+	slot->type = frame->type;
+	return slot->size > 0;
+}
+
+// Função para preparar o próximo lote (até PIPE_BUF bytes) sem o escrever
+// Devolve o número de entradas em iov, 0 se a fila está vazia ou o canal desligado
+// As tramas do lote ficam na fila até frameWriterComplete, por isso o lote tem de ser escrito antes de
+// voltar a chamar frameWriterAppend
+int frameWriterPrepare(FrameWriter* writer, struct iovec* iov) {
+	if (writer->count > 0 && writer->fd == -1) {
+		writer->congested = true;
+		return 0;
+	}
+
+	int batch = 0;
+	size_t bytes = 0;
+	while (batch < FRAME_BATCH_MAX && (size_t)batch < writer->count) {
+		QueuedFrame* queued = queuedAt(writer, (size_t)batch);
+		if (bytes + queued->size > FRAME_BATCH_BYTES) {
+			break;
+		}
+		iov[batch].iov_base = queued->data;
+		iov[batch].iov_len = queued->size;
+		bytes += queued->size;
+		batch++;
+	}
+	return batch;
+}
+
+// Função para aplicar o resultado da escrita de um lote (bytes escritos ou -errno)
+// Num pipe cada lote é escrito inteiro ou, se estiver cheio, nada; nesse caso a fila fica para o próximo envio
+// Devolve 0 se o lote foi escrito, 1 se ficou na fila e -1 em erro (fd == -1 se o leitor fechou)
+int frameWriterComplete(FrameWriter* writer, int batch, ssize_t result) {
+	if (result < 0) {
+		int error = (int)-result;
+		if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR || error == ECANCELED) {
+			writer->wouldBlock += error != EINTR;
+			writer->congested = true;
+			return 1;
+		}
+		if (error == EPIPE || error == ECONNRESET) {
+			// O leitor fechou: um FIFO volta a esperar por um leitor, um socket fica fechado
+			frameWriterClose(writer);
+			writer->congested = true;
+			return writer->fifoPath != NULL ? 1 : -1;
+		}
+		fprintf(stderr, "Failed to write frames: %s\n", strerror(error));
+		writer->droppedFrames += (unsigned long)batch;
+	}
+	else {
+		writer->frames += (unsigned long)batch;
+		writer->batches++;
+	}
+
+	writer->head = (writer->head + (size_t)batch) % FRAME_QUEUE_SLOTS;
+	writer->count -= (size_t)batch;
+	if (writer->count == 0) {
+		writer->congested = false;
+	}
+	return result < 0 ? -1 : 0;
+}
+
+// Função para escrever toda a fila, um writev por lote
+// Devolve 0 quando a fila ficou vazia, 1 se ficaram tramas e -1 em erro (fd == -1 se o leitor fechou)
+int frameWriterFlush(FrameWriter* writer) {
+	struct iovec iov[FRAME_BATCH_MAX];
+	while (writer->count > 0) {
+		int batch = frameWriterPrepare(writer, iov);
+		if (batch == 0) {
+			return 1;
+		}
+		ssize_t written = writev(writer->fd, iov, batch);
+		int status = frameWriterComplete(writer, batch, written == -1 ? -errno : written);
+		if (status != 0) {
+			return status;
+		}
+	}
+	writer->congested = false;
+	return 0;
+}
+
+void frameWriterStats(const FrameWriter* writer, ChannelStats* stats) {
+	stats->connected = writer->fd != -1;
+	stats->queued = writer->count;
+	stats->highWater = writer->highWater;
+	stats->frames = writer->frames;
+	stats->batches = writer->batches;
+	stats->droppedFrames = writer->droppedFrames;
+	stats->coalescedFrames = writer->coalescedFrames;
+	stats->wouldBlock = writer->wouldBlock;
+}
+
+static const char* overflowPolicyNames[] = { "drop-oldest", "drop-newest", "coalesce" };
+
+const char* overflowPolicyName(OverflowPolicy policy) {
+	return policy <= OVERFLOW_COALESCE ? overflowPolicyNames[policy] : "drop-oldest";
+}
+
+int overflowPolicyFromName(const char* name, OverflowPolicy* policy) {
+	for (int i = 0; i <= OVERFLOW_COALESCE; i++) {
+		if (strcmp(name, overflowPolicyNames[i]) == 0) {
+			*policy = (OverflowPolicy)i;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void frameReaderInit(FrameReader* reader, int fd) {
+	reader->fd = fd;
+	reader->begin = 0;
+	reader->end = 0;
+	reader->reads = 0;
+	reader->frames = 0;
+	reader->skippedBytes = 0;
+}
+
+// Função para ler tudo o que couber no buffer; devolve os bytes lidos, 0 no fim e -1 em erro
+// Num descritor não bloqueante, -1 com errno EAGAIN indica que não há dados
+ssize_t frameReaderFill(FrameReader* reader) {
+	size_t space;
+	uint8_t* destination = frameReaderPrepareRead(reader, &space);
+	ssize_t count = read(reader->fd, destination, space);
+	if (count > 0) {
+		frameReaderCommitRead(reader, (size_t)count);
+	}
+	return count;
+}
+
+// Função para obter o espaço livre do buffer, para uma leitura feita por outro meio (ex.: io_uring)
+uint8_t* frameReaderPrepareRead(FrameReader* reader, size_t* space) {
+	if (reader->begin > 0) {
+		memmove(reader->buffer, reader->buffer + reader->begin, reader->end - reader->begin);
+		reader->end -= reader->begin;
+		reader->begin = 0;
+	}
+	*space = sizeof(reader->buffer) - reader->end;
+	return reader->buffer + reader->end;
+}
+
+// Função para registar os bytes lidos para o espaço devolvido por frameReaderPrepareRead
+void frameReaderCommitRead(FrameReader* reader, size_t count) {
+	reader->end += count;
+	reader->reads++;
+}
+
+// Função para descodificar a próxima trama completa do buffer; falso se for preciso ler mais
+// Bytes inválidos são saltados um a um até encontrar um cabeçalho válido
+bool frameReaderNext(FrameReader* reader, WireFrame* frame) {
+	while (reader->begin < reader->end) {
+		size_t frameSize;
+		WireStatus status = wireDecodeFrame(reader->buffer + reader->begin, reader->end - reader->begin,
+			frame, &frameSize);
+		if (status == WIRE_OK) {
+			reader->begin += frameSize;
+			reader->frames++;
+			return true;
+		}
+		if (status == WIRE_TRUNCATED) {
+			return false;
+		}
+		reader->begin++;
+		reader->skippedBytes++;
+	}
+	return false;
+}
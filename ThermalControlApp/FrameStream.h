@@ -0,0 +1,92 @@
+﻿// FrameStream.h : Envio em lote (writev) e leitura com separação de tramas sobre um descritor.
+
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include "WireProtocol.h"
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define FRAME_BATCH_MAX 16                  // Tramas por chamada a writev
+#define FRAME_BATCH_BYTES 4096              // Até PIPE_BUF, para o lote ser escrito de forma atómica
+#define FRAME_READER_BUFFER 16384           // Bytes lidos de uma vez pelo leitor
+#define FRAME_QUEUE_SLOTS 64                // Tramas guardadas enquanto o leitor não as aceita
+#define FRAME_RECONNECT_INTERVAL_NS 1000000000ull  // Intervalo entre tentativas de abrir o FIFO
+
+// Política quando a fila está cheia (ou, em COALESCE, quando o leitor está atrasado)
+typedef enum {
+	OVERFLOW_DROP_OLDEST,       // Descarta a trama mais antiga da fila
+	OVERFLOW_DROP_NEWEST,       // Descarta a trama nova
+	OVERFLOW_COALESCE           // A trama nova substitui a última do mesmo tipo ainda na fila
+} OverflowPolicy;
+
+// Estrutura QueuedFrame: trama já codificada à espera de ser escrita
+typedef struct {
+	uint16_t size;
+	uint8_t type;
+	uint8_t data[WIRE_MAX_FRAME_SIZE];
+} QueuedFrame;
+
+// Estrutura FrameWriter: fila de tramas de um canal, escrita em lotes com writev sem nunca bloquear
+typedef struct {
+	int fd;                                 // -1 enquanto o FIFO não tem leitor
+	const char* fifoPath;                   // FIFO a reabrir quando o leitor aparece (NULL num pipe)
+	uint64_t nextReconnect;                 // Próxima tentativa de abrir o FIFO (ns, CLOCK_MONOTONIC)
+	OverflowPolicy policy;
+	bool congested;                         // O último envio deixou tramas na fila
+	QueuedFrame queue[FRAME_QUEUE_SLOTS];
+	size_t head;                            // Trama mais antiga
+	size_t count;                           // Tramas na fila
+	size_t highWater;                       // Maior número de tramas que chegou a estar na fila
+	unsigned long batches;                  // Chamadas a writev bem sucedidas
+	unsigned long frames;                   // Tramas escritas
+	unsigned long droppedFrames;            // Tramas perdidas pela política ou por erro
+	unsigned long coalescedFrames;          // Tramas substituídas por uma mais recente
+	unsigned long wouldBlock;               // Escritas recusadas com o pipe cheio
+	unsigned long reconnects;               // Ligações ao FIFO (incluindo a primeira)
+} FrameWriter;
+
+// Estrutura ChannelStats: cópia dos contadores de um FrameWriter, para os mostrar fora da thread que escreve
+typedef struct {
+	bool connected;
+	size_t queued;
+	size_t highWater;
+	unsigned long frames;
+	unsigned long batches;
+	unsigned long droppedFrames;
+	unsigned long coalescedFrames;
+	unsigned long wouldBlock;
+} ChannelStats;
+
+// Estrutura FrameReader: bytes lidos ainda não convertidos em tramas
+typedef struct {
+	int fd;
+	uint8_t buffer[FRAME_READER_BUFFER];
+	size_t begin;                           // Início da próxima trama em buffer
+	size_t end;                             // Fim dos bytes válidos
+	unsigned long reads;                    // Chamadas a read
+	unsigned long frames;                   // Tramas descodificadas
+	unsigned long skippedBytes;             // Bytes descartados ao ressincronizar
+} FrameReader;
+
+// Funções do escritor
+void frameWriterInit(FrameWriter* writer, int fd, OverflowPolicy policy);
+void frameWriterOpenFifo(FrameWriter* writer, const char* path, OverflowPolicy policy);
+void frameWriterClose(FrameWriter* writer);
+bool frameWriterAppend(FrameWriter* writer, const WireFrame* frame);
+int frameWriterPrepare(FrameWriter* writer, struct iovec* iov);
+int frameWriterComplete(FrameWriter* writer, int batch, ssize_t result);
+int frameWriterFlush(FrameWriter* writer);
+bool frameWriterReconnect(FrameWriter* writer);
+void frameWriterStats(const FrameWriter* writer, ChannelStats* stats);
+const char* overflowPolicyName(OverflowPolicy policy);
+int overflowPolicyFromName(const char* name, OverflowPolicy* policy);
+
+// Funções do leitor
+void frameReaderInit(FrameReader* reader, int fd);
+ssize_t frameReaderFill(FrameReader* reader);
+uint8_t* frameReaderPrepareRead(FrameReader* reader, size_t* space);
+void frameReaderCommitRead(FrameReader* reader, size_t count);
+bool frameReaderNext(FrameReader* reader, WireFrame* frame);
+
+#endif // FRAME_STREAM_H
@@ -0,0 +1,233 @@
+﻿// IoBackend.c : Com io_uring, as escritas e leituras de um ciclo são postas no anel de submissão e
+// enviadas com um único io_uring_enter, que também espera pelas conclusões. Os descritores são
+// não bloqueantes, pelo que o kernel conclui cada operação durante a submissão (ou devolve -EAGAIN)
+// e os buffers só precisam de ser válidos durante a chamada.
+// Sem io_uring (ou noutra plataforma), cada operação é feita logo e o resultado guardado para
+// ioBackendSubmit, por isso quem chama trata os dois casos da mesma forma.
+
+#include "IoBackend.h"
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef __linux__
+
+static int ioUringSetup(unsigned entries, struct io_uring_params* parameters) {
+	return (int)syscall(__NR_io_uring_setup, entries, parameters);
+}
+
+static int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+	return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+// Função para criar o anel e mapear as filas
+static int ioUringInit(IoUring* ring, unsigned entries) {
+	struct io_uring_params parameters;
+	memset(&parameters, 0, sizeof(parameters));
+	ring->ringFd = ioUringSetup(entries, &parameters);
+	if (ring->ringFd == -1) {
+		return -1;
+	}
+
+	ring->sqRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+	ring->cqRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe);
+	bool singleMap = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap && ring->cqRingSize > ring->sqRingSize) {
+		ring->sqRingSize = ring->cqRingSize;
+	}
+
+	ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring->ringFd, IORING_OFF_SQ_RING);
+	if (ring->sqRing == MAP_FAILED) {
+		close(ring->ringFd);
+		return -1;
+	}
+	ring->cqRing = singleMap ? ring->sqRing : mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->ringFd, IORING_OFF_CQ_RING);
+	ring->sqesSize = parameters.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring->ringFd, IORING_OFF_SQES);
+	if (ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED) {
+		if (ring->cqRing != MAP_FAILED && !singleMap) {
+			munmap(ring->cqRing, ring->cqRingSize);
+		}
+		munmap(ring->sqRing, ring->sqRingSize);
+		close(ring->ringFd);
+		return -1;
+	}
+
+	uint8_t* sq = ring->sqRing;
+	ring->sqHead = (unsigned*)(sq + parameters.sq_off.head);
+	ring->sqTail = (unsigned*)(sq + parameters.sq_off.tail);
+	ring->sqMask = (unsigned*)(sq + parameters.sq_off.ring_mask);
+	ring->sqArray = (unsigned*)(sq + parameters.sq_off.array);
+	uint8_t* cq = ring->cqRing;
+	ring->cqHead = (unsigned*)(cq + parameters.cq_off.head);
+	ring->cqTail = (unsigned*)(cq + parameters.cq_off.tail);
+	ring->cqMask = (unsigned*)(cq + parameters.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe*)(cq + parameters.cq_off.cqes);
+	return 0;
+}
+
+static void ioUringClose(IoUring* ring) {
+	munmap(ring->sqes, ring->sqesSize);
+	if (ring->cqRing != ring->sqRing) {
+		munmap(ring->cqRing, ring->cqRingSize);
+	}
+	munmap(ring->sqRing, ring->sqRingSize);
+	close(ring->ringFd);
+}
+
+// Função para obter a próxima entrada livre do anel de submissão
+static struct io_uring_sqe* ioUringNextEntry(IoUring* ring) {
+	unsigned tail = *ring->sqTail;
+	unsigned head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+	if (tail - head > *ring->sqMask) {
+		return NULL;
+	}
+	unsigned index = tail & *ring->sqMask;
+	struct io_uring_sqe* entry = &ring->sqes[index];
+	memset(entry, 0, sizeof(*entry));
+	ring->sqArray[index] = index;
+	__atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+	return entry;
+}
+
+#endif // __linux__
+
+int ioBackendInit(IoBackend* backend, IoBackendKind kind) {
+	memset(backend, 0, sizeof(*backend));
+	backend->kind = IO_BACKEND_SYNC;
+#ifdef __linux__
+	if (kind == IO_BACKEND_URING) {
+		if (ioUringInit(&backend->ring, IO_BACKEND_MAX_OPERATIONS) != 0) {
+			perror("io_uring not available, using synchronous I/O");
+			return -1;
+		}
+		backend->kind = IO_BACKEND_URING;
+	}
+#else
+	if (kind == IO_BACKEND_URING) {
+		fprintf(stderr, "io_uring not available, using synchronous I/O\n");
+		return -1;
+	}
+#endif
+	return 0;
+}
+
+void ioBackendClose(IoBackend* backend) {
+#ifdef __linux__
+	if (backend->kind == IO_BACKEND_URING) {
+		ioUringClose(&backend->ring);
+	}
+#endif
+	backend->kind = IO_BACKEND_SYNC;
+}
+
+// Função para guardar o resultado de uma operação síncrona
+static bool completeNow(IoBackend* backend, uint64_t userData, ssize_t result) {
+	if (backend->completed == IO_BACKEND_MAX_OPERATIONS) {
+		return false;
+	}
+	backend->completions[backend->completed].userData = userData;
+	backend->completions[backend->completed].result = result < 0 ? -errno : (int32_t)result;
+	backend->completed++;
+	backend->submits++;
+	backend->operations++;
+	return true;
+}
+
+// Função para pôr uma escrita vetorizada na fila; linkNext faz a operação seguinte esperar por esta
+// (se esta falhar, a seguinte termina com -ECANCELED)
+bool ioQueueWritev(IoBackend* backend, int fd, const struct iovec* iov, int count, uint64_t userData, bool linkNext) {
+#ifdef __linux__
+	if (backend->kind == IO_BACKEND_URING) {
+		struct io_uring_sqe* entry = ioUringNextEntry(&backend->ring);
+		if (entry == NULL) {
+			return false;
+		}
+		entry->opcode = IORING_OP_WRITEV;
+		entry->fd = fd;
+		entry->addr = (uint64_t)(uintptr_t)iov;
+		entry->len = (uint32_t)count;
+		entry->off = (uint64_t)-1; // Posição atual (pipes e sockets)
+		entry->flags = linkNext ? IOSQE_IO_LINK : 0;
+		entry->user_data = userData;
+		backend->queued++;
+		return true;
+	}
+#endif
+	return completeNow(backend, userData, writev(fd, iov, count));
+}
+
+// Função para pôr uma leitura na fila
+bool ioQueueRead(IoBackend* backend, int fd, void* buffer, size_t size, uint64_t userData) {
+#ifdef __linux__
+	if (backend->kind == IO_BACKEND_URING) {
+		struct io_uring_sqe* entry = ioUringNextEntry(&backend->ring);
+		if (entry == NULL) {
+			return false;
+		}
+		entry->opcode = IORING_OP_READ;
+		entry->fd = fd;
+		entry->addr = (uint64_t)(uintptr_t)buffer;
+		entry->len = (uint32_t)size;
+		entry->off = (uint64_t)-1;
+		entry->user_data = userData;
+		backend->queued++;
+		return true;
+	}
+#endif
+	return completeNow(backend, userData, read(fd, buffer, size));
+}
+
+// Função para submeter as operações em fila e recolher as conclusões
+// Devolve o número de conclusões copiadas para completions, ou -1 em erro
+int ioBackendSubmit(IoBackend* backend, IoCompletion* completions, int maxCompletions) {
+	int count = 0;
+
+#ifdef __linux__
+	if (backend->kind == IO_BACKEND_URING) {
+		IoUring* ring = &backend->ring;
+		unsigned queued = backend->queued;
+		if (queued > 0) {
+			int submitted;
+			do {
+				submitted = ioUringEnter(ring->ringFd, queued, queued, IORING_ENTER_GETEVENTS);
+			} while (submitted == -1 && errno == EINTR);
+			if (submitted == -1) {
+				perror("Failed to submit io_uring operations");
+				return -1;
+			}
+			backend->submits++;
+			backend->operations += queued;
+			backend->queued = 0;
+		}
+
+		unsigned head = *ring->cqHead;
+		unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+		while (head != tail && count < maxCompletions) {
+			struct io_uring_cqe* entry = &ring->cqes[head & *ring->cqMask];
+			completions[count].userData = entry->user_data;
+			completions[count].result = entry->res;
+			count++;
+			head++;
+		}
+		__atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+		return count;
+	}
+#endif
+
+	for (unsigned i = 0; i < backend->completed && count < maxCompletions; i++) {
+		completions[count++] = backend->completions[i];
+	}
+	backend->completed = 0;
+	return count;
+}
+
+const char* ioBackendName(IoBackendKind kind) {
+	return kind == IO_BACKEND_URING ? "io_uring" : "sync";
+}
@@ -0,0 +1,68 @@
+﻿// IoBackend.h : Submissão em lote das operações de I/O de cada ciclo (io_uring, com alternativa síncrona).
+
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+#include <sys/uio.h>
+
+#define IO_BACKEND_MAX_OPERATIONS 64    // Operações por submissão
+
+// Tipo de backend
+typedef enum {
+	IO_BACKEND_SYNC,        // Cada operação é executada logo (read/writev), como no ciclo epoll
+	IO_BACKEND_URING        // Operações acumuladas e submetidas com um só io_uring_enter
+} IoBackendKind;
+
+// Estrutura IoCompletion: resultado de uma operação (bytes ou -errno)
+typedef struct {
+	uint64_t userData;
+	int32_t result;
+} IoCompletion;
+
+#ifdef __linux__
+
+// Estrutura IoUring: anéis de submissão e conclusão mapeados do kernel (sem liburing)
+typedef struct {
+	int ringFd;
+	unsigned* sqHead;
+	unsigned* sqTail;
+	unsigned* sqMask;
+	unsigned* sqArray;
+	struct io_uring_sqe* sqes;
+	unsigned* cqHead;
+	unsigned* cqTail;
+	unsigned* cqMask;
+	struct io_uring_cqe* cqes;
+	void* sqRing;
+	size_t sqRingSize;
+	void* cqRing;
+	size_t cqRingSize;
+	size_t sqesSize;
+} IoUring;
+
+#endif // __linux__
+
+// Estrutura IoBackend
+typedef struct {
+	IoBackendKind kind;
+#ifdef __linux__
+	IoUring ring;
+#endif
+	unsigned queued;                                    // Operações por submeter
+	IoCompletion completions[IO_BACKEND_MAX_OPERATIONS]; // Resultados do modo síncrono
+	unsigned completed;
+	unsigned long submits;                              // Chamadas ao sistema de submissão
+	unsigned long operations;                           // Operações executadas
+} IoBackend;
+
+// Funções do backend; ioBackendInit com IO_BACKEND_URING recua para IO_BACKEND_SYNC se o kernel recusar
+int ioBackendInit(IoBackend* backend, IoBackendKind kind);
+void ioBackendClose(IoBackend* backend);
+bool ioQueueWritev(IoBackend* backend, int fd, const struct iovec* iov, int count, uint64_t userData, bool linkNext);
+bool ioQueueRead(IoBackend* backend, int fd, void* buffer, size_t size, uint64_t userData);
+int ioBackendSubmit(IoBackend* backend, IoCompletion* completions, int maxCompletions);
+const char* ioBackendName(IoBackendKind kind);
+
+#endif // IO_BACKEND_H
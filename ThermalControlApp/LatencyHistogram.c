@@ -0,0 +1,82 @@
+﻿// LatencyHistogram.c : A posição é calculada com um clz e dois deslocamentos, sem ciclos nem divisões,
+// e o escritor único usa load/store relaxados em vez de operações atómicas com lock.
+
+#include "LatencyHistogram.h"
+
+#define SUB_BUCKETS (1ull << LATENCY_SUB_BUCKET_BITS)
+#define HALF_SUB_BUCKETS (SUB_BUCKETS >> 1)
+
+void latencyHistogramInit(LatencyHistogram* histogram) {
+	for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+		atomic_init(&histogram->counts[i], 0);
+	}
+	atomic_init(&histogram->total, 0);
+	atomic_init(&histogram->sum, 0);
+	atomic_init(&histogram->min, UINT64_MAX);
+	atomic_init(&histogram->max, 0);
+}
+
+// Função para obter a posição de um valor: abaixo de SUB_BUCKETS cada ns tem a sua posição;
+// acima, os LATENCY_SUB_BUCKET_BITS bits mais significativos escolhem a posição dentro da potência de 2
+static size_t bucketIndex(uint64_t ns) {
+	if (ns < SUB_BUCKETS) {
+		return (size_t)ns;
+	}
+	if (ns >> LATENCY_MAGNITUDES) {
+		return LATENCY_BUCKETS - 1;
+	}
+	unsigned shift = (unsigned)(63 - __builtin_clzll(ns)) - LATENCY_SUB_BUCKET_BITS + 1;
+	return (size_t)(((uint64_t)shift << (LATENCY_SUB_BUCKET_BITS - 1)) + (ns >> shift));
+}
+
+// Função para obter o maior valor que cai na mesma posição
+static uint64_t bucketHighest(size_t index) {
+	if (index < SUB_BUCKETS) {
+		return index;
+	}
+	unsigned shift = (unsigned)(index >> (LATENCY_SUB_BUCKET_BITS - 1)) - 1;
+	uint64_t sub = index - ((uint64_t)shift << (LATENCY_SUB_BUCKET_BITS - 1));
+	return ((sub + 1) << shift) - 1;
+}
+
+// Função para somar um contador (só o escritor altera o histograma)
+static inline void bump(_Atomic uint64_t* counter, uint64_t amount) {
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+void latencyHistogramRecord(LatencyHistogram* histogram, uint64_t ns) {
+	bump(&histogram->counts[bucketIndex(ns)], 1);
+	bump(&histogram->total, 1);
+	bump(&histogram->sum, ns);
+	if (ns < atomic_load_explicit(&histogram->min, memory_order_relaxed)) {
+		atomic_store_explicit(&histogram->min, ns, memory_order_relaxed);
+	}
+	if (ns > atomic_load_explicit(&histogram->max, memory_order_relaxed)) {
+		atomic_store_explicit(&histogram->max, ns, memory_order_relaxed);
+	}
+}
+
+// Função para obter o percentil (o maior valor equivalente da posição, limitado ao máximo registado)
+uint64_t latencyHistogramPercentile(LatencyHistogram* histogram, double percentile) {
+	uint64_t total = atomic_load_explicit(&histogram->total, memory_order_relaxed);
+	uint64_t maximum = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	if (total == 0) {
+		return 0;
+	}
+	uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+	rank = rank < 1 ? 1 : rank;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += atomic_load_explicit(&histogram->counts[i], memory_order_relaxed);
+		if (seen >= rank) {
+			uint64_t value = bucketHighest(i);
+			return value < maximum ? value : maximum;
+		}
+	}
+	return maximum;
+}
+
+double latencyHistogramMean(LatencyHistogram* histogram) {
+	uint64_t total = atomic_load_explicit(&histogram->total, memory_order_relaxed);
+	return total > 0 ? (double)atomic_load_explicit(&histogram->sum, memory_order_relaxed) / (double)total : 0.0;
+}
@@ -0,0 +1,37 @@
+﻿// LatencyHistogram.h : Histograma de latências ao estilo HDR (posições lineares dentro de cada potência de 2).
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#define LATENCY_SUB_BUCKET_BITS 8   // Exato até 256 ns; depois 128 posições por potência de 2 (erro < 0,8 %)
+#define LATENCY_MAGNITUDES 40       // Valores até 2^40 ns (~18 min); acima disto só contam para o máximo
+#define LATENCY_BUCKETS (((LATENCY_MAGNITUDES - LATENCY_SUB_BUCKET_BITS) << (LATENCY_SUB_BUCKET_BITS - 1)) + \
+	(1 << LATENCY_SUB_BUCKET_BITS))
+
+// Estrutura LatencyHistogram: um só escritor; os contadores atómicos podem ser lidos por outra thread
+typedef struct {
+	_Atomic uint64_t counts[LATENCY_BUCKETS];
+	_Atomic uint64_t total;
+	_Atomic uint64_t sum;
+	_Atomic uint64_t min;
+	_Atomic uint64_t max;
+} LatencyHistogram;
+
+// Funções
+void latencyHistogramInit(LatencyHistogram* histogram);
+void latencyHistogramRecord(LatencyHistogram* histogram, uint64_t ns);
+uint64_t latencyHistogramPercentile(LatencyHistogram* histogram, double percentile);
+double latencyHistogramMean(LatencyHistogram* histogram);
+
+// Função para ler o relógio monotónico em ns
+static inline uint64_t latencyNow() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+#endif // LATENCY_HISTOGRAM_H
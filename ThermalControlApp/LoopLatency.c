@@ -0,0 +1,72 @@
+﻿// LoopLatency.c : Cada fase acumula o tempo desde a marca anterior; o ciclo só é registado nos histogramas
+// no fim (loopLatencyCommit), para que o writev feito depois de uma recuperação conte para o último passo.
+
+#include "LoopLatency.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* phaseNames[LOOP_PHASE_COUNT] = { "wake", "read input", "compute PID", "write output", "log" };
+
+void loopLatencyInit(LoopLatency* latency) {
+	for (int i = 0; i < LOOP_PHASE_COUNT; i++) {
+		latencyHistogramInit(&latency->phases[i]);
+	}
+	latencyHistogramInit(&latency->lateness);
+	memset(latency->pending, 0, sizeof(latency->pending));
+	latency->mark = latencyNow();
+}
+
+// Função chamada ao acordar: começa a fase de despertar
+void loopLatencyWake(LoopLatency* latency) {
+	latency->mark = latencyNow();
+}
+
+// Função para registar o atraso do despertar face ao prazo (LOOP_NO_DEADLINE é ignorado)
+void loopLatencyLateness(LoopLatency* latency, int64_t latenessNs) {
+	if (latenessNs >= 0) {
+		latencyHistogramRecord(&latency->lateness, (uint64_t)latenessNs);
+	}
+}
+
+// Função para fechar a fase em curso
+void loopLatencyMark(LoopLatency* latency, LoopPhase phase) {
+	uint64_t now = latencyNow();
+	latency->pending[phase] += now - latency->mark;
+	latency->mark = now;
+}
+
+// Função para retomar a medição sem contar o tempo desde a última marca (monitor, fflush)
+void loopLatencyResume(LoopLatency* latency) {
+	latency->mark = latencyNow();
+}
+
+// Função para registar o ciclo terminado
+void loopLatencyCommit(LoopLatency* latency) {
+	for (int i = 0; i < LOOP_PHASE_COUNT; i++) {
+		latencyHistogramRecord(&latency->phases[i], latency->pending[i]);
+		latency->pending[i] = 0;
+	}
+}
+
+// Função para escrever uma linha da tabela em microssegundos
+static void printHistogram(const char* name, LatencyHistogram* histogram) {
+	printf("  %-14s %10.1f %10.1f %10.1f %10.1f\n", name, latencyHistogramPercentile(histogram, 50.0) / 1e3,
+		latencyHistogramPercentile(histogram, 99.0) / 1e3, latencyHistogramPercentile(histogram, 99.9) / 1e3,
+		atomic_load_explicit(&histogram->max, memory_order_relaxed) / 1e3);
+}
+
+// Função para mostrar p50/p99/p99.9/max de cada fase e do atraso do despertar
+void loopLatencyPrint(LoopLatency* latency) {
+	unsigned long long ticks = atomic_load_explicit(&latency->phases[0].total, memory_order_relaxed);
+	printf("Loop latency over %llu ticks (us):\n", ticks);
+	printf("  %-14s %10s %10s %10s %10s\n", "phase", "p50", "p99", "p99.9", "max");
+	for (int i = 0; i < LOOP_PHASE_COUNT; i++) {
+		printHistogram(phaseNames[i], &latency->phases[i]);
+	}
+	if (atomic_load_explicit(&latency->lateness.total, memory_order_relaxed) > 0) {
+		printHistogram("wake lateness", &latency->lateness);
+	}
+	else {
+		printf("  wake lateness: no deadlines (unbounded time warp)\n");
+	}
+}
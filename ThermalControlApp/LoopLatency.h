@@ -0,0 +1,37 @@
+﻿// LoopLatency.h : Duração de cada fase do ciclo de controlo e atraso do despertar face ao prazo.
+
+#ifndef LOOP_LATENCY_H
+#define LOOP_LATENCY_H
+
+#include "LatencyHistogram.h"
+
+#define LOOP_NO_DEADLINE (-1) // Atraso de um ciclo sem prazo (sem limite de ritmo)
+
+// Fases de um ciclo, pela ordem em que acontecem
+typedef enum {
+	LOOP_PHASE_WAKE,          // Do despertar ao início do passo (leitura do temporizador)
+	LOOP_PHASE_READ_INPUT,    // Configuração e temperatura imposta pelo menu
+	LOOP_PHASE_COMPUTE,       // Cálculo do PID
+	LOOP_PHASE_WRITE_OUTPUT,  // Aplicação da saída e envio das tramas (incluindo o writev)
+	LOOP_PHASE_LOG,           // Registo e publicação do estado
+	LOOP_PHASE_COUNT
+} LoopPhase;
+
+// Estrutura LoopLatency: alterada só pela thread do ciclo
+typedef struct {
+	LatencyHistogram phases[LOOP_PHASE_COUNT];
+	LatencyHistogram lateness;            // Despertar real menos o prazo
+	uint64_t mark;                        // Início da fase em curso
+	uint64_t pending[LOOP_PHASE_COUNT];   // Durações do ciclo em curso, registadas por loopLatencyCommit
+} LoopLatency;
+
+// Funções
+void loopLatencyInit(LoopLatency* latency);
+void loopLatencyWake(LoopLatency* latency);
+void loopLatencyLateness(LoopLatency* latency, int64_t latenessNs);
+void loopLatencyMark(LoopLatency* latency, LoopPhase phase);
+void loopLatencyResume(LoopLatency* latency);
+void loopLatencyCommit(LoopLatency* latency);
+void loopLatencyPrint(LoopLatency* latency);
+
+#endif // LOOP_LATENCY_H
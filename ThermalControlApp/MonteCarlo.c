@@ -0,0 +1,181 @@
+﻿// MonteCarlo.c : Cada simulação é determinística a partir da sua semente, pelo que
+// os resultados não dependem do número de threads nem da ordem de execução.
+
+#include "MonteCarlo.h"
+#include "PIDBatch.h"
+#include "ZoneEngine.h"
+#include "ThreadPool.h"
+#include "SimClock.h"
+
+// Estrutura MonteCarloBatch: contexto partilhado pelas tarefas
+typedef struct {
+	const MonteCarloConfig* config;
+	MonteCarloResult* results;
+} MonteCarloBatch;
+
+// Função SplitMix64: deriva sementes independentes e gera números pseudoaleatórios
+static uint64_t splitMix64(uint64_t* state) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Função para sortear um valor uniforme em [minimum, maximum]
+static float uniform(uint64_t* state, float minimum, float maximum) {
+	float unit = (float)(splitMix64(state) >> 40) / (float)(1ULL << 24);
+	return minimum + (maximum - minimum) * unit;
+}
+
+// Função para preencher a configuração por omissão (em torno do PID da aplicação)
+void monteCarloDefaultConfig(MonteCarloConfig* config) {
+	memset(config, 0, sizeof(*config));
+	config->runs = 1000;
+	config->seed = 1;
+	config->threads = 0;
+	config->steps = 2000;
+	config->dt = SIMULATION_DT;
+	config->setpoint = 20.0f;
+	config->kpMin = 0.1f;
+	config->kpMax = 2.0f;
+	config->kiMin = 0.0f;
+	config->kiMax = 0.5f;
+	config->kdMin = 0.0f;
+	config->kdMax = 0.5f;
+	config->temperatureMin = MIN_TEMPERATURE;
+	config->temperatureMax = MAX_TEMPERATURE;
+	config->heatLossMin = 0.0f;
+	config->heatLossMax = 1.0f;
+}
+
+// Função para executar uma simulação e calcular as suas métricas
+void monteCarloSimulate(const MonteCarloConfig* config, size_t runIndex, MonteCarloResult* result) {
+	uint64_t seedState = config->seed + runIndex;
+	uint64_t state = splitMix64(&seedState);
+
+	result->seed = state;
+	result->Kp = uniform(&state, config->kpMin, config->kpMax);
+	result->Ki = uniform(&state, config->kiMin, config->kiMax);
+	result->Kd = uniform(&state, config->kdMin, config->kdMax);
+	result->initialTemperature = uniform(&state, config->temperatureMin, config->temperatureMax);
+	result->heatLoss = uniform(&state, config->heatLossMin, config->heatLossMax);
+
+	float setpoint = config->setpoint;
+	float temperature = result->initialTemperature;
+	float previousError = 0.0f;
+	float integral = 0.0f;
+	float direction = (setpoint >= temperature) ? 1.0f : -1.0f;
+	long lastOutsideBand = -1;
+	long steadyStateStart = config->steps - (long)(config->steps * STEADY_STATE_FRACTION);
+	double steadyStateSum = 0.0;
+	long steadyStateSamples = 0;
+	float overshoot = 0.0f;
+
+	for (long step = 0; step < config->steps; step++) {
+		float error = setpoint - temperature;
+		float output = pidControlStep(error, temperature, result->Kp, result->Ki, result->Kd, &previousError, &integral);
+		temperature = zonePlantStep(temperature, output) - result->heatLoss;
+
+		float deviation = temperature - setpoint;
+		if (deviation * direction > overshoot) {
+			overshoot = deviation * direction;
+		}
+		if (fabsf(deviation) > SETTLING_BAND) {
+			lastOutsideBand = step;
+		}
+		if (step >= steadyStateStart) {
+			steadyStateSum += fabsf(deviation);
+			steadyStateSamples++;
+		}
+	}
+
+	// Estabilizado se as últimas amostras ficaram todas dentro da banda
+	if (lastOutsideBand == config->steps - 1) {
+		result->settlingTime = -1.0f;
+	}
+	else {
+		result->settlingTime = (float)((lastOutsideBand + 2) * config->dt);
+	}
+	result->overshoot = overshoot;
+	result->steadyStateError = steadyStateSamples > 0 ? (float)(steadyStateSum / steadyStateSamples) : 0.0f;
+}
+
+// Tarefa do conjunto de threads: uma simulação por índice
+static void monteCarloTask(size_t index, void* context) {
+	MonteCarloBatch* batch = (MonteCarloBatch*)context;
+	monteCarloSimulate(batch->config, index, &batch->results[index]);
+}
+
+// Função para executar todas as simulações em paralelo
+int monteCarloRun(const MonteCarloConfig* config, MonteCarloResult* results) {
+	MonteCarloBatch batch = { config, results };
+	return threadPoolRun(config->runs, config->threads, monteCarloTask, &batch);
+}
+
+// Função para escrever os resultados em CSV (uma linha por simulação)
+void monteCarloWriteCSV(FILE* file, const MonteCarloResult* results, size_t count) {
+	fprintf(file, "run,seed,kp,ki,kd,initial_temperature,heat_loss,settling_time,overshoot,steady_state_error\n");
+	for (size_t i = 0; i < count; i++) {
+		const MonteCarloResult* r = &results[i];
+		fprintf(file, "%zu,%llu,%.6f,%.6f,%.6f,%.4f,%.4f,%.2f,%.4f,%.4f\n", i, (unsigned long long)r->seed,
+			r->Kp, r->Ki, r->Kd, r->initialTemperature, r->heatLoss, r->settlingTime, r->overshoot, r->steadyStateError);
+	}
+}
+
+// Função para executar o lote, escrever o CSV e mostrar um resumo
+int runMonteCarlo(const MonteCarloConfig* config, const char* outputPath) {
+	MonteCarloResult* results = calloc(config->runs, sizeof(MonteCarloResult));
+	if (results == NULL) {
+		fprintf(stderr, "Failed to allocate %zu Monte Carlo results\n", config->runs);
+		return EXIT_FAILURE;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (monteCarloRun(config, results) != 0) {
+		fprintf(stderr, "Failed to start Monte Carlo threads\n");
+		free(results);
+		return EXIT_FAILURE;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+	FILE* output = stdout;
+	if (outputPath != NULL) {
+		output = fopen(outputPath, "w");
+		if (output == NULL) {
+			perror("Failed to open Monte Carlo output");
+			free(results);
+			return EXIT_FAILURE;
+		}
+	}
+	monteCarloWriteCSV(output, results, config->runs);
+	if (output != stdout) {
+		fclose(output);
+	}
+
+	// Melhor simulação: estabilizada, com o menor tempo de estabelecimento
+	size_t settled = 0;
+	size_t best = config->runs;
+	for (size_t i = 0; i < config->runs; i++) {
+		if (results[i].settlingTime < 0.0f) {
+			continue;
+		}
+		settled++;
+		if (best == config->runs || results[i].settlingTime < results[best].settlingTime) {
+			best = i;
+		}
+	}
+
+	FILE* summary = outputPath != NULL ? stdout : stderr;
+	fprintf(summary, "Runs: %zu, Threads: %u, Seed: %llu, Elapsed: %.3f s, Settled: %zu\n", config->runs,
+		config->threads > 0 ? config->threads : threadPoolDefaultThreads(), (unsigned long long)config->seed, elapsed, settled);
+	if (best < config->runs) {
+		fprintf(summary, "Best run %zu: Kp=%.4f, Ki=%.4f, Kd=%.4f, Settling Time: %.2f s, Overshoot: %.4f, Steady-State Error: %.4f\n",
+			best, results[best].Kp, results[best].Ki, results[best].Kd, results[best].settlingTime,
+			results[best].overshoot, results[best].steadyStateError);
+	}
+
+	free(results);
+	return EXIT_SUCCESS;
+}
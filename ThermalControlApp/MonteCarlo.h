@@ -0,0 +1,47 @@
+﻿// MonteCarlo.h : Execução paralela de simulações aleatórias para afinação do PID.
+
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+
+#define SETTLING_BAND 0.5f          // Banda (°C) em torno do setpoint para o tempo de estabelecimento
+#define STEADY_STATE_FRACTION 0.1   // Fração final da simulação usada para o erro em regime permanente
+
+// Estrutura MonteCarloConfig: intervalos amostrados uniformemente em cada simulação
+typedef struct {
+	size_t runs;                 // Número de simulações independentes
+	uint64_t seed;               // Semente base; a simulação i usa uma semente derivada de seed e i
+	unsigned threads;            // 0 = todos os núcleos
+	long steps;                  // Ciclos por simulação
+	double dt;                   // Tempo simulado por ciclo (s)
+	float setpoint;
+	float kpMin, kpMax;
+	float kiMin, kiMax;
+	float kdMin, kdMax;
+	float temperatureMin, temperatureMax;   // Temperatura inicial
+	float heatLossMin, heatLossMax;         // Perda de calor para o ambiente (°C por ciclo)
+} MonteCarloConfig;
+
+// Estrutura MonteCarloResult: parâmetros sorteados e métricas de uma simulação
+typedef struct {
+	uint64_t seed;
+	float Kp;
+	float Ki;
+	float Kd;
+	float initialTemperature;
+	float heatLoss;
+	float settlingTime;          // Segundos simulados; negativo se não estabilizou
+	float overshoot;             // Ultrapassagem máxima do setpoint (°C)
+	float steadyStateError;      // Erro absoluto médio no final (°C)
+} MonteCarloResult;
+
+// Funções do executor Monte Carlo
+void monteCarloDefaultConfig(MonteCarloConfig* config);
+void monteCarloSimulate(const MonteCarloConfig* config, size_t runIndex, MonteCarloResult* result);
+int monteCarloRun(const MonteCarloConfig* config, MonteCarloResult* results);
+void monteCarloWriteCSV(FILE* file, const MonteCarloResult* results, size_t count);
+int runMonteCarlo(const MonteCarloConfig* config, const char* outputPath);
+
+#endif // MONTE_CARLO_H
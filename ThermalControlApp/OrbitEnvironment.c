@@ -0,0 +1,86 @@
+﻿// OrbitEnvironment.c : Geração das tabelas orbitais. A fase 0 é o ponto subsolar e o
+// eclipse fica centrado na fase 0.5; o fluxo combina sol direto, albedo e infravermelho da Terra.
+
+#include "OrbitEnvironment.h"
+
+#define TWO_PI 6.283185307179586
+
+// Função para preencher parâmetros de uma órbita baixa típica (LEO, ~92 min)
+void orbitDefaultParameters(OrbitParameters* parameters) {
+	parameters->period = 5520.0;
+	parameters->eclipseFraction = 0.38;
+	parameters->sunExposureFraction = 0.2;
+	parameters->solarFlux = SOLAR_CONSTANT;
+	parameters->albedo = 0.3;
+	parameters->earthInfrared = 237.0;
+}
+
+// Função para classificar uma fase da órbita
+static OrbitPeriod classifyPhase(const OrbitParameters* parameters, double phase) {
+	double fromSubsolar = fabs(phase - 0.5); // 0.5 no ponto subsolar, 0 no centro do eclipse
+	if (fromSubsolar < parameters->eclipseFraction / 2.0) {
+		return ORBIT_ECLIPSE;
+	}
+	if (0.5 - fromSubsolar < parameters->sunExposureFraction / 2.0) {
+		return ORBIT_SUN_EXPOSURE;
+	}
+	return ORBIT_NORMAL;
+}
+
+// Função para construir a tabela com size amostras (arredondado para potência de 2)
+int orbitTableBuild(OrbitTable* table, const OrbitParameters* parameters, size_t size) {
+	memset(table, 0, sizeof(*table));
+
+	size_t rounded = 1;
+	while (rounded < size) {
+		rounded <<= 1;
+	}
+
+	table->heatFlux = malloc((rounded + 1) * sizeof(float));
+	table->environment = malloc(rounded);
+	if (table->heatFlux == NULL || table->environment == NULL) {
+		orbitTableFree(table);
+		return -1;
+	}
+	table->size = rounded;
+	table->period = parameters->period;
+
+	double sum = 0.0;
+	for (size_t i = 0; i < rounded; i++) {
+		double phase = (double)i / (double)rounded;
+		OrbitPeriod environment = classifyPhase(parameters, phase);
+		double flux = parameters->earthInfrared;
+
+		if (environment != ORBIT_ECLIPSE) {
+			// Superfície em rotação: metade do fluxo solar em média, mais o albedo visível da Terra
+			double sunAngle = cos(TWO_PI * phase);
+			flux += parameters->solarFlux * 0.5 * (1.0 + sunAngle);
+			flux += parameters->solarFlux * parameters->albedo * fmax(0.0, sunAngle);
+		}
+
+		table->heatFlux[i] = (float)flux;
+		table->environment[i] = (uint8_t)environment;
+		sum += flux;
+	}
+	table->heatFlux[rounded] = table->heatFlux[0]; // Evita o teste de fim de tabela na interpolação
+	table->meanHeatFlux = (float)(sum / (double)rounded);
+	return 0;
+}
+
+// Função para libertar a tabela
+void orbitTableFree(OrbitTable* table) {
+	free(table->heatFlux);
+	free(table->environment);
+	memset(table, 0, sizeof(*table));
+}
+
+const char* orbitPeriodName(OrbitPeriod period) {
+	switch (period) {
+	case ORBIT_ECLIPSE:
+		return "ECLIPSE";
+	case ORBIT_SUN_EXPOSURE:
+		return "SUN_EXPOSURE";
+	default:
+		return "NORMAL";
+	}
+}
@@ -0,0 +1,64 @@
+﻿// OrbitEnvironment.h : Tabelas pré-calculadas do fluxo de calor ao longo da órbita.
+
+#ifndef ORBIT_ENVIRONMENT_H
+#define ORBIT_ENVIRONMENT_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+
+#define ORBIT_TABLE_DEFAULT_SIZE 1024   // Amostras por órbita (potência de 2)
+#define SOLAR_CONSTANT 1361.0           // Fluxo solar médio à distância da Terra (W/m²)
+
+// Períodos do ambiente, os mesmos do TSL
+typedef enum {
+	ORBIT_NORMAL,
+	ORBIT_ECLIPSE,
+	ORBIT_SUN_EXPOSURE
+} OrbitPeriod;
+
+// Estrutura OrbitParameters: descrição da órbita usada para gerar a tabela
+typedef struct {
+	double period;                // Período orbital (s)
+	double eclipseFraction;       // Fração da órbita na sombra da Terra
+	double sunExposureFraction;   // Fração da órbita com exposição solar direta (em torno da fase 0)
+	double solarFlux;             // W/m²
+	double albedo;                // Fração do fluxo solar refletida pela Terra
+	double earthInfrared;         // Emissão infravermelha da Terra (W/m²)
+} OrbitParameters;
+
+// Estrutura OrbitTable: só de leitura depois de construída, pode ser partilhada entre threads
+typedef struct OrbitTable {
+	size_t size;                  // Número de amostras (potência de 2)
+	double period;                // Período orbital (s)
+	float meanHeatFlux;           // Média do fluxo ao longo da órbita (W/m²)
+	float* heatFlux;              // size + 1 amostras (a última repete a primeira)
+	uint8_t* environment;         // OrbitPeriod de cada amostra
+} OrbitTable;
+
+// Funções do ambiente orbital
+void orbitDefaultParameters(OrbitParameters* parameters);
+int orbitTableBuild(OrbitTable* table, const OrbitParameters* parameters, size_t size);
+void orbitTableFree(OrbitTable* table);
+const char* orbitPeriodName(OrbitPeriod period);
+
+// Função para converter tempo simulado (s) em fase da órbita [0, 1)
+static inline double orbitPhaseAt(const OrbitTable* table, double time, double offset) {
+	double phase = time / table->period + offset;
+	return phase - floor(phase);
+}
+
+// Função para obter o fluxo de calor numa fase [0, 1) com interpolação linear
+static inline float orbitHeatFlux(const OrbitTable* table, double phase) {
+	double position = phase * (double)table->size;
+	size_t index = (size_t)position & (table->size - 1);
+	float fraction = (float)(position - floor(position));
+	return table->heatFlux[index] + (table->heatFlux[index + 1] - table->heatFlux[index]) * fraction;
+}
+
+// Função para obter o período do ambiente numa fase [0, 1)
+static inline OrbitPeriod orbitEnvironment(const OrbitTable* table, double phase) {
+	size_t index = (size_t)(phase * (double)table->size) & (table->size - 1);
+	return (OrbitPeriod)table->environment[index];
+}
+
+#endif // ORBIT_ENVIRONMENT_H
@@ -0,0 +1,208 @@
+﻿// PIDBatch.c : Kernel PID vetorizado para arrays de controladores.
+
+#include "PIDBatch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PID_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*PIDBatchKernel)(size_t begin, size_t end, const float* error, const float* temperature,
+	const float* Kp, const float* Ki, const float* Kd, const uint8_t* enabled,
+	float* previousError, float* integral, float* output);
+
+// Função escalar: processa o intervalo [begin, end) com o passo de referência
+static void pidBatchScalar(size_t begin, size_t end, const float* error, const float* temperature,
+	const float* Kp, const float* Ki, const float* Kd, const uint8_t* enabled,
+	float* previousError, float* integral, float* output) {
+	for (size_t i = begin; i < end; i++) {
+		if (enabled != NULL && !enabled[i]) {
+			output[i] = 0.0f;
+			continue;
+		}
+		output[i] = pidControlStep(error[i], temperature[i], Kp[i], Ki[i], Kd[i], &previousError[i], &integral[i]);
+	}
+}
+
+#ifdef PID_BATCH_X86
+
+// Seleciona a quando a máscara está ativa, b caso contrário
+static inline __m128 select128(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Converte 4 bytes de ativação numa máscara de 32 bits por elemento (apenas SSE2)
+static inline __m128 enabledMask128(const uint8_t* enabled) {
+	if (enabled == NULL) {
+		return _mm_castsi128_ps(_mm_set1_epi32(-1));
+	}
+	int32_t packed;
+	memcpy(&packed, enabled, sizeof(packed));
+	__m128i bytes = _mm_cvtsi32_si128(packed);
+	__m128i zero = _mm_setzero_si128();
+	__m128i words = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+	return _mm_castsi128_ps(_mm_cmpgt_epi32(words, zero));
+}
+
+// Função SSE: 4 controladores por iteração
+static void pidBatchSSE(size_t begin, size_t end, const float* error, const float* temperature,
+	const float* Kp, const float* Ki, const float* Kd, const uint8_t* enabled,
+	float* previousError, float* integral, float* output) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxTemperature = _mm_set1_ps(MAX_TEMPERATURE);
+	const __m128 minTemperature = _mm_set1_ps(MIN_TEMPERATURE);
+	const __m128 maxOutput = _mm_set1_ps(MAX_OUTPUT);
+	const __m128 minOutput = _mm_set1_ps(MIN_OUTPUT);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 active = enabledMask128(enabled != NULL ? enabled + i : NULL);
+		__m128 e = _mm_loadu_ps(error + i);
+		__m128 t = _mm_loadu_ps(temperature + i);
+		__m128 prev = _mm_loadu_ps(previousError + i);
+		__m128 in = _mm_loadu_ps(integral + i);
+
+		__m128 derivative = _mm_sub_ps(e, prev);
+
+		// Anti-windup sem ramificações: as três hipóteses são calculadas e combinadas por máscara
+		__m128 saturatedHigh = _mm_and_ps(_mm_cmpge_ps(t, maxTemperature), _mm_cmpgt_ps(e, zero));
+		__m128 saturatedLow = _mm_and_ps(_mm_cmple_ps(t, minTemperature), _mm_cmplt_ps(e, zero));
+		__m128 accumulated = _mm_add_ps(in, e);
+		__m128 newIntegral = select128(saturatedHigh, _mm_max_ps(in, zero),
+			select128(saturatedLow, _mm_min_ps(in, zero), accumulated));
+
+		__m128 out = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(Kp + i), e),
+			_mm_mul_ps(_mm_loadu_ps(Ki + i), newIntegral)),
+			_mm_mul_ps(_mm_loadu_ps(Kd + i), derivative));
+		out = _mm_max_ps(minOutput, _mm_min_ps(maxOutput, out));
+
+		_mm_storeu_ps(previousError + i, select128(active, e, prev));
+		_mm_storeu_ps(integral + i, select128(active, newIntegral, in));
+		_mm_storeu_ps(output + i, _mm_and_ps(active, out));
+	}
+
+	pidBatchScalar(i, end, error, temperature, Kp, Ki, Kd, enabled, previousError, integral, output);
+}
+
+// Seleciona a quando a máscara está ativa, b caso contrário
+__attribute__((target("avx2")))
+static inline __m256 select256(__m256 mask, __m256 a, __m256 b) {
+	return _mm256_blendv_ps(b, a, mask);
+}
+
+// Converte 8 bytes de ativação numa máscara de 32 bits por elemento
+__attribute__((target("avx2")))
+static inline __m256 enabledMask256(const uint8_t* enabled) {
+	if (enabled == NULL) {
+		return _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	}
+	__m256i words = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)enabled));
+	return _mm256_castsi256_ps(_mm256_cmpgt_epi32(words, _mm256_setzero_si256()));
+}
+
+// Função AVX2: 8 controladores por iteração
+__attribute__((target("avx2")))
+static void pidBatchAVX2(size_t begin, size_t end, const float* error, const float* temperature,
+	const float* Kp, const float* Ki, const float* Kd, const uint8_t* enabled,
+	float* previousError, float* integral, float* output) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 maxTemperature = _mm256_set1_ps(MAX_TEMPERATURE);
+	const __m256 minTemperature = _mm256_set1_ps(MIN_TEMPERATURE);
+	const __m256 maxOutput = _mm256_set1_ps(MAX_OUTPUT);
+	const __m256 minOutput = _mm256_set1_ps(MIN_OUTPUT);
+
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 active = enabledMask256(enabled != NULL ? enabled + i : NULL);
+		__m256 e = _mm256_loadu_ps(error + i);
+		__m256 t = _mm256_loadu_ps(temperature + i);
+		__m256 prev = _mm256_loadu_ps(previousError + i);
+		__m256 in = _mm256_loadu_ps(integral + i);
+
+		__m256 derivative = _mm256_sub_ps(e, prev);
+
+		__m256 saturatedHigh = _mm256_and_ps(_mm256_cmp_ps(t, maxTemperature, _CMP_GE_OQ),
+			_mm256_cmp_ps(e, zero, _CMP_GT_OQ));
+		__m256 saturatedLow = _mm256_and_ps(_mm256_cmp_ps(t, minTemperature, _CMP_LE_OQ),
+			_mm256_cmp_ps(e, zero, _CMP_LT_OQ));
+		__m256 accumulated = _mm256_add_ps(in, e);
+		__m256 newIntegral = select256(saturatedHigh, _mm256_max_ps(in, zero),
+			select256(saturatedLow, _mm256_min_ps(in, zero), accumulated));
+
+		// Sem FMA: a ordem das operações é a mesma do passo escalar
+		__m256 out = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(Kp + i), e),
+			_mm256_mul_ps(_mm256_loadu_ps(Ki + i), newIntegral)),
+			_mm256_mul_ps(_mm256_loadu_ps(Kd + i), derivative));
+		out = _mm256_max_ps(minOutput, _mm256_min_ps(maxOutput, out));
+
+		_mm256_storeu_ps(previousError + i, select256(active, e, prev));
+		_mm256_storeu_ps(integral + i, select256(active, newIntegral, in));
+		_mm256_storeu_ps(output + i, _mm256_and_ps(active, out));
+	}
+
+	pidBatchSSE(i, end, error, temperature, Kp, Ki, Kd, enabled, previousError, integral, output);
+}
+
+#endif // PID_BATCH_X86
+
+static PIDBatchImplementation selectedImplementation;
+static bool implementationSelected = false;
+
+// Função para detetar a melhor implementação suportada pelo processador
+static PIDBatchImplementation detectImplementation() {
+#ifdef PID_BATCH_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return PID_BATCH_AVX2;
+	}
+	return PID_BATCH_SSE;
+#else
+	return PID_BATCH_SCALAR;
+#endif
+}
+
+PIDBatchImplementation pidBatchGetImplementation() {
+	if (!implementationSelected) {
+		selectedImplementation = detectImplementation();
+		implementationSelected = true;
+	}
+	return selectedImplementation;
+}
+
+// Função para forçar uma implementação (limitada ao que o processador suporta)
+void pidBatchSetImplementation(PIDBatchImplementation implementation) {
+	PIDBatchImplementation best = detectImplementation();
+	selectedImplementation = implementation > best ? best : implementation;
+	implementationSelected = true;
+}
+
+const char* pidBatchImplementationName(PIDBatchImplementation implementation) {
+	switch (implementation) {
+	case PID_BATCH_AVX2:
+		return "AVX2";
+	case PID_BATCH_SSE:
+		return "SSE";
+	default:
+		return "scalar";
+	}
+}
+
+// Função para calcular a saída PID de um array de controladores
+void calculatePIDControlBatch(size_t count, const float* error, const float* temperature,
+	const float* Kp, const float* Ki, const float* Kd, const uint8_t* enabled,
+	float* previousError, float* integral, float* output) {
+	PIDBatchKernel kernel = pidBatchScalar;
+#ifdef PID_BATCH_X86
+	switch (pidBatchGetImplementation()) {
+	case PID_BATCH_AVX2:
+		kernel = pidBatchAVX2;
+		break;
+	case PID_BATCH_SSE:
+		kernel = pidBatchSSE;
+		break;
+	default:
+		break;
+	}
+#endif
+	kernel(0, count, error, temperature, Kp, Ki, Kd, enabled, previousError, integral, output);
+}
@@ -0,0 +1,53 @@
+﻿// PIDBatch.h : Cálculo PID em lote (AVX2/SSE com alternativa escalar).
+
+#ifndef PID_BATCH_H
+#define PID_BATCH_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+
+// Implementações disponíveis do kernel em lote
+typedef enum {
+	PID_BATCH_SCALAR,
+	PID_BATCH_SSE,
+	PID_BATCH_AVX2
+} PIDBatchImplementation;
+
+// Passo PID de referência, partilhado por calculatePIDControl() e pelo kernel em lote
+// Os resultados vetoriais são iguais bit a bit aos deste passo
+static inline float pidControlStep(float error, float temperature, float Kp, float Ki, float Kd,
+	float* previousError, float* integral) {
+	float derivative = error - *previousError;
+	*previousError = error;
+
+	// Anti-windup: congelar a integral quando a temperatura está saturada
+	if (temperature >= MAX_TEMPERATURE && error > 0) {
+		*integral = (*integral > 0.0f) ? *integral : 0.0f;
+	}
+	else if (temperature <= MIN_TEMPERATURE && error < 0) {
+		*integral = (*integral < 0.0f) ? *integral : 0.0f;
+	}
+	else {
+		*integral += error;
+	}
+
+	float output = Kp * error + Ki * *integral + Kd * derivative;
+	if (output > MAX_OUTPUT) {
+		output = MAX_OUTPUT;
+	}
+	else if (output < MIN_OUTPUT) {
+		output = MIN_OUTPUT;
+	}
+	return output;
+}
+
+// Funções do kernel em lote
+// enabled pode ser NULL (todos ativos); zonas inativas mantêm o estado e têm saída 0
+void calculatePIDControlBatch(size_t count, const float* error, const float* temperature,
+	const float* Kp, const float* Ki, const float* Kd, const uint8_t* enabled,
+	float* previousError, float* integral, float* output);
+PIDBatchImplementation pidBatchGetImplementation();
+void pidBatchSetImplementation(PIDBatchImplementation implementation);
+const char* pidBatchImplementationName(PIDBatchImplementation implementation);
+
+#endif // PID_BATCH_H
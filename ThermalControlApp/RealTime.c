@@ -0,0 +1,183 @@
+﻿// RealTime.c : Cada passo é tentado mesmo que o anterior falhe (sem privilégios, por exemplo),
+// e o relatório diz quais ficaram em vigor; o modo é opcional e nunca impede o arranque.
+
+#ifdef __linux__
+#define _GNU_SOURCE // pthread_setaffinity_np, CPU_SET
+#endif
+
+#include "RealTime.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Função para interpretar "CPU[:PRIORIDADE]"
+bool realTimeParse(const char* spec, RealTimeConfig* config) {
+	char* end;
+	long cpu = strtol(spec, &end, 10);
+	if (end == spec || cpu < 0) {
+		return false;
+	}
+	long priority = REALTIME_DEFAULT_PRIORITY;
+	if (*end == ':') {
+		const char* value = end + 1;
+		priority = strtol(value, &end, 10);
+		if (end == value) {
+			return false;
+		}
+	}
+	if (*end != '\0') {
+		return false;
+	}
+	config->enabled = true;
+	config->cpu = (int)cpu;
+	config->priority = (int)priority;
+	return true;
+}
+
+// Função para tocar na pilha que o ciclo vai usar (as páginas ficam residentes com mlockall)
+static __attribute__((noinline)) void prefaultStack() {
+	volatile char stack[REALTIME_STACK_PREFAULT];
+	for (size_t i = 0; i < sizeof(stack); i += 4096) {
+		stack[i] = 0;
+	}
+}
+
+// Função para deixar reservado heap já residente, para que malloc no ciclo não provoque faltas de página
+static int prefaultHeap() {
+#ifdef __GLIBC__
+	// Sem devolver memória ao sistema nem usar mmap, o bloco libertado continua no heap
+	if (mallopt(M_TRIM_THRESHOLD, -1) == 0 || mallopt(M_MMAP_MAX, 0) == 0) {
+		return ENOTSUP;
+	}
+#endif
+	char* reserve = malloc(REALTIME_HEAP_PREFAULT);
+	if (reserve == NULL) {
+		return ENOMEM;
+	}
+	memset(reserve, 0, REALTIME_HEAP_PREFAULT);
+	free(reserve);
+	return 0;
+}
+
+#ifdef __linux__
+// Função para guardar os núcleos permitidos ao processo
+static void saveAllowedCpus(const cpu_set_t* allowed, RealTimeReport* report) {
+	for (int cpu = 0; cpu < REALTIME_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+		if (CPU_ISSET(cpu, allowed)) {
+			report->allowedCpus[cpu / 64] |= (uint64_t)1 << (cpu % 64);
+		}
+	}
+}
+#endif
+
+// Função para colocar a thread atual em tempo real (chamada pela thread do ciclo de controlo)
+void realTimeEnter(const RealTimeConfig* config, RealTimeReport* report) {
+	memset(report, 0, sizeof(*report));
+
+#ifdef __linux__
+	// A máscara é guardada antes de a thread ser fixada: é dela que saem os núcleos das outras threads
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+		report->affinity = errno;
+	}
+	else {
+		saveAllowedCpus(&allowed, report);
+		if (config->cpu >= CPU_SETSIZE || !CPU_ISSET(config->cpu, &allowed)) {
+			report->affinity = EINVAL; // Núcleo inexistente ou fora do cpuset do processo
+		}
+		else {
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(config->cpu, &set);
+			report->affinity = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		}
+	}
+#else
+	report->affinity = ENOTSUP;
+#endif
+
+	if (config->priority < sched_get_priority_min(SCHED_FIFO) || config->priority > sched_get_priority_max(SCHED_FIFO)) {
+		report->priority = EINVAL;
+	}
+	else {
+		struct sched_param param = { .sched_priority = config->priority };
+		report->priority = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	}
+
+	// MCL_FUTURE também bloqueia as páginas tocadas a seguir
+	report->memoryLock = mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : errno;
+	prefaultStack();
+	report->prefault = prefaultHeap();
+}
+
+// Função para afastar uma thread sem tempo real (registo, menu) do núcleo reservado
+int realTimeMoveOffCore(const RealTimeConfig* config, pthread_t thread, RealTimeReport* report) {
+	int result;
+#ifdef __linux__
+	// Todos os núcleos permitidos ao processo menos o reservado; com um só núcleo não há para onde ir
+	// A máscara é a guardada por realTimeEnter: a da thread que chama já só tem o núcleo reservado
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu = 0; cpu < REALTIME_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+		if (cpu != config->cpu && (report->allowedCpus[cpu / 64] >> (cpu % 64) & 1) != 0) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	result = CPU_COUNT(&set) == 0 ? ENODEV : pthread_setaffinity_np(thread, sizeof(set), &set);
+#else
+	result = ENOTSUP;
+#endif
+	if (result != 0 && report->offCore == 0) {
+		report->offCore = result;
+	}
+	report->offCoreThreads++;
+	return result;
+}
+
+// Função para criar, a partir da thread em tempo real, uma thread sem tempo real (consola)
+// A política é pedida explicitamente para não herdar SCHED_FIFO, e a pilha é pequena porque o mlockall
+// com MCL_FUTURE a tornaria residente
+int realTimeCreateThread(const RealTimeConfig* config, pthread_t* thread, void* (*start)(void*), void* arg,
+	RealTimeReport* report) {
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	struct sched_param param = { .sched_priority = 0 };
+	pthread_attr_setinheritsched(&attributes, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attributes, SCHED_OTHER);
+	pthread_attr_setschedparam(&attributes, &param);
+	pthread_attr_setstacksize(&attributes, REALTIME_THREAD_STACK);
+	int result = pthread_create(thread, &attributes, start, arg);
+	pthread_attr_destroy(&attributes);
+	if (result == 0) {
+		realTimeMoveOffCore(config, *thread, report);
+	}
+	return result;
+}
+
+// Função para escrever o resultado de um passo
+static void printStep(const char* name, int error) {
+	printf("  %-28s %s\n", name, error == 0 ? "ok" : error == ENODEV ? "no other CPU available" : strerror(error));
+}
+
+// Função para mostrar quais passos do modo de tempo real ficaram em vigor
+void realTimePrintReport(const RealTimeConfig* config, const RealTimeReport* report) {
+	char name[64];
+	printf("Real-time mode:\n");
+	snprintf(name, sizeof(name), "CPU affinity (core %d)", config->cpu);
+	printStep(name, report->affinity);
+	snprintf(name, sizeof(name), "SCHED_FIFO priority %d", config->priority);
+	printStep(name, report->priority);
+	printStep("Memory locked (mlockall)", report->memoryLock);
+	printStep("Stack and heap pre-faulted", report->prefault);
+	if (report->offCoreThreads > 0) {
+		snprintf(name, sizeof(name), "%d other thread(s) off core", report->offCoreThreads);
+		printStep(name, report->offCore);
+	}
+	fflush(stdout);
+}
@@ -0,0 +1,43 @@
+﻿// RealTime.h : Modo de tempo real opcional (--rt): afinidade de CPU, SCHED_FIFO e memória bloqueada.
+
+#ifndef REAL_TIME_H
+#define REAL_TIME_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define REALTIME_DEFAULT_PRIORITY 80               // Prioridade SCHED_FIFO por omissão
+#define REALTIME_STACK_PREFAULT (256 * 1024)       // Bytes da pilha tocados antes do primeiro ciclo
+#define REALTIME_HEAP_PREFAULT (1024 * 1024)       // Bytes do heap reservados e tocados
+#define REALTIME_THREAD_STACK (256 * 1024)         // Pilha das threads criadas depois do mlockall
+#define REALTIME_MAX_CPUS 1024                     // Núcleos representáveis na máscara guardada (CPU_SETSIZE)
+
+// Estrutura RealTimeConfig
+typedef struct {
+	bool enabled;
+	int cpu;                // Núcleo reservado ao ciclo de controlo
+	int priority;           // Prioridade SCHED_FIFO
+} RealTimeConfig;
+
+// Estrutura RealTimeReport: 0 = conseguido, senão o errno do passo que falhou
+typedef struct {
+	int affinity;
+	int priority;
+	int memoryLock;
+	int prefault;
+	int offCore;            // Threads sem tempo real afastadas do núcleo reservado
+	int offCoreThreads;
+	uint64_t allowedCpus[REALTIME_MAX_CPUS / 64];   // Núcleos permitidos ao processo antes de fixar o ciclo
+} RealTimeReport;
+
+// Funções
+bool realTimeParse(const char* spec, RealTimeConfig* config);
+void realTimeEnter(const RealTimeConfig* config, RealTimeReport* report);
+int realTimeMoveOffCore(const RealTimeConfig* config, pthread_t thread, RealTimeReport* report);
+int realTimeCreateThread(const RealTimeConfig* config, pthread_t* thread, void* (*start)(void*), void* arg,
+	RealTimeReport* report);
+void realTimePrintReport(const RealTimeConfig* config, const RealTimeReport* report);
+
+#endif // REAL_TIME_H
@@ -0,0 +1,270 @@
+﻿// Replay.c : Cada amostra gravada é convertida numa trama WIRE_TEMPERATURES e passa pelo mesmo caminho do
+// modo ao vivo: pipe, frameReaderNext, storeInfoFrame e o passo PID do ciclo (controlStep) em cada zona.
+// O ritmo segue os intervalos entre timestamps gravados, divididos por --warp (max = sem espera).
+
+#include "Replay.h"
+#include "FrameStream.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Função para abrir a fonte; o formato colunar é reconhecido pelo magic
+int replaySourceOpen(ReplaySource* source, const char* path) {
+	memset(source, 0, sizeof(*source));
+	source->fd = open(path, O_RDONLY);
+	struct stat info;
+	if (source->fd < 0 || fstat(source->fd, &info) != 0) {
+		perror(path);
+		if (source->fd >= 0) {
+			close(source->fd);
+		}
+		return -1;
+	}
+
+	uint32_t magic = 0;
+	if (pread(source->fd, &magic, sizeof(magic), 0) == (ssize_t)sizeof(magic) && magic == STORE_MAGIC) {
+		close(source->fd);
+		source->store = true;
+		source->block = malloc(sizeof(*source->block));
+		if (source->block == NULL || telemetryStoreOpen(&source->reader, path) != 0) {
+			free(source->block);
+			return -1;
+		}
+		return 0;
+	}
+
+	source->size = (size_t)info.st_size;
+	source->data = source->size > 0 ? mmap(NULL, source->size, PROT_READ, MAP_PRIVATE, source->fd, 0) : "";
+	if (source->data == MAP_FAILED) {
+		perror("Failed to map CSV");
+		close(source->fd);
+		return -1;
+	}
+	if (source->size > 0) {
+		madvise((void*)source->data, source->size, MADV_SEQUENTIAL);
+	}
+	return 0;
+}
+
+// Função para ler a próxima linha; devolve 1, 0 no fim ou -1 com um bloco corrompido
+int replaySourceNext(ReplaySource* source, TelemetryRecord* record) {
+	if (source->store) {
+		TelemetryBlock* block = source->block;
+		if (source->row == block->rowCount) {
+			if (source->blockIndex == source->reader.header.blockCount) {
+				return 0;
+			}
+			if (telemetryStoreReadBlock(&source->reader, source->blockIndex++, block) != 0) {
+				return -1;
+			}
+			source->row = 0;
+		}
+		uint32_t i = source->row++;
+		record->timestamp = block->timestamps[i];
+		record->error = block->errors[i];
+		for (int s = 0; s < STORE_SENSORS; s++) {
+			record->temperatures[s] = block->temperatures[s][i];
+		}
+		record->heaters = block->heaters[i];
+		record->environment = record->error ? NULL : block->dictionary[block->codes[i]];
+		record->message = record->error ? block->dictionary[block->codes[i]] : NULL;
+		return 1;
+	}
+
+	const char* end = source->data + source->size;
+	while (source->position < source->size) {
+		const char* line = source->data + source->position;
+		const char* newline = memchr(line, '\n', (size_t)(end - line));
+		const char* lineEnd = newline != NULL ? newline : end;
+		source->position = (size_t)((newline != NULL ? newline + 1 : end) - source->data);
+		source->lineNumber++;
+		if (lineEnd > line && lineEnd[-1] == '\r') {
+			lineEnd--;
+		}
+		if (lineEnd == line || (source->lineNumber == 1 && strncmp(line, "THERM-01", 8) == 0)) {
+			continue;
+		}
+		if (telemetryStoreParseCsvLine(line, lineEnd, record, source->text)) {
+			return 1;
+		}
+		source->rejected++;
+	}
+	return 0;
+}
+
+void replaySourceClose(ReplaySource* source) {
+	if (source->store) {
+		telemetryStoreCloseReader(&source->reader);
+		free(source->block);
+		return;
+	}
+	if (source->size > 0) {
+		munmap((void*)source->data, source->size);
+	}
+	close(source->fd);
+}
+
+// Função para passar uma trama pelo pipe da reprodução, como a infoPipe do modo ao vivo
+static bool sendThroughPipe(int fd, FrameReader* reader, const WireFrame* frame, WireFrame* received) {
+	uint8_t buffer[WIRE_MAX_FRAME_SIZE];
+	size_t size = wireEncodeFrame(frame, buffer, sizeof(buffer));
+	if (size == 0 || write(fd, buffer, size) != (ssize_t)size) {
+		return false;
+	}
+	while (!frameReaderNext(reader, received)) {
+		if (frameReaderFill(reader) <= 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Função da reprodução (--replay): mede o tempo de cada amostra desde a trama enviada até à decisão
+int runReplay(const char* path, double timeWarp, const PIDController* pid, float setpoint, const char* outputPath) {
+	ReplaySource source;
+	if (replaySourceOpen(&source, path) != 0) {
+		return EXIT_FAILURE;
+	}
+	FILE* output = NULL;
+	if (outputPath != NULL) {
+		output = fopen(outputPath, "w");
+		if (output == NULL) {
+			perror(outputPath);
+			replaySourceClose(&source);
+			return EXIT_FAILURE;
+		}
+		setvbuf(output, NULL, _IOFBF, 1 << 20);
+		fprintf(output, "TIMESTAMP, HTR-1, HTR-2, HTR-3, HTR-4\n");
+	}
+	LatencyHistogram* latencies = malloc(sizeof(*latencies));
+	FrameReader* reader = malloc(sizeof(*reader));
+	int channel[2] = { -1, -1 };
+	if (latencies == NULL || reader == NULL || pipe(channel) == -1) {
+		perror("Failed to prepare replay");
+		free(latencies);
+		free(reader);
+		if (output != NULL) {
+			fclose(output);
+		}
+		replaySourceClose(&source);
+		return EXIT_FAILURE;
+	}
+	latencyHistogramInit(latencies);
+	frameReaderInit(reader, channel[0]);
+
+	// Quatro zonas do TCF, uma por termístor e aquecedor, com os ganhos do controlador ao vivo
+	PIDController zones[STORE_SENSORS];
+	for (int z = 0; z < STORE_SENSORS; z++) {
+		zones[z] = (PIDController){ pid->Kp, pid->Ki, pid->Kd, 0.0f, 0.0f };
+	}
+
+	unsigned long samples = 0, errorRows = 0, changes = 0, frameErrors = 0;
+	unsigned long heaterOn[STORE_SENSORS] = { 0 }, recordedOn[STORE_SENSORS] = { 0 }, agreements[STORE_SENSORS] = { 0 };
+	uint64_t maxLag = 0;
+	int lastDecision = -1;
+	int64_t previousTimestamp = 0;
+	uint32_t sequence = 0;
+	bool paced = timeWarp > 0.0;
+	uint64_t start = latencyNow();
+	uint64_t deadline = start;
+	TelemetryRecord record;
+	int status;
+
+	while ((status = replaySourceNext(&source, &record)) == 1) {
+		if (record.error) {
+			errorRows++;
+			continue;
+		}
+		// Espera o intervalo gravado desde a amostra anterior, dividido pelo fator de aceleração
+		// Um timestamp que recua (mudança da hora local) não acrescenta espera
+		if (paced) {
+			int64_t interval = samples > 0 ? record.timestamp - previousTimestamp : 0;
+			if (interval > 0) {
+				deadline += (uint64_t)((double)interval * 1e6 / timeWarp);
+			}
+			uint64_t now = latencyNow();
+			if (deadline > now) {
+				struct timespec wakeup = { (time_t)(deadline / 1000000000ull), (long)(deadline % 1000000000ull) };
+				clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL);
+			}
+			else if (now - deadline > maxLag) {
+				maxLag = now - deadline;
+			}
+		}
+
+		previousTimestamp = record.timestamp;
+
+		// Trama como a do TSL na infoPipe, com as temperaturas e os aquecedores gravados
+		uint64_t before = latencyNow();
+		WireFrame frame = { WIRE_TEMPERATURES, STORE_SENSORS, STORE_SENSORS, sequence++, before, record.heaters, { 0 } };
+		memcpy(frame.values, record.temperatures, sizeof(record.temperatures));
+		WireFrame received;
+		if (!sendThroughPipe(channel[1], reader, &frame, &received)) {
+			frameErrors++;
+			continue;
+		}
+		storeInfoFrame(&received);
+		const WireFrame* temperatures = lastInfoTemperatures();
+		int decision = 0;
+		for (int z = 0; z < STORE_SENSORS; z++) {
+			decision |= (controlStep(&zones[z], setpoint - temperatures->values[z]) > 0.0f) << z;
+		}
+		latencyHistogramRecord(latencies, latencyNow() - before);
+		samples++;
+		if (lastDecision >= 0 && decision != lastDecision) {
+			changes++;
+		}
+		lastDecision = decision;
+		for (int z = 0; z < STORE_SENSORS; z++) {
+			bool on = (decision >> z) & 1;
+			bool recorded = (record.heaters >> z) & 1;
+			heaterOn[z] += on;
+			recordedOn[z] += recorded;
+			agreements[z] += on == recorded;
+		}
+		if (output != NULL) {
+			char timestamp[STORE_TIMESTAMP_LENGTH + 1];
+			telemetryStoreFormatTimestamp(timestamp, record.timestamp);
+			fprintf(output, "%s, %s, %s, %s, %s\n", timestamp, decision & 1 ? "On" : "Off", decision & 2 ? "On" : "Off",
+				decision & 4 ? "On" : "Off", decision & 8 ? "On" : "Off");
+		}
+	}
+	double seconds = (double)(latencyNow() - start) / 1e9;
+
+	int result = status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	if (output != NULL && fclose(output) != 0) {
+		perror(outputPath);
+		result = EXIT_FAILURE;
+	}
+
+	printf("Replayed %lu samples from %s in %.3f s (%.0f samples/s), pacing: ", samples, path, seconds,
+		seconds > 0.0 ? (double)samples / seconds : 0.0);
+	if (paced) {
+		printf("%gx recorded time, max lag %.3f ms\n", timeWarp, (double)maxLag / 1e6);
+	}
+	else {
+		printf("as fast as possible\n");
+	}
+	if (errorRows > 0 || source.rejected > 0 || frameErrors > 0) {
+		printf("Skipped %lu error rows, %lu malformed lines, %lu samples lost in the pipe\n", errorRows, source.rejected,
+			frameErrors);
+	}
+	if (samples > 0) {
+		printf("Latency per sample (frame + pipe + PID): min %llu ns, mean %.0f ns, p50 %llu ns, p99 %llu ns, "
+			"p99.9 %llu ns, max %llu ns\n", (unsigned long long)atomic_load(&latencies->min), latencyHistogramMean(latencies),
+			(unsigned long long)latencyHistogramPercentile(latencies, 50.0),
+			(unsigned long long)latencyHistogramPercentile(latencies, 99.0),
+			(unsigned long long)latencyHistogramPercentile(latencies, 99.9), (unsigned long long)atomic_load(&latencies->max));
+		for (int z = 0; z < STORE_SENSORS; z++) {
+			printf("HTR-%d: on %.1f%% (recorded %.1f%%), agrees with recording %.1f%%\n", z + 1,
+				100.0 * (double)heaterOn[z] / (double)samples, 100.0 * (double)recordedOn[z] / (double)samples,
+				100.0 * (double)agreements[z] / (double)samples);
+		}
+		printf("Heater decision changes: %lu\n", changes);
+	}
+	close(channel[0]);
+	close(channel[1]);
+	free(reader);
+	free(latencies);
+	replaySourceClose(&source);
+	return result;
+}
@@ -0,0 +1,34 @@
+﻿// Replay.h : Reprodução da telemetria gravada pelo TSL (data.csv ou formato colunar) através do controlador.
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "ThermalControlApp.h"
+#include "TelemetryStore.h"
+#include "LatencyHistogram.h"
+
+// Estrutura ReplaySource: linhas de um data.csv mapeado ou de um ficheiro do formato colunar
+typedef struct {
+	bool store;
+	// data.csv
+	int fd;
+	const char* data;
+	size_t size;
+	size_t position;
+	unsigned long lineNumber;
+	unsigned long rejected;     // Linhas mal formadas
+	char text[STORE_MAX_STRING];
+	// Formato colunar
+	TelemetryStoreReader reader;
+	TelemetryBlock* block;
+	uint32_t blockIndex;
+	uint32_t row;
+} ReplaySource;
+
+// Funções da reprodução
+int replaySourceOpen(ReplaySource* source, const char* path);
+int replaySourceNext(ReplaySource* source, TelemetryRecord* record);
+void replaySourceClose(ReplaySource* source);
+int runReplay(const char* path, double timeWarp, const PIDController* pid, float setpoint, const char* outputPath);
+
+#endif // REPLAY_H
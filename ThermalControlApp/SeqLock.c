@@ -0,0 +1,62 @@
+﻿// SeqLock.c : O escritor nunca espera: torna a sequência ímpar, copia e torna-a par outra vez.
+// O leitor repete a cópia se a sequência mudou ou era ímpar (escrita a meio).
+
+#include "SeqLock.h"
+#include <sched.h>
+#include <string.h>
+
+// Função para inicializar o seqlock com o primeiro valor; recusa valores maiores do que SEQLOCK_MAX_SIZE
+int seqLockInit(SeqLock* lock, const void* value, size_t size) {
+	if (size > SEQLOCK_MAX_SIZE) {
+		return -1;
+	}
+	atomic_init(&lock->sequence, 0);
+	atomic_init(&lock->retries, 0);
+	lock->size = size;
+	uint64_t buffer[SEQLOCK_MAX_WORDS] = { 0 };
+	memcpy(buffer, value, size);
+	for (size_t i = 0; i < SEQLOCK_MAX_WORDS; i++) {
+		atomic_init(&lock->words[i], buffer[i]);
+	}
+	return 0;
+}
+
+// Função para publicar um valor novo (só um escritor de cada vez)
+void seqLockWrite(SeqLock* lock, const void* value) {
+	uint64_t buffer[SEQLOCK_MAX_WORDS] = { 0 };
+	size_t words = (lock->size + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	memcpy(buffer, value, lock->size);
+
+	uint32_t sequence = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+	atomic_store_explicit(&lock->sequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	for (size_t i = 0; i < words; i++) {
+		atomic_store_explicit(&lock->words[i], buffer[i], memory_order_relaxed);
+	}
+	atomic_store_explicit(&lock->sequence, sequence + 2, memory_order_release);
+}
+
+// Função para obter uma cópia consistente do último valor publicado
+void seqLockRead(SeqLock* lock, void* value) {
+	uint64_t buffer[SEQLOCK_MAX_WORDS];
+	size_t words = (lock->size + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	unsigned spins = 0;
+	for (;;) {
+		uint32_t before = atomic_load_explicit(&lock->sequence, memory_order_acquire);
+		if ((before & 1) == 0) {
+			for (size_t i = 0; i < words; i++) {
+				buffer[i] = atomic_load_explicit(&lock->words[i], memory_order_relaxed);
+			}
+			atomic_thread_fence(memory_order_acquire);
+			if (atomic_load_explicit(&lock->sequence, memory_order_relaxed) == before) {
+				break;
+			}
+		}
+		atomic_fetch_add_explicit(&lock->retries, 1, memory_order_relaxed);
+		// O escritor pode ter sido interrompido a meio; com um só CPU só avança se cedermos a vez
+		if (++spins % SEQLOCK_SPINS_BEFORE_YIELD == 0) {
+			sched_yield();
+		}
+	}
+	memcpy(value, buffer, lock->size);
+}
@@ -0,0 +1,27 @@
+﻿// SeqLock.h : Publicação sem locks de um valor pequeno, com um único escritor e vários leitores.
+
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SEQLOCK_MAX_WORDS 16        // Tamanho máximo do valor (em palavras de 64 bits)
+#define SEQLOCK_MAX_SIZE (SEQLOCK_MAX_WORDS * sizeof(uint64_t))
+#define SEQLOCK_SPINS_BEFORE_YIELD 64
+
+// Estrutura SeqLock: o valor é copiado palavra a palavra com acessos atómicos relaxados
+typedef struct {
+	_Alignas(64) _Atomic uint32_t sequence;     // Ímpar enquanto uma escrita decorre
+	_Atomic uint64_t words[SEQLOCK_MAX_WORDS];
+	size_t size;
+	_Atomic unsigned long retries;              // Leituras repetidas por coincidirem com uma escrita
+} SeqLock;
+
+// Funções do seqlock
+int seqLockInit(SeqLock* lock, const void* value, size_t size);
+void seqLockWrite(SeqLock* lock, const void* value);
+void seqLockRead(SeqLock* lock, void* value);
+
+#endif // SEQ_LOCK_H
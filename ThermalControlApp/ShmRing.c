@@ -0,0 +1,339 @@
+﻿// ShmRing.c : O produtor publica com uma escrita release em head e o consumidor liberta com
+// uma escrita release em tail; no caminho normal não há chamadas ao sistema.
+// O eventfd só é escrito quando o consumidor anunciou que vai dormir (consumerWaiting).
+
+#define _GNU_SOURCE // memfd_create
+
+#include "ShmRing.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include "WireProtocol.h"
+
+// Estrutura ShmRingSlot: tamanho da mensagem seguido dos dados
+typedef struct {
+	uint32_t size;
+	uint8_t data[];
+} ShmRingSlot;
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t regionSize(uint32_t slotCount, uint32_t slotStride) {
+	return alignUp(sizeof(ShmRingShared), SHM_RING_CACHE_LINE) + (size_t)slotCount * slotStride;
+}
+
+// Função para mapear a região e preencher a vista local
+static int mapRing(ShmRing* ring, int memFd, size_t size) {
+	void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+	if (region == MAP_FAILED) {
+		perror("Failed to map shared ring");
+		return -1;
+	}
+	ring->shared = region;
+	ring->slots = (uint8_t*)region + alignUp(sizeof(ShmRingShared), SHM_RING_CACHE_LINE);
+	ring->mappedSize = size;
+	return 0;
+}
+
+// Função para criar um anel novo; slotCount é arredondado para a potência de 2 seguinte
+int shmRingCreate(ShmRing* ring, uint32_t slotCount, uint32_t slotSize) {
+	uint32_t count = 1;
+	while (count < slotCount) {
+		count <<= 1;
+	}
+	uint32_t stride = (uint32_t)alignUp(sizeof(ShmRingSlot) + slotSize, SHM_RING_CACHE_LINE);
+	size_t size = regionSize(count, stride);
+
+	ring->memFd = memfd_create("stcs_ring", MFD_CLOEXEC);
+	if (ring->memFd == -1) {
+		perror("Failed to create shared memory");
+		return -1;
+	}
+	if (ftruncate(ring->memFd, (off_t)size) == -1 || mapRing(ring, ring->memFd, size) != 0) {
+		perror("Failed to size shared memory");
+		close(ring->memFd);
+		return -1;
+	}
+
+	ring->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ring->eventFd == -1) {
+		perror("Failed to create eventfd");
+		munmap(ring->shared, ring->mappedSize);
+		close(ring->memFd);
+		return -1;
+	}
+
+	atomic_init(&ring->shared->head, 0);
+	atomic_init(&ring->shared->tail, 0);
+	atomic_init(&ring->shared->consumerWaiting, 1);
+	ring->shared->slotCount = count;
+	ring->shared->slotSize = slotSize;
+	ring->shared->slotStride = stride;
+	return 0;
+}
+
+// Função para abrir, noutro processo, um anel criado com shmRingCreate
+int shmRingAttach(ShmRing* ring, int memFd, int eventFd) {
+	ShmRingShared header;
+	if (pread(memFd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+		perror("Failed to read shared ring header");
+		return -1;
+	}
+	ring->memFd = memFd;
+	ring->eventFd = eventFd;
+	return mapRing(ring, memFd, regionSize(header.slotCount, header.slotStride));
+}
+
+void shmRingDestroy(ShmRing* ring) {
+	munmap(ring->shared, ring->mappedSize);
+	close(ring->memFd);
+	close(ring->eventFd);
+	ring->shared = NULL;
+}
+
+static ShmRingSlot* slotAt(ShmRing* ring, uint64_t position) {
+	uint32_t index = (uint32_t)(position & (ring->shared->slotCount - 1));
+	return (ShmRingSlot*)(ring->slots + (size_t)index * ring->shared->slotStride);
+}
+
+// Função para obter a próxima posição livre; NULL quando o anel está cheio
+uint8_t* shmRingBeginWrite(ShmRing* ring) {
+	ShmRingShared* shared = ring->shared;
+	uint64_t head = atomic_load_explicit(&shared->head, memory_order_relaxed);
+	uint64_t tail = atomic_load_explicit(&shared->tail, memory_order_acquire);
+	if (head - tail >= shared->slotCount) {
+		return NULL;
+	}
+	return slotAt(ring, head)->data;
+}
+
+// Função para publicar a posição escrita e acordar o consumidor se estiver à espera
+void shmRingCommitWrite(ShmRing* ring, uint32_t size) {
+	ShmRingShared* shared = ring->shared;
+	uint64_t head = atomic_load_explicit(&shared->head, memory_order_relaxed);
+	slotAt(ring, head)->size = size;
+	atomic_store_explicit(&shared->head, head + 1, memory_order_release);
+
+	// A barreira ordena a publicação antes da leitura de consumerWaiting (par com shmRingPrepareWait)
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&shared->consumerWaiting, memory_order_relaxed) != 0 &&
+		atomic_exchange_explicit(&shared->consumerWaiting, 0, memory_order_relaxed) != 0) {
+		uint64_t one = 1;
+		if (write(ring->eventFd, &one, sizeof(one)) == -1) {
+			perror("Failed to signal shared ring");
+		}
+	}
+}
+
+bool shmRingPush(ShmRing* ring, const void* data, uint32_t size) {
+	if (size > ring->shared->slotSize) {
+		return false;
+	}
+	uint8_t* slot = shmRingBeginWrite(ring);
+	if (slot == NULL) {
+		return false;
+	}
+	memcpy(slot, data, size);
+	shmRingCommitWrite(ring, size);
+	return true;
+}
+
+// Função para obter a próxima posição com dados; NULL quando o anel está vazio
+const uint8_t* shmRingBeginRead(ShmRing* ring, uint32_t* size) {
+	ShmRingShared* shared = ring->shared;
+	uint64_t tail = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+	uint64_t head = atomic_load_explicit(&shared->head, memory_order_acquire);
+	if (tail == head) {
+		return NULL;
+	}
+	ShmRingSlot* slot = slotAt(ring, tail);
+	*size = slot->size <= shared->slotSize ? slot->size : shared->slotSize;
+	return slot->data;
+}
+
+// Função para devolver a posição lida ao produtor
+void shmRingEndRead(ShmRing* ring) {
+	ShmRingShared* shared = ring->shared;
+	uint64_t tail = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+	atomic_store_explicit(&shared->tail, tail + 1, memory_order_release);
+}
+
+bool shmRingPop(ShmRing* ring, void* data, uint32_t capacity, uint32_t* size) {
+	const uint8_t* slot = shmRingBeginRead(ring, size);
+	if (slot == NULL) {
+		return false;
+	}
+	if (*size > capacity) {
+		*size = capacity;
+	}
+	memcpy(data, slot, *size);
+	shmRingEndRead(ring);
+	return true;
+}
+
+// Função para anunciar que o consumidor vai esperar no eventfd
+// Devolve falso (e cancela o anúncio) se o anel já tiver dados: o consumidor deve continuar a ler
+bool shmRingPrepareWait(ShmRing* ring) {
+	ShmRingShared* shared = ring->shared;
+	atomic_store_explicit(&shared->consumerWaiting, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&shared->head, memory_order_acquire) !=
+		atomic_load_explicit(&shared->tail, memory_order_relaxed)) {
+		atomic_store_explicit(&shared->consumerWaiting, 0, memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+// Função para consumir o sinal do eventfd depois de acordar
+void shmRingClearWakeup(ShmRing* ring) {
+	uint64_t count;
+	if (read(ring->eventFd, &count, sizeof(count)) == -1 && errno != EAGAIN) {
+		perror("Failed to read shared ring eventfd");
+	}
+}
+
+// Estrutura TransportBenchmark: estado partilhado pelas duas threads do teste
+typedef struct {
+	long messages;
+	ShmRing* ring;      // NULL: usar o pipe
+	int pipeFds[2];
+	double* latencies;  // Latência de cada mensagem (ns)
+	int spinLimit;      // Tentativas antes de dormir no eventfd (0 com um só núcleo)
+} TransportBenchmark;
+
+static double nanosecondsSince(uint64_t timestamp) {
+	return (double)(wireTimestampNow() - timestamp);
+}
+
+// Função do consumidor: acorda como o ciclo de eventos (eventfd ou pipe), lê e mede a latência
+static void* benchmarkConsumer(void* arg) {
+	TransportBenchmark* benchmark = arg;
+	uint8_t buffer[WIRE_MAX_FRAME_SIZE];
+	WireFrame frame;
+	size_t frameSize;
+	long received = 0;
+
+	while (received < benchmark->messages) {
+		if (benchmark->ring != NULL) {
+			uint32_t size;
+			const uint8_t* slot = shmRingBeginRead(benchmark->ring, &size);
+			if (slot == NULL) {
+				// Rodar um pouco antes de dormir: a latência típica fica abaixo de um microssegundo
+				for (int spin = 0; spin < benchmark->spinLimit && slot == NULL; spin++) {
+					slot = shmRingBeginRead(benchmark->ring, &size);
+				}
+				if (slot == NULL) {
+					if (shmRingPrepareWait(benchmark->ring)) {
+						struct pollfd wait = { benchmark->ring->eventFd, POLLIN, 0 };
+						poll(&wait, 1, -1);
+						shmRingClearWakeup(benchmark->ring);
+					}
+					continue;
+				}
+			}
+			wireDecodeFrame(slot, size, &frame, &frameSize);
+			shmRingEndRead(benchmark->ring);
+		}
+		else {
+			ssize_t count = read(benchmark->pipeFds[0], buffer, wireFrameSize(1));
+			if (count <= 0) {
+				break;
+			}
+			wireDecodeFrame(buffer, (size_t)count, &frame, &frameSize);
+		}
+		benchmark->latencies[received++] = nanosecondsSince(frame.timestamp);
+	}
+	return NULL;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// Função para enviar as mensagens por um transporte e mostrar a latência
+static void benchmarkTransport(const char* name, TransportBenchmark* benchmark) {
+	pthread_t consumer;
+	pthread_create(&consumer, NULL, benchmarkConsumer, benchmark);
+
+	WireFrame frame = { WIRE_TEMPERATURES, 1, 1, 0, 0, 0, { 0.0f } };
+	uint8_t buffer[WIRE_MAX_FRAME_SIZE];
+	for (long i = 0; i < benchmark->messages; i++) {
+		// Espaçar as mensagens para medir a latência e não a fila
+		struct timespec gap = { 0, 10000 };
+		nanosleep(&gap, NULL);
+
+		frame.sequence = (uint32_t)i;
+		frame.values[0] = (float)i;
+		frame.timestamp = wireTimestampNow();
+		if (benchmark->ring != NULL) {
+			uint8_t* slot;
+			while ((slot = shmRingBeginWrite(benchmark->ring)) == NULL) {
+			}
+			shmRingCommitWrite(benchmark->ring, (uint32_t)wireEncodeFrame(&frame, slot, WIRE_MAX_FRAME_SIZE));
+		}
+		else {
+			size_t size = wireEncodeFrame(&frame, buffer, sizeof(buffer));
+			if (write(benchmark->pipeFds[1], buffer, size) == -1) {
+				perror("Failed to write benchmark pipe");
+			}
+		}
+	}
+	pthread_join(consumer, NULL);
+
+	qsort(benchmark->latencies, (size_t)benchmark->messages, sizeof(double), compareDoubles);
+	double sum = 0.0;
+	for (long i = 0; i < benchmark->messages; i++) {
+		sum += benchmark->latencies[i];
+	}
+	printf("%-5s mean %8.0f ns, p50 %8.0f ns, p99 %8.0f ns, max %8.0f ns\n", name,
+		sum / (double)benchmark->messages, benchmark->latencies[benchmark->messages / 2],
+		benchmark->latencies[benchmark->messages * 99 / 100], benchmark->latencies[benchmark->messages - 1]);
+}
+
+// Função para comparar a latência produtor->consumidor do pipe e do anel partilhado
+int runTransportBenchmark(long messages) {
+	TransportBenchmark benchmark;
+	benchmark.messages = messages > 0 ? messages : 1;
+	benchmark.latencies = malloc((size_t)benchmark.messages * sizeof(double));
+	if (benchmark.latencies == NULL) {
+		perror("Failed to allocate latencies");
+		return EXIT_FAILURE;
+	}
+
+	printf("Transport latency, %ld frames of %zu bytes between two threads:\n", benchmark.messages, wireFrameSize(1));
+
+	// Rodar só faz sentido se o produtor tiver outro núcleo
+	benchmark.spinLimit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 4096 : 0;
+	benchmark.ring = NULL;
+	if (pipe(benchmark.pipeFds) == -1) {
+		perror("Failed to create benchmark pipe");
+		free(benchmark.latencies);
+		return EXIT_FAILURE;
+	}
+	benchmarkTransport("pipe", &benchmark);
+	close(benchmark.pipeFds[0]);
+	close(benchmark.pipeFds[1]);
+
+	ShmRing ring;
+	if (shmRingCreate(&ring, 1024, WIRE_MAX_FRAME_SIZE) != 0) {
+		free(benchmark.latencies);
+		return EXIT_FAILURE;
+	}
+	benchmark.ring = &ring;
+	benchmarkTransport("shm", &benchmark);
+	shmRingDestroy(&ring);
+
+	free(benchmark.latencies);
+	return EXIT_SUCCESS;
+}
+
+#endif // __linux__
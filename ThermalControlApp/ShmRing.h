@@ -0,0 +1,57 @@
+﻿// ShmRing.h : Anel SPSC sem locks em memória partilhada (memfd), com acordar por eventfd.
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include "ThermalControlApp.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef __linux__
+
+#define SHM_RING_CACHE_LINE 64
+
+// Estrutura ShmRingShared: cabeçalho no início da região partilhada, seguido das posições
+// head só é escrito pelo produtor e tail só pelo consumidor, cada um na sua linha de cache
+typedef struct {
+	_Alignas(SHM_RING_CACHE_LINE) _Atomic uint64_t head;   // Próxima posição a escrever
+	_Alignas(SHM_RING_CACHE_LINE) _Atomic uint64_t tail;   // Próxima posição a ler
+	_Alignas(SHM_RING_CACHE_LINE) _Atomic uint32_t consumerWaiting; // O consumidor vai dormir no eventfd
+	uint32_t slotCount;     // Potência de 2
+	uint32_t slotSize;      // Bytes úteis por posição
+	uint32_t slotStride;    // Bytes por posição, incluindo o tamanho e o alinhamento
+} ShmRingShared;
+
+// Estrutura ShmRing: vista local de um anel (cada processo tem a sua)
+typedef struct {
+	ShmRingShared* shared;
+	uint8_t* slots;
+	size_t mappedSize;
+	int memFd;      // Pode ser passado a outro processo (fork ou SCM_RIGHTS) para shmRingAttach
+	int eventFd;    // Sinalizado pelo produtor quando o consumidor está à espera
+} ShmRing;
+
+// Funções do anel
+int shmRingCreate(ShmRing* ring, uint32_t slotCount, uint32_t slotSize);
+int shmRingAttach(ShmRing* ring, int memFd, int eventFd);
+void shmRingDestroy(ShmRing* ring);
+
+// Produtor: escrever diretamente na posição e confirmar, ou copiar com shmRingPush
+uint8_t* shmRingBeginWrite(ShmRing* ring);
+void shmRingCommitWrite(ShmRing* ring, uint32_t size);
+bool shmRingPush(ShmRing* ring, const void* data, uint32_t size);
+
+// Consumidor: ler diretamente da posição e libertar, ou copiar com shmRingPop
+const uint8_t* shmRingBeginRead(ShmRing* ring, uint32_t* size);
+void shmRingEndRead(ShmRing* ring);
+bool shmRingPop(ShmRing* ring, void* data, uint32_t capacity, uint32_t* size);
+
+// Consumidor: preparar a espera no eventfd; devolve falso se entretanto chegaram dados
+bool shmRingPrepareWait(ShmRing* ring);
+void shmRingClearWakeup(ShmRing* ring);
+
+int runTransportBenchmark(long messages);
+
+#endif // __linux__
+
+#endif // SHM_RING_H
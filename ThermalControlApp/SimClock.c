@@ -0,0 +1,88 @@
+﻿// SimClock.c : Avanço do tempo simulado com espera real opcional.
+
+#include "SimClock.h"
+
+#define NANOSECONDS_PER_SECOND 1000000000L
+
+// Função para somar segundos a um instante
+static void addSeconds(struct timespec* instant, double seconds) {
+	long nanoseconds = (long)(seconds * NANOSECONDS_PER_SECOND);
+	instant->tv_sec += nanoseconds / NANOSECONDS_PER_SECOND;
+	instant->tv_nsec += nanoseconds % NANOSECONDS_PER_SECOND;
+	if (instant->tv_nsec >= NANOSECONDS_PER_SECOND) {
+		instant->tv_sec++;
+		instant->tv_nsec -= NANOSECONDS_PER_SECOND;
+	}
+}
+
+// Função para comparar dois instantes
+static bool isBefore(const struct timespec* a, const struct timespec* b) {
+	return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// Função para inicializar o relógio
+void simClockInit(SimClock* clock, double dt, double timeWarp) {
+	memset(clock, 0, sizeof(*clock));
+	clock->dt = dt;
+	clock->timeWarp = timeWarp < 0.0 ? TIME_WARP_UNBOUNDED : timeWarp;
+	clock->lateness = -1;
+}
+
+// Função para alterar o fator de aceleração em execução
+void simClockSetTimeWarp(SimClock* clock, double timeWarp) {
+	clock->timeWarp = timeWarp < 0.0 ? TIME_WARP_UNBOUNDED : timeWarp;
+	clock->paced = false; // Os prazos recomeçam a partir do instante atual
+}
+
+// Função para avançar o tempo simulado um ciclo, sem esperar
+// (usada quando o ritmo real é dado por um temporizador externo)
+void simClockAdvance(SimClock* clock) {
+	clock->simulatedTime += clock->dt;
+	clock->steps++;
+}
+
+// Função para obter o período real de um ciclo (0 = sem limite)
+double simClockPeriod(const SimClock* clock) {
+	return clock->timeWarp > 0.0 ? clock->dt / clock->timeWarp : 0.0;
+}
+
+// Função para avançar um ciclo: o tempo simulado avança dt e, com fator > 0,
+// espera até ao prazo absoluto do ciclo (sem acumular desvio)
+void simClockTick(SimClock* clock) {
+	simClockAdvance(clock);
+
+	double warp = clock->timeWarp;
+	clock->lateness = -1;
+	if (warp <= 0.0) {
+		return; // Relógio virtual: sem espera
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (!clock->paced) {
+		clock->nextWakeup = now;
+		clock->paced = true;
+	}
+
+	addSeconds(&clock->nextWakeup, clock->dt / warp);
+	if (isBefore(&clock->nextWakeup, &now)) {
+		// Atrasado mais do que um ciclo: realinhar em vez de recuperar em rajada
+		clock->lateness = (int64_t)(now.tv_sec - clock->nextWakeup.tv_sec) * 1000000000LL +
+			(now.tv_nsec - clock->nextWakeup.tv_nsec);
+		clock->nextWakeup = now;
+		return;
+	}
+
+	int result;
+	do {
+		result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &clock->nextWakeup, NULL);
+	} while (result == EINTR); // Repetir só se interrompido por um sinal
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (result != 0) {
+		// Prazo inválido (EINVAL): realinhar com o relógio em vez de repetir a mesma espera
+		clock->nextWakeup = now;
+		return;
+	}
+	clock->lateness = (int64_t)(now.tv_sec - clock->nextWakeup.tv_sec) * 1000000000LL +
+		(now.tv_nsec - clock->nextWakeup.tv_nsec);
+}
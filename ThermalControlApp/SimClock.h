@@ -0,0 +1,29 @@
+﻿// SimClock.h : Relógio de simulação com tempo virtual e fator de aceleração.
+
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include "ThermalControlApp.h"
+
+#define SIMULATION_DT 0.5        // Tempo simulado por ciclo (s); em 1x corresponde a 0.5 s reais
+#define TIME_WARP_UNBOUNDED 0.0  // Sem espera: o tempo simulado avança tão depressa quanto possível
+
+// Estrutura SimClock
+typedef struct {
+	double dt;                    // Segundos simulados por ciclo
+	double timeWarp;              // Fator de aceleração (1x, 10x, ...); 0 = sem limite
+	double simulatedTime;         // Tempo simulado acumulado (s)
+	long steps;                   // Número de ciclos executados
+	struct timespec nextWakeup;   // Prazo absoluto do próximo ciclo (CLOCK_MONOTONIC)
+	bool paced;                   // Falso até ao primeiro ciclo após uma mudança de ritmo
+	int64_t lateness;             // Atraso (ns) do último despertar face ao prazo; -1 sem prazo
+} SimClock;
+
+// Funções do relógio de simulação
+void simClockInit(SimClock* clock, double dt, double timeWarp);
+void simClockSetTimeWarp(SimClock* clock, double timeWarp);
+void simClockAdvance(SimClock* clock);
+double simClockPeriod(const SimClock* clock);
+void simClockTick(SimClock* clock);
+
+#endif // SIM_CLOCK_H
@@ -0,0 +1,209 @@
+﻿// TelemetryLogger.c : O ciclo de controlo só copia o registo para a fila (sem chamadas ao sistema,
+// formatação nem locks). A thread do registo formata as linhas num buffer grande e escreve-o quando
+// enche ou a cada TELEMETRY_LOG_FLUSH_INTERVAL_NS, com o ficheiro sempre aberto.
+
+#include "TelemetryLogger.h"
+
+static uint64_t monotonicNow() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// Função para escrever um inteiro sem sinal com um número fixo de dígitos
+static char* writeDigits(char* out, unsigned value, int digits) {
+	for (int i = digits - 1; i >= 0; i--) {
+		out[i] = (char)('0' + value % 10);
+		value /= 10;
+	}
+	return out + digits;
+}
+
+// Função para escrever a hora local "AAAA-MM-DDTHH:MM:SS.mmm", como o TSL (sem fuso)
+// localtime_r e strftime só correm quando o segundo muda; os milissegundos são acrescentados à mão
+static char* writeTimestamp(TelemetryLogger* logger, char* out, uint64_t wallTime) {
+	time_t second = (time_t)(wallTime / 1000000000ull);
+	if (second != logger->cachedSecond) {
+		struct tm local;
+		localtime_r(&second, &local);
+		logger->cachedPrefixLength = strftime(logger->cachedPrefix, sizeof(logger->cachedPrefix), "%Y-%m-%dT%H:%M:%S", &local);
+		logger->cachedSecond = second;
+	}
+	memcpy(out, logger->cachedPrefix, logger->cachedPrefixLength);
+	out += logger->cachedPrefixLength;
+	*out++ = '.';
+	return writeDigits(out, (unsigned)(wallTime / 1000000ull % 1000), 3);
+}
+
+// Função para escrever o buffer pelo backend de I/O (uma submissão por escrita; repete as escritas parciais)
+static bool writeBuffer(TelemetryLogger* logger) {
+	size_t written = 0;
+	while (written < logger->used) {
+		struct iovec iov = { logger->buffer + written, logger->used - written };
+		IoCompletion completion;
+		if (!ioQueueWritev(&logger->io, fileno(logger->file), &iov, 1, 0, false) ||
+			ioBackendSubmit(&logger->io, &completion, 1) != 1) {
+			return false;
+		}
+		if (completion.result <= 0) {
+			errno = completion.result < 0 ? -completion.result : EIO;
+			return false;
+		}
+		written += (size_t)completion.result;
+	}
+	return true;
+}
+
+// Função para escrever o buffer no ficheiro e depois o cabeçalho da pirâmide, que passa a cobrir essas linhas
+static void flushBuffer(TelemetryLogger* logger) {
+	if (logger->used == 0) {
+		return;
+	}
+	if (!writeBuffer(logger)) {
+		perror("Failed to write telemetry log");
+	}
+	logger->writes++;
+	logger->fileSize += logger->used;
+	logger->used = 0;
+	if (logger->pyramid.file != NULL && decimationSync(&logger->pyramid, logger->fileSize) != 0) {
+		decimationClose(&logger->pyramid);
+	}
+}
+
+// Função para somar a linha acabada de formatar à pirâmide, relida como o --store-import a leria
+static void decimateRow(TelemetryLogger* logger, const char* line, size_t length) {
+	TelemetryRecord record;
+	char text[STORE_MAX_STRING];
+	uint64_t offset = logger->fileSize + (uint64_t)(line - logger->buffer);
+	if (telemetryStoreParseCsvLine(line, line + length - 1, &record, text) &&
+		decimationAdd(&logger->pyramid, &record, offset) != 0) {
+		decimationClose(&logger->pyramid);
+	}
+}
+
+// Função para formatar um registo no buffer, como writeToCSVCorrect e writeToCSVError do TSL
+static void formatRecord(TelemetryLogger* logger, const LogRecord* record) {
+	char* out = logger->buffer + logger->used;
+	size_t space = TELEMETRY_LOG_BUFFER_SIZE - logger->used;
+	char timestamp[STORE_TIMESTAMP_LENGTH + 1];
+	*writeTimestamp(logger, timestamp, record->wallTime) = '\0';
+	int length;
+	if (record->kind == LOG_ROW_ERROR) {
+		length = snprintf(out, space, "null, null, null, null, null, null, null, null, %s, null, "
+			"Temperature limit reached: %f\n", timestamp, record->temperature);
+	}
+	else {
+		const char* heater = record->heaterOn ? "On" : "Off";
+		length = snprintf(out, space, "%f, %f, %f, %f, %s, %s, %s, %s, %s, %s, null\n", record->temperature,
+			record->temperature, record->temperature, record->temperature, heater, heater, heater, heater, timestamp,
+			TELEMETRY_LOG_ENVIRONMENT);
+	}
+	if (logger->pyramid.file != NULL) {
+		decimateRow(logger, out, (size_t)length);
+	}
+	logger->used += (size_t)length;
+	logger->rows++;
+}
+
+// Função da thread do registo
+static void* loggerThread(void* arg) {
+	TelemetryLogger* logger = arg;
+	uint64_t lastFlush = monotonicNow();
+	const size_t maxRow = 256;
+
+	for (;;) {
+		bool running = atomic_load_explicit(&logger->running, memory_order_acquire);
+		uint64_t tail = atomic_load_explicit(&logger->tail, memory_order_relaxed);
+		uint64_t head = atomic_load_explicit(&logger->head, memory_order_acquire);
+
+		while (tail != head) {
+			if (logger->used + maxRow > TELEMETRY_LOG_BUFFER_SIZE) {
+				flushBuffer(logger);
+				lastFlush = monotonicNow();
+			}
+			formatRecord(logger, &logger->records[tail & (TELEMETRY_LOG_QUEUE_SIZE - 1)]);
+			tail++;
+			atomic_store_explicit(&logger->tail, tail, memory_order_release);
+		}
+
+		uint64_t now = monotonicNow();
+		if (!running || now - lastFlush >= TELEMETRY_LOG_FLUSH_INTERVAL_NS) {
+			flushBuffer(logger);
+			lastFlush = now;
+		}
+		if (!running) {
+			// running foi lido antes de head, por isso os últimos registos já foram escritos
+			return NULL;
+		}
+
+		struct timespec idle = { 0, TELEMETRY_LOG_IDLE_NS };
+		nanosleep(&idle, NULL);
+	}
+}
+
+// Função para abrir o ficheiro (acrescentando) e arrancar a thread
+// As escritas do buffer usam um backend de I/O próprio do tipo pedido, porque um io_uring só é usado por uma thread
+int telemetryLoggerStart(TelemetryLogger* logger, const char* path, IoBackendKind ioKind) {
+	logger->file = fopen(path, "a");
+	if (logger->file == NULL) {
+		perror("Failed to open telemetry log");
+		return -1;
+	}
+	logger->buffer = malloc(TELEMETRY_LOG_BUFFER_SIZE);
+	if (logger->buffer == NULL) {
+		fclose(logger->file);
+		return -1;
+	}
+
+	// O buffer do registo já agrupa as linhas; o do stdio só acrescentaria uma cópia
+	setvbuf(logger->file, NULL, _IONBF, 0);
+	if (ftell(logger->file) == 0) {
+		fputs(STORE_CSV_HEADER "\n", logger->file);
+	}
+	logger->fileSize = (uint64_t)ftell(logger->file);
+	if (decimationOpenLog(&logger->pyramid, path, logger->fileSize) != 0) {
+		fprintf(stderr, "Continuing the telemetry log without its decimation pyramid\n");
+	}
+	ioBackendInit(&logger->io, ioKind); // Sem io_uring continua com escritas síncronas
+
+	atomic_init(&logger->head, 0);
+	atomic_init(&logger->tail, 0);
+	atomic_init(&logger->dropped, 0);
+	logger->used = 0;
+	logger->cachedSecond = (time_t)-1;
+	atomic_init(&logger->rows, 0);
+	atomic_init(&logger->writes, 0);
+	atomic_init(&logger->running, true);
+	if (pthread_create(&logger->thread, NULL, loggerThread, logger) != 0) {
+		perror("Failed to create logger thread");
+		ioBackendClose(&logger->io);
+		decimationClose(&logger->pyramid);
+		free(logger->buffer);
+		fclose(logger->file);
+		return -1;
+	}
+	return 0;
+}
+
+// Função para escrever os registos pendentes e fechar o ficheiro
+void telemetryLoggerStop(TelemetryLogger* logger) {
+	atomic_store_explicit(&logger->running, false, memory_order_release);
+	pthread_join(logger->thread, NULL);
+	ioBackendClose(&logger->io);
+	decimationClose(&logger->pyramid);
+	fclose(logger->file);
+	free(logger->buffer);
+}
+
+// Função para pôr um registo na fila; nunca bloqueia (com a fila cheia o registo é contado e perdido)
+bool telemetryLoggerLog(TelemetryLogger* logger, const LogRecord* record) {
+	uint64_t head = atomic_load_explicit(&logger->head, memory_order_relaxed);
+	uint64_t tail = atomic_load_explicit(&logger->tail, memory_order_acquire);
+	if (head - tail >= TELEMETRY_LOG_QUEUE_SIZE) {
+		atomic_fetch_add_explicit(&logger->dropped, 1, memory_order_relaxed);
+		return false;
+	}
+	logger->records[head & (TELEMETRY_LOG_QUEUE_SIZE - 1)] = *record;
+	atomic_store_explicit(&logger->head, head + 1, memory_order_release);
+	return true;
+}
@@ -0,0 +1,61 @@
+﻿// TelemetryLogger.h : Registo CSV da telemetria numa thread própria, alimentada por uma fila sem locks.
+// As linhas seguem o data.csv do TSL, para que --store-import, --replay e --plot as aceitem, e cada linha
+// atualiza a pirâmide de resumos do ficheiro (<ficheiro>.pyr), continuada entre execuções.
+
+#ifndef TELEMETRY_LOGGER_H
+#define TELEMETRY_LOGGER_H
+
+#include "ThermalControlApp.h"
+#include "Decimation.h"
+#include "IoBackend.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define TELEMETRY_LOG_QUEUE_SIZE 4096           // Registos em espera (potência de 2)
+#define TELEMETRY_LOG_BUFFER_SIZE (64 * 1024)   // Bytes formatados antes de uma escrita
+#define TELEMETRY_LOG_FLUSH_INTERVAL_NS 200000000ull  // Escrita forçada ao fim de 200 ms
+#define TELEMETRY_LOG_IDLE_NS 10000000L         // Pausa da thread com a fila vazia (10 ms)
+#define TELEMETRY_LOG_ENVIRONMENT "Unknown"     // O modo interativo não tem modelo de órbita
+
+// Tipo de linha, como writeToCSVCorrect/writeToCSVError do TSL
+typedef enum {
+	LOG_ROW_OK,
+	LOG_ROW_ERROR           // Temperatura fora dos limites
+} LogRowKind;
+
+// Estrutura LogRecord: valores de um ciclo, sem formatação (feita pela thread do registo)
+// A simulação interativa tem uma só zona, lida pelos quatro termístores e aquecida pelos quatro aquecedores
+typedef struct {
+	uint64_t wallTime;      // CLOCK_REALTIME em ns
+	float temperature;
+	uint8_t heaterOn;
+	uint8_t kind;
+} LogRecord;
+
+// Estrutura TelemetryLogger
+typedef struct {
+	_Alignas(64) _Atomic uint64_t head;     // Escrito só pelo ciclo de controlo
+	_Alignas(64) _Atomic uint64_t tail;     // Escrito só pela thread do registo
+	_Alignas(64) LogRecord records[TELEMETRY_LOG_QUEUE_SIZE];
+	_Atomic bool running;
+	pthread_t thread;
+	FILE* file;
+	IoBackend io;                           // Escritas do buffer (io_uring com --io uring); só desta thread
+	char* buffer;                           // Linhas formatadas à espera de escrita
+	size_t used;
+	uint64_t fileSize;                      // Bytes já escritos no ficheiro
+	DecimationPyramid pyramid;              // Em acréscimo; file == NULL se não abriu
+	time_t cachedSecond;                    // Segundo do prefixo em cache
+	char cachedPrefix[32];                  // "AAAA-MM-DDTHH:MM:SS"
+	size_t cachedPrefixLength;
+	_Atomic unsigned long dropped;          // Registos perdidos com a fila cheia
+	_Atomic unsigned long rows;             // Linhas escritas (lidas pela opção 6)
+	_Atomic unsigned long writes;           // Escritas do buffer
+} TelemetryLogger;
+
+// Funções do registo
+int telemetryLoggerStart(TelemetryLogger* logger, const char* path, IoBackendKind ioKind);
+void telemetryLoggerStop(TelemetryLogger* logger);
+bool telemetryLoggerLog(TelemetryLogger* logger, const LogRecord* record);
+
+#endif // TELEMETRY_LOGGER_H
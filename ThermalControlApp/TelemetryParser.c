@@ -0,0 +1,397 @@
+﻿// TelemetryParser.c : Leitura campo a campo com um cursor, sem cópias nem dependência da locale.
+// Os números decimais curtos (o caso normal, "%.2f") são convertidos de forma exata em float;
+// os restantes usam strtof_l na locale "C".
+
+#define _GNU_SOURCE // strtof_l
+
+#include "TelemetryParser.h"
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+#define TELEMETRY_MAX_FLOAT_TOKEN 64        // Tamanho máximo de um número no caminho lento
+#define FLOAT_EXACT_MANTISSA (1u << 24)     // Inteiros até 2^24 são exatos em float
+
+// Potências de 10 exatas em float
+static const float powersOfTen[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+static locale_t numericLocale;
+static pthread_once_t numericLocaleOnce = PTHREAD_ONCE_INIT;
+
+static void createNumericLocale() {
+	numericLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+static inline bool isDigit(char c) {
+	return (unsigned char)(c - '0') < 10;
+}
+
+// Função para ler um inteiro com sinal de 32 bits
+static bool parseInteger(const char** cursor, const char* end, int32_t* value) {
+	const char* p = *cursor;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+	if (p == end || !isDigit(*p)) {
+		return false;
+	}
+
+	int64_t magnitude = 0;
+	while (p < end && isDigit(*p)) {
+		magnitude = magnitude * 10 + (*p - '0');
+		if (magnitude > (int64_t)INT32_MAX + 1) {
+			return false;
+		}
+		p++;
+	}
+	if (!negative && magnitude > INT32_MAX) {
+		return false;
+	}
+
+	*value = (int32_t)(negative ? -magnitude : magnitude);
+	*cursor = p;
+	return true;
+}
+
+// Função para ler um número decimal ([sinal]dígitos[.dígitos][e[sinal]dígitos])
+// Devolve o float mais próximo, como strtof; em caso de erro o cursor não avança
+bool telemetryParseFloat(const char** cursor, const char* end, float* value) {
+	const char* start = *cursor;
+	const char* p = start;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0;             // Dígitos significativos acumulados em mantissa
+	int64_t exponent = 0;
+	bool anyDigit = false;
+	bool exact = true;          // Falso se algum dígito não coube na mantissa
+
+	while (p < end && isDigit(*p)) {
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+			digits += mantissa > 0;
+		}
+		else {
+			exponent++;
+			exact = exact && *p == '0';
+		}
+		anyDigit = true;
+		p++;
+	}
+	if (p < end && *p == '.') {
+		p++;
+		while (p < end && isDigit(*p)) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+				digits += mantissa > 0;
+				exponent--;
+			}
+			else {
+				exact = exact && *p == '0';
+			}
+			anyDigit = true;
+			p++;
+		}
+	}
+	if (!anyDigit) {
+		return false;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char* q = p + 1;
+		if (q < end && (*q == '-' || *q == '+')) {
+			q++;
+		}
+		if (q < end && isDigit(*q)) {
+			const char* exponentCursor = p + 1;
+			int32_t explicitExponent;
+			if (parseInteger(&exponentCursor, end, &explicitExponent)) {
+				exponent += explicitExponent;
+			}
+			else {
+				exact = false; // Expoente enorme: deixar para strtof_l
+			}
+			while (q < end && isDigit(*q)) {
+				q++;
+			}
+			p = q;
+		}
+	}
+
+	// Caminho rápido: mantissa e potência de 10 exatas em float, uma só operação arredondada
+	if (exact && mantissa <= FLOAT_EXACT_MANTISSA && exponent >= -10 && exponent <= 10) {
+		float result = (float)mantissa;
+		result = exponent >= 0 ? result * powersOfTen[exponent] : result / powersOfTen[-exponent];
+		*value = negative ? -result : result;
+		*cursor = p;
+		return true;
+	}
+
+	// Caminho lento: copiar o número e usar strtof_l na locale "C"
+	size_t length = (size_t)(p - start);
+	if (length >= TELEMETRY_MAX_FLOAT_TOKEN) {
+		return false;
+	}
+	char token[TELEMETRY_MAX_FLOAT_TOKEN];
+	memcpy(token, start, length);
+	token[length] = '\0';
+
+	pthread_once(&numericLocaleOnce, createNumericLocale);
+	char* tokenEnd;
+	*value = strtof_l(token, &tokenEnd, numericLocale);
+	if (tokenEnd != token + length) {
+		return false;
+	}
+	*cursor = p;
+	return true;
+}
+
+// Função para remover o fim de linha
+static size_t trimLineEnd(const char* line, size_t length) {
+	while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+		length--;
+	}
+	return length;
+}
+
+static TelemetryStatus fail(TelemetryStatus status, const char* line, const char* cursor, size_t* errorOffset) {
+	if (errorOffset != NULL) {
+		*errorOffset = (size_t)(cursor - line);
+	}
+	return status;
+}
+
+// Função para ler uma linha "id;temp-id;temp-...-trailer"
+TelemetryStatus telemetryParseTemperatures(const char* line, size_t length, TelemetryTemperatures* sample,
+	size_t* errorOffset) {
+	const char* end = line + trimLineEnd(line, length);
+	const char* p = line;
+	if (p == end) {
+		return fail(TELEMETRY_EMPTY, line, p, errorOffset);
+	}
+
+	sample->sensorCount = 0;
+	for (;;) {
+		int32_t id;
+		if (!parseInteger(&p, end, &id)) {
+			return fail(TELEMETRY_BAD_INTEGER, line, p, errorOffset);
+		}
+		if (p == end) {
+			// O último inteiro da linha não tem temperatura
+			if (sample->sensorCount == 0) {
+				return fail(TELEMETRY_BAD_SEPARATOR, line, p, errorOffset);
+			}
+			sample->trailer = id;
+			return TELEMETRY_OK;
+		}
+		if (*p != ';') {
+			return fail(TELEMETRY_BAD_SEPARATOR, line, p, errorOffset);
+		}
+		p++;
+		if (sample->sensorCount == TELEMETRY_MAX_SENSORS) {
+			return fail(TELEMETRY_TOO_MANY_FIELDS, line, p, errorOffset);
+		}
+
+		float temperature;
+		if (!telemetryParseFloat(&p, end, &temperature)) {
+			return fail(TELEMETRY_BAD_FLOAT, line, p, errorOffset);
+		}
+		if (p == end || *p != '-') {
+			return fail(TELEMETRY_BAD_SEPARATOR, line, p, errorOffset);
+		}
+		p++;
+
+		sample->ids[sample->sensorCount] = id;
+		sample->temperatures[sample->sensorCount] = temperature;
+		sample->sensorCount++;
+	}
+}
+
+// Função para ler uma linha "v;v;...;v"
+TelemetryStatus telemetryParseIntegers(const char* line, size_t length, TelemetryIntegers* sample,
+	size_t* errorOffset) {
+	const char* end = line + trimLineEnd(line, length);
+	const char* p = line;
+	if (p == end) {
+		return fail(TELEMETRY_EMPTY, line, p, errorOffset);
+	}
+
+	sample->count = 0;
+	for (;;) {
+		if (sample->count == TELEMETRY_MAX_INTEGERS) {
+			return fail(TELEMETRY_TOO_MANY_FIELDS, line, p, errorOffset);
+		}
+		if (!parseInteger(&p, end, &sample->values[sample->count])) {
+			return fail(TELEMETRY_BAD_INTEGER, line, p, errorOffset);
+		}
+		sample->count++;
+		if (p == end) {
+			return TELEMETRY_OK;
+		}
+		if (*p != ';') {
+			return fail(TELEMETRY_BAD_SEPARATOR, line, p, errorOffset);
+		}
+		p++;
+	}
+}
+
+// Função para ler um bloco com várias linhas de temperaturas numa só passagem
+// As linhas são separadas com memchr (vetorizado na libc); as linhas inválidas são contadas e saltadas
+size_t telemetryParseTemperatureBatch(const char* data, size_t size, TelemetryTemperatures* samples,
+	size_t capacity, TelemetryBatchResult* result) {
+	const char* p = data;
+	const char* end = data + size;
+	memset(result, 0, sizeof(*result));
+
+	while (p < end && result->parsed < capacity) {
+		const char* newline = memchr(p, '\n', (size_t)(end - p));
+		const char* lineEnd = newline != NULL ? newline : end;
+		size_t column;
+
+		result->lines++;
+		TelemetryStatus status = telemetryParseTemperatures(p, (size_t)(lineEnd - p), &samples[result->parsed], &column);
+		if (status == TELEMETRY_OK) {
+			result->parsed++;
+		}
+		else if (status != TELEMETRY_EMPTY) {
+			if (result->errors == 0) {
+				result->firstErrorLine = result->lines;
+				result->firstErrorColumn = column;
+				result->firstError = status;
+			}
+			result->errors++;
+		}
+		p = newline != NULL ? newline + 1 : end;
+	}
+	return result->parsed;
+}
+
+static const char* telemetryStatusNames[] = { "ok", "empty line", "bad integer", "bad number",
+	"bad separator", "too many fields" };
+
+const char* telemetryStatusName(TelemetryStatus status) {
+	return status <= TELEMETRY_TOO_MANY_FIELDS ? telemetryStatusNames[status] : "unknown";
+}
+
+static double secondsBetween(const struct timespec* start, const struct timespec* end) {
+	return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// Função para comparar o leitor com sscanf nas mesmas linhas geradas
+int runParserBenchmark(long lines) {
+	if (lines <= 0) {
+		lines = 1;
+	}
+
+	// Linhas no formato do TSL, com temperaturas "%.2f" (incluindo negativas) e alguns valores longos
+	size_t capacity = (size_t)lines * 96;
+	char* data = malloc(capacity);
+	size_t* offsets = malloc((size_t)lines * sizeof(size_t));
+	TelemetryTemperatures* samples = malloc((size_t)lines * sizeof(TelemetryTemperatures));
+	if (data == NULL || offsets == NULL || samples == NULL) {
+		perror("Failed to allocate benchmark lines");
+		free(data);
+		free(offsets);
+		free(samples);
+		return EXIT_FAILURE;
+	}
+
+	size_t size = 0;
+	uint32_t state = 12345u;
+	for (long i = 0; i < lines; i++) {
+		float values[4];
+		for (int s = 0; s < 4; s++) {
+			state = state * 1664525u + 1013904223u;
+			values[s] = ((float)(state >> 8) / (float)(1u << 24)) * 100.0f - 40.0f;
+		}
+		offsets[i] = size;
+		if (i % 64 == 0) {
+			size += (size_t)snprintf(data + size, capacity - size, "1;%.9g-2;%.9g-3;%.9g-4;%.9g-%ld\n",
+				values[0], values[1], values[2], values[3], i % 3);
+		}
+		else {
+			size += (size_t)snprintf(data + size, capacity - size, "1;%.2f-2;%.2f-3;%.2f-4;%.2f-%ld\n",
+				values[0], values[1], values[2], values[3], i % 3);
+		}
+	}
+
+	// sscanf recebe cada linha terminada em '\0', como depois de fgets (senão mede strlen do resto do bloco)
+	char* lineCopies = malloc(size);
+	if (lineCopies == NULL) {
+		perror("Failed to allocate benchmark lines");
+		free(data);
+		free(offsets);
+		free(samples);
+		return EXIT_FAILURE;
+	}
+	for (size_t i = 0; i < size; i++) {
+		lineCopies[i] = data[i] == '\n' ? '\0' : data[i];
+	}
+
+	TelemetryTemperatures* parsed = malloc((size_t)lines * sizeof(TelemetryTemperatures));
+	if (parsed == NULL) {
+		perror("Failed to allocate benchmark samples");
+		free(lineCopies);
+		free(data);
+		free(offsets);
+		free(samples);
+		return EXIT_FAILURE;
+	}
+
+	// Tocar nas páginas dos resultados antes de medir
+	memset(samples, 0, (size_t)lines * sizeof(TelemetryTemperatures));
+	memset(parsed, 0, (size_t)lines * sizeof(TelemetryTemperatures));
+
+	struct timespec start, middle, end;
+	long mismatches = 0;
+	long sscanfParsed = 0;
+
+	// Referência: sscanf linha a linha, como no TCF
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < lines; i++) {
+		TelemetryTemperatures* sample = &samples[i];
+		int ids[4];
+		int trailer;
+		if (sscanf(lineCopies + offsets[i], "%d;%f-%d;%f-%d;%f-%d;%f-%d", &ids[0], &sample->temperatures[0], &ids[1],
+			&sample->temperatures[1], &ids[2], &sample->temperatures[2], &ids[3], &sample->temperatures[3], &trailer) == 9) {
+			sample->trailer = trailer;
+			sscanfParsed++;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+
+	// Leitor: o bloco inteiro numa só chamada
+	TelemetryBatchResult result;
+	telemetryParseTemperatureBatch(data, size, parsed, (size_t)lines, &result);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	// Os valores têm de ser iguais bit a bit aos do sscanf
+	for (long i = 0; i < lines && i < (long)result.parsed; i++) {
+		if (parsed[i].sensorCount != 4 || parsed[i].trailer != samples[i].trailer ||
+			memcmp(parsed[i].temperatures, samples[i].temperatures, 4 * sizeof(float)) != 0) {
+			mismatches++;
+		}
+	}
+
+	double sscanfSeconds = secondsBetween(&start, &middle);
+	double parserSeconds = secondsBetween(&middle, &end);
+	printf("Lines: %ld (%.1f MB), parsed: sscanf %ld, parser %zu, errors %zu, mismatches %ld\n", lines,
+		(double)size / 1e6, sscanfParsed, result.parsed, result.errors, mismatches);
+	printf("sscanf: %.1f ns/line, %.2f M lines/s\n", sscanfSeconds * 1e9 / lines, lines / sscanfSeconds / 1e6);
+	printf("parser: %.1f ns/line, %.2f M lines/s (%.1fx)\n", parserSeconds * 1e9 / lines, lines / parserSeconds / 1e6,
+		sscanfSeconds / parserSeconds);
+
+	free(parsed);
+	free(lineCopies);
+	free(data);
+	free(offsets);
+	free(samples);
+	return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,61 @@
+﻿// TelemetryParser.h : Leitura sem alocações das linhas de telemetria em texto do TSL/TCF.
+//
+// Formatos suportados:
+//   temperaturas  "id;temp-id;temp-...-id;temp-trailer"   (ex.: "%d;%f-%d;%f-%d;%f-%d;%f-%d")
+//   inteiros      "v;v;...;v"                               (ex.: "%d;%d;%d;%d")
+
+#ifndef TELEMETRY_PARSER_H
+#define TELEMETRY_PARSER_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+
+#define TELEMETRY_MAX_SENSORS 16    // Pares id;temperatura por linha
+#define TELEMETRY_MAX_INTEGERS 16   // Campos por linha no formato de inteiros
+
+// Resultado da leitura de uma linha
+typedef enum {
+	TELEMETRY_OK,
+	TELEMETRY_EMPTY,            // Linha vazia
+	TELEMETRY_BAD_INTEGER,      // Inteiro em falta ou fora do intervalo de int32
+	TELEMETRY_BAD_FLOAT,        // Número decimal em falta ou inválido
+	TELEMETRY_BAD_SEPARATOR,    // Esperava ';' ou '-', ou a linha terminou antes do tempo
+	TELEMETRY_TOO_MANY_FIELDS
+} TelemetryStatus;
+
+// Estrutura TelemetryTemperatures: uma linha do formato de temperaturas
+typedef struct {
+	uint16_t sensorCount;
+	int32_t ids[TELEMETRY_MAX_SENSORS];
+	float temperatures[TELEMETRY_MAX_SENSORS];
+	int32_t trailer;            // Último inteiro da linha
+} TelemetryTemperatures;
+
+// Estrutura TelemetryIntegers: uma linha do formato de inteiros
+typedef struct {
+	uint16_t count;
+	int32_t values[TELEMETRY_MAX_INTEGERS];
+} TelemetryIntegers;
+
+// Estrutura TelemetryBatchResult: resumo da leitura de um bloco com várias linhas
+typedef struct {
+	size_t lines;
+	size_t parsed;
+	size_t errors;
+	size_t firstErrorLine;      // Linha (a partir de 1) do primeiro erro
+	size_t firstErrorColumn;    // Coluna (a partir de 0) do primeiro erro
+	TelemetryStatus firstError;
+} TelemetryBatchResult;
+
+// Funções do leitor; errorOffset (pode ser NULL) recebe a coluna do erro
+TelemetryStatus telemetryParseTemperatures(const char* line, size_t length, TelemetryTemperatures* sample,
+	size_t* errorOffset);
+TelemetryStatus telemetryParseIntegers(const char* line, size_t length, TelemetryIntegers* sample,
+	size_t* errorOffset);
+size_t telemetryParseTemperatureBatch(const char* data, size_t size, TelemetryTemperatures* samples,
+	size_t capacity, TelemetryBatchResult* result);
+bool telemetryParseFloat(const char** cursor, const char* end, float* value);
+const char* telemetryStatusName(TelemetryStatus status);
+int runParserBenchmark(long lines);
+
+#endif // TELEMETRY_PARSER_H
@@ -0,0 +1,310 @@
+﻿// TelemetryQuery.c : Cada consulta percorre primeiro as entradas do índice e só descodifica os blocos
+// que podem ter linhas pedidas. Os agregados de blocos totalmente incluídos saem do próprio índice.
+
+#include "TelemetryQuery.h"
+
+// Função para carregar o .idx; devolve falso se faltar ou não corresponder ao ficheiro
+static bool loadIndex(TelemetryDataset* dataset, const char* path) {
+	char* indexPath = malloc(strlen(path) + sizeof(STORE_INDEX_SUFFIX));
+	if (indexPath == NULL) {
+		return false;
+	}
+	sprintf(indexPath, "%s%s", path, STORE_INDEX_SUFFIX);
+	FILE* file = fopen(indexPath, "rb");
+	free(indexPath);
+	if (file == NULL) {
+		return false;
+	}
+
+	const TelemetryStoreReader* reader = &dataset->reader;
+	bool valid = fread(&dataset->index, sizeof(dataset->index), 1, file) == 1 &&
+		dataset->index.magic == STORE_INDEX_MAGIC && dataset->index.version == STORE_VERSION &&
+		dataset->index.blockCount == reader->header.blockCount && dataset->index.rowCount == reader->header.rowCount &&
+		dataset->index.environmentCount <= STORE_INDEX_MAX_ENVIRONMENTS;
+	if (valid) {
+		dataset->entries = malloc(((size_t)dataset->index.blockCount + 1) * sizeof(TelemetryIndexEntry));
+		valid = dataset->entries != NULL &&
+			fread(dataset->entries, sizeof(TelemetryIndexEntry), dataset->index.blockCount, file) == dataset->index.blockCount;
+	}
+	for (uint32_t b = 0; valid && b < dataset->index.blockCount; b++) {
+		valid = dataset->entries[b].offset == reader->blockOffsets[b];
+	}
+	fclose(file);
+	if (!valid) {
+		free(dataset->entries);
+		dataset->entries = NULL;
+	}
+	return valid;
+}
+
+// Função para reconstruir o índice em memória descodificando todos os blocos
+static int rebuildIndex(TelemetryDataset* dataset) {
+	const TelemetryStoreReader* reader = &dataset->reader;
+	memset(&dataset->index, 0, sizeof(dataset->index));
+	dataset->index.magic = STORE_INDEX_MAGIC;
+	dataset->index.version = STORE_VERSION;
+	dataset->entries = malloc(((size_t)reader->header.blockCount + 1) * sizeof(TelemetryIndexEntry));
+	if (dataset->entries == NULL) {
+		return -1;
+	}
+	for (uint32_t b = 0; b < reader->header.blockCount; b++) {
+		TelemetryBlock* block = dataset->block;
+		if (telemetryStoreReadBlock(reader, b, block) != 0) {
+			return -1;
+		}
+		telemetryIndexBlock(&dataset->index, &dataset->entries[b], block->rowCount, block->timestamps, block->errors,
+			(const float (*)[STORE_BLOCK_ROWS])block->temperatures, block->codes, block->dictionary);
+		dataset->entries[b].offset = reader->blockOffsets[b];
+	}
+	dataset->indexRebuilt = true;
+	return 0;
+}
+
+// Função para abrir um ficheiro com o seu índice (reconstruído se for preciso)
+int telemetryDatasetOpen(TelemetryDataset* dataset, const char* path) {
+	memset(dataset, 0, sizeof(*dataset));
+	if (telemetryStoreOpen(&dataset->reader, path) != 0) {
+		return -1;
+	}
+	dataset->block = malloc(sizeof(*dataset->block));
+	if (dataset->block == NULL || (!loadIndex(dataset, path) && rebuildIndex(dataset) != 0)) {
+		fprintf(stderr, "%s: failed to load the block index\n", path);
+		telemetryDatasetClose(dataset);
+		return -1;
+	}
+	return 0;
+}
+
+void telemetryDatasetClose(TelemetryDataset* dataset) {
+	telemetryStoreCloseReader(&dataset->reader);
+	free(dataset->entries);
+	free(dataset->block);
+	dataset->entries = NULL;
+	dataset->block = NULL;
+}
+
+// Função para verificar se o índice exclui um bloco
+static bool blockSkipped(const TelemetryIndexEntry* entry, const TelemetryQuery* query, uint32_t environmentMask) {
+	return entry->sampleCount == 0 || entry->maxTimestamp < query->from || entry->minTimestamp > query->to ||
+		(entry->environmentMask & environmentMask) == 0;
+}
+
+// Função para marcar os códigos do dicionário do bloco que correspondem ao ambiente pedido
+static void matchEnvironment(const TelemetryBlock* block, const char* environment, bool* matches) {
+	for (uint32_t i = 0; i < block->dictionaryCount; i++) {
+		matches[i] = environment == NULL || telemetryEnvironmentMatches(block->dictionary[i], environment);
+	}
+}
+
+static inline bool rowSelected(const TelemetryBlock* block, uint32_t row, const TelemetryQuery* query,
+	const bool* matches) {
+	return !block->errors[row] && block->timestamps[row] >= query->from && block->timestamps[row] <= query->to &&
+		matches[block->codes[row]];
+}
+
+static uint32_t queryEnvironmentMask(const TelemetryDataset* dataset, const TelemetryQuery* query) {
+	return query->environment == NULL ? UINT32_MAX : telemetryIndexEnvironmentMask(&dataset->index, query->environment);
+}
+
+// Função para descodificar um bloco que o índice não excluiu
+static int decodeBlock(TelemetryDataset* dataset, uint32_t index, TelemetryQueryStats* stats) {
+	if (telemetryStoreReadBlock(&dataset->reader, index, dataset->block) != 0) {
+		return -1;
+	}
+	stats->decoded++;
+	stats->rowsScanned += dataset->block->rowCount;
+	return 0;
+}
+
+// Função para entregar ao callback as linhas que passam os filtros
+int telemetryQueryRange(TelemetryDataset* dataset, const TelemetryQuery* query, TelemetryRowCallback callback,
+	void* context, TelemetryQueryStats* stats) {
+	uint32_t environmentMask = queryEnvironmentMask(dataset, query);
+	memset(stats, 0, sizeof(*stats));
+	stats->blocks = dataset->index.blockCount;
+	for (uint32_t b = 0; b < dataset->index.blockCount; b++) {
+		if (blockSkipped(&dataset->entries[b], query, environmentMask)) {
+			stats->skipped++;
+			continue;
+		}
+		if (decodeBlock(dataset, b, stats) != 0) {
+			return -1;
+		}
+		bool matches[STORE_MAX_DICTIONARY];
+		matchEnvironment(dataset->block, query->environment, matches);
+		for (uint32_t i = 0; i < dataset->block->rowCount; i++) {
+			if (rowSelected(dataset->block, i, query, matches)) {
+				callback(dataset->block, i, context);
+			}
+		}
+	}
+	return 0;
+}
+
+// Função para calcular contagem, mínimo, máximo e soma de um sensor
+// Blocos dentro do intervalo com um único ambiente (o pedido) são somados a partir do índice
+int telemetryQueryAggregate(TelemetryDataset* dataset, const TelemetryQuery* query, TelemetryAggregate* result,
+	TelemetryQueryStats* stats) {
+	uint32_t environmentMask = queryEnvironmentMask(dataset, query);
+	uint32_t overflowBit = 1u << (STORE_INDEX_MAX_ENVIRONMENTS - 1);
+	int s = query->sensor;
+	memset(stats, 0, sizeof(*stats));
+	stats->blocks = dataset->index.blockCount;
+	result->count = 0;
+	result->minimum = INFINITY;
+	result->maximum = -INFINITY;
+	result->sum = 0.0;
+
+	for (uint32_t b = 0; b < dataset->index.blockCount; b++) {
+		const TelemetryIndexEntry* entry = &dataset->entries[b];
+		if (blockSkipped(entry, query, environmentMask)) {
+			stats->skipped++;
+			continue;
+		}
+		bool inside = entry->minTimestamp >= query->from && entry->maxTimestamp <= query->to;
+		bool allRowsMatch = query->environment == NULL ||
+			((entry->environmentMask & ~environmentMask) == 0 && (entry->environmentMask & overflowBit) == 0);
+		if (inside && allRowsMatch) {
+			result->count += entry->sampleCount;
+			result->sum += entry->sum[s];
+			result->minimum = entry->minimum[s] < result->minimum ? entry->minimum[s] : result->minimum;
+			result->maximum = entry->maximum[s] > result->maximum ? entry->maximum[s] : result->maximum;
+			stats->fromIndex++;
+			continue;
+		}
+
+		if (decodeBlock(dataset, b, stats) != 0) {
+			return -1;
+		}
+		bool matches[STORE_MAX_DICTIONARY];
+		matchEnvironment(dataset->block, query->environment, matches);
+		const float* values = dataset->block->temperatures[s];
+		for (uint32_t i = 0; i < dataset->block->rowCount; i++) {
+			if (rowSelected(dataset->block, i, query, matches)) {
+				result->count++;
+				result->sum += values[i];
+				result->minimum = values[i] < result->minimum ? values[i] : result->minimum;
+				result->maximum = values[i] > result->maximum ? values[i] : result->maximum;
+			}
+		}
+	}
+	return 0;
+}
+
+// Função para encontrar as passagens de um sensor pelo limiar (acima = valor > limiar)
+// Um bloco todo do mesmo lado do limiar que a última amostra não pode ter passagens e não é lido
+int telemetryQueryCrossings(TelemetryDataset* dataset, const TelemetryQuery* query, float threshold,
+	TelemetryCrossingCallback callback, void* context, TelemetryQueryStats* stats) {
+	uint32_t environmentMask = queryEnvironmentMask(dataset, query);
+	int s = query->sensor;
+	int side = -1; // -1 = ainda sem amostras, 0 = abaixo, 1 = acima
+	memset(stats, 0, sizeof(*stats));
+	stats->blocks = dataset->index.blockCount;
+
+	for (uint32_t b = 0; b < dataset->index.blockCount; b++) {
+		const TelemetryIndexEntry* entry = &dataset->entries[b];
+		if (blockSkipped(entry, query, environmentMask) ||
+			(side == 1 && entry->minimum[s] > threshold) || (side == 0 && entry->maximum[s] <= threshold)) {
+			stats->skipped++;
+			continue;
+		}
+		if (decodeBlock(dataset, b, stats) != 0) {
+			return -1;
+		}
+		bool matches[STORE_MAX_DICTIONARY];
+		matchEnvironment(dataset->block, query->environment, matches);
+		const float* values = dataset->block->temperatures[s];
+		for (uint32_t i = 0; i < dataset->block->rowCount; i++) {
+			if (!rowSelected(dataset->block, i, query, matches)) {
+				continue;
+			}
+			int current = values[i] > threshold;
+			if (side >= 0 && current != side) {
+				callback(dataset->block->timestamps[i], values[i], current == 1, context);
+			}
+			side = current;
+		}
+	}
+	return 0;
+}
+
+// Estrutura QueryPrinter: contexto dos callbacks da linha de comandos
+typedef struct {
+	int sensor;
+	unsigned long rows;
+} QueryPrinter;
+
+static void printRow(const TelemetryBlock* block, uint32_t row, void* context) {
+	QueryPrinter* printer = context;
+	char timestamp[STORE_TIMESTAMP_LENGTH + 1];
+	telemetryStoreFormatTimestamp(timestamp, block->timestamps[row]);
+	printf("%s", timestamp);
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		if (printer->sensor < 0 || printer->sensor == s) {
+			printf(", %f", block->temperatures[s][row]);
+		}
+	}
+	printf(", %s\n", block->dictionary[block->codes[row]]);
+	printer->rows++;
+}
+
+static void printCrossing(int64_t timestamp, float value, bool rising, void* context) {
+	QueryPrinter* printer = context;
+	char text[STORE_TIMESTAMP_LENGTH + 1];
+	telemetryStoreFormatTimestamp(text, timestamp);
+	printf("%s, %s, %f\n", text, rising ? "rising" : "falling", value);
+	printer->rows++;
+}
+
+// Função da consulta da linha de comandos (--query); o resumo do trabalho feito vai para stderr
+int runTelemetryQuery(const char* path, const TelemetryQuery* query, TelemetryQueryKind kind, float threshold) {
+	// -1 = todos os sensores (só na consulta por intervalo)
+	if (query->sensor < -1 || query->sensor >= STORE_SENSORS) {
+		fprintf(stderr, "Invalid sensor: %d (use 1 to %d)\n", query->sensor + 1, STORE_SENSORS);
+		return EXIT_FAILURE;
+	}
+	TelemetryDataset dataset;
+	if (telemetryDatasetOpen(&dataset, path) != 0) {
+		return EXIT_FAILURE;
+	}
+	if (dataset.indexRebuilt) {
+		fprintf(stderr, "Index %s%s missing or stale, rebuilt in memory\n", path, STORE_INDEX_SUFFIX);
+	}
+
+	TelemetryQueryStats stats;
+	QueryPrinter printer = { query->sensor, 0 };
+	char sensorName[24]; // "THERM-" e qualquer int
+	snprintf(sensorName, sizeof(sensorName), "THERM-%02d", query->sensor + 1);
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int result;
+	if (kind == QUERY_AGGREGATE) {
+		TelemetryAggregate aggregate;
+		result = telemetryQueryAggregate(&dataset, query, &aggregate, &stats);
+		if (result == 0 && aggregate.count > 0) {
+			printf("%s: %llu samples, min %f, max %f, mean %f\n", sensorName, (unsigned long long)aggregate.count,
+				aggregate.minimum, aggregate.maximum, aggregate.sum / (double)aggregate.count);
+		}
+		else if (result == 0) {
+			printf("%s: no samples\n", sensorName);
+		}
+	}
+	else if (kind == QUERY_CROSSINGS) {
+		result = telemetryQueryCrossings(&dataset, query, threshold, printCrossing, &printer, &stats);
+		if (result == 0) {
+			printf("%s crossed %f %lu times\n", sensorName, threshold, printer.rows);
+		}
+	}
+	else {
+		result = telemetryQueryRange(&dataset, query, printRow, &printer, &stats);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (result == 0) {
+		fprintf(stderr, "Blocks: %u, skipped by index: %u, answered from index: %u, decoded: %u (%llu rows) in %.2f ms\n",
+			stats.blocks, stats.skipped, stats.fromIndex, stats.decoded, (unsigned long long)stats.rowsScanned,
+			(double)(end.tv_sec - start.tv_sec) * 1e3 + (double)(end.tv_nsec - start.tv_nsec) / 1e6);
+	}
+	telemetryDatasetClose(&dataset);
+	return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
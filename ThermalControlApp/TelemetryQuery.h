@@ -0,0 +1,63 @@
+﻿// TelemetryQuery.h : Consultas sobre o formato colunar, com o índice de blocos a evitar a leitura completa.
+
+#ifndef TELEMETRY_QUERY_H
+#define TELEMETRY_QUERY_H
+
+#include "TelemetryStore.h"
+
+// Tipo de consulta da linha de comandos
+typedef enum {
+	QUERY_RANGE,                // Linhas no intervalo
+	QUERY_AGGREGATE,            // Contagem, mínimo, máximo e média de um sensor
+	QUERY_CROSSINGS             // Passagens de um sensor por um limiar
+} TelemetryQueryKind;
+
+// Estrutura TelemetryQuery: filtros comuns a todas as consultas
+typedef struct {
+	int64_t from;               // Inclusivo (ms, como em TelemetryRecord)
+	int64_t to;                 // Inclusivo
+	int sensor;                 // 0..STORE_SENSORS-1; -1 = todos (só nas consultas de intervalo)
+	const char* environment;    // NULL = qualquer ambiente
+} TelemetryQuery;
+
+// Estrutura TelemetryQueryStats: trabalho feito por uma consulta
+typedef struct {
+	uint32_t blocks;
+	uint32_t skipped;           // Excluídos pelo índice
+	uint32_t fromIndex;         // Respondidos só com o índice (agregados)
+	uint32_t decoded;
+	uint64_t rowsScanned;
+} TelemetryQueryStats;
+
+// Estrutura TelemetryAggregate
+typedef struct {
+	uint64_t count;
+	float minimum;
+	float maximum;
+	double sum;
+} TelemetryAggregate;
+
+// Estrutura TelemetryDataset: ficheiro mapeado, índice e bloco descodificado
+typedef struct {
+	TelemetryStoreReader reader;
+	TelemetryIndexHeader index;
+	TelemetryIndexEntry* entries;
+	bool indexRebuilt;          // Verdadeiro se o .idx faltava ou não correspondia ao ficheiro
+	TelemetryBlock* block;
+} TelemetryDataset;
+
+typedef void (*TelemetryRowCallback)(const TelemetryBlock* block, uint32_t row, void* context);
+typedef void (*TelemetryCrossingCallback)(int64_t timestamp, float value, bool rising, void* context);
+
+// Funções das consultas
+int telemetryDatasetOpen(TelemetryDataset* dataset, const char* path);
+void telemetryDatasetClose(TelemetryDataset* dataset);
+int telemetryQueryRange(TelemetryDataset* dataset, const TelemetryQuery* query, TelemetryRowCallback callback,
+	void* context, TelemetryQueryStats* stats);
+int telemetryQueryAggregate(TelemetryDataset* dataset, const TelemetryQuery* query, TelemetryAggregate* result,
+	TelemetryQueryStats* stats);
+int telemetryQueryCrossings(TelemetryDataset* dataset, const TelemetryQuery* query, float threshold,
+	TelemetryCrossingCallback callback, void* context, TelemetryQueryStats* stats);
+int runTelemetryQuery(const char* path, const TelemetryQuery* query, TelemetryQueryKind kind, float threshold);
+
+#endif // TELEMETRY_QUERY_H
@@ -0,0 +1,212 @@
+﻿// TelemetryServer.c : Cada trama é posta na fila de cada subscritor e as filas são escritas
+// uma vez por ciclo, sem bloquear. Um subscritor lento só perde as suas próprias tramas.
+//
+// Protocolo: o subscritor liga-se ao socket e pode enviar o nome de uma política
+// ("drop-oldest", "drop-newest" ou "coalesce"); depois recebe registos com uma ou mais tramas.
+
+#define _GNU_SOURCE // accept4
+
+#include "TelemetryServer.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static TelemetrySubscriber* findSubscriber(TelemetryServer* server, int fd, size_t* index) {
+	for (size_t i = 0; i < server->subscriberCount; i++) {
+		if (server->subscribers[i]->fd == fd) {
+			*index = i;
+			return server->subscribers[i];
+		}
+	}
+	return NULL;
+}
+
+// Função para retirar um subscritor (desligou-se ou falhou a escrita)
+static void removeSubscriber(TelemetryServer* server, size_t index, int fd) {
+	TelemetrySubscriber* subscriber = server->subscribers[index];
+	eventLoopRemove(server->loop, fd);
+	frameWriterClose(&subscriber->writer);
+	free(subscriber);
+	server->subscribers[index] = server->subscribers[--server->subscriberCount];
+	server->disconnected++;
+}
+
+// Função chamada quando um subscritor envia dados: nome da política ou fim da ligação
+static void onSubscriberReadable(int fd, uint32_t events, void* context) {
+	TelemetryServer* server = context;
+	size_t index;
+	TelemetrySubscriber* subscriber = findSubscriber(server, fd, &index);
+	if (subscriber == NULL) {
+		return;
+	}
+
+	char request[32];
+	ssize_t count = recv(fd, request, sizeof(request) - 1, MSG_DONTWAIT);
+	if (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		return;
+	}
+	if (count <= 0) {
+		removeSubscriber(server, index, fd);
+		return;
+	}
+
+	request[count] = '\0';
+	request[strcspn(request, "\r\n")] = '\0';
+	if (overflowPolicyFromName(request, &subscriber->writer.policy) != 0) {
+		fprintf(stderr, "Subscriber %u: unknown policy \"%s\"\n", subscriber->id, request);
+	}
+}
+
+// Função chamada quando há ligações novas no socket
+static void onListenReadable(int fd, uint32_t events, void* context) {
+	TelemetryServer* server = context;
+	int client;
+	while ((client = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+		TelemetrySubscriber* subscriber = NULL;
+		if (server->subscriberCount < TELEMETRY_MAX_SUBSCRIBERS) {
+			subscriber = malloc(sizeof(TelemetrySubscriber));
+		}
+		if (subscriber == NULL) {
+			server->rejected++;
+			close(client);
+			continue;
+		}
+
+		frameWriterInit(&subscriber->writer, client, server->defaultPolicy);
+		subscriber->fd = client;
+		subscriber->id = server->nextId++;
+		if (eventLoopAdd(server->loop, client, EPOLLIN, onSubscriberReadable, server) != 0) {
+			free(subscriber);
+			close(client);
+			continue;
+		}
+		server->subscribers[server->subscriberCount++] = subscriber;
+	}
+	if (errno != EAGAIN && errno != EWOULDBLOCK) {
+		perror("Failed to accept subscriber");
+	}
+}
+
+// Função para abrir o socket e registá-lo no ciclo de eventos
+int telemetryServerOpen(TelemetryServer* server, const char* path, EventLoop* loop, OverflowPolicy policy) {
+	memset(server, 0, sizeof(*server));
+	server->path = path;
+	server->loop = loop;
+	server->defaultPolicy = policy;
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "Socket path too long: %s\n", path);
+		return -1;
+	}
+	strcpy(address.sun_path, path);
+
+	server->listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (server->listenFd == -1) {
+		perror("Failed to create telemetry socket");
+		return -1;
+	}
+
+	unlink(path); // Socket deixado por uma execução anterior
+	if (bind(server->listenFd, (struct sockaddr*)&address, sizeof(address)) == -1 ||
+		listen(server->listenFd, TELEMETRY_MAX_SUBSCRIBERS) == -1) {
+		perror("Failed to listen on telemetry socket");
+		close(server->listenFd);
+		return -1;
+	}
+
+	if (eventLoopAdd(loop, server->listenFd, EPOLLIN, onListenReadable, server) != 0) {
+		close(server->listenFd);
+		unlink(path);
+		return -1;
+	}
+	return 0;
+}
+
+void telemetryServerClose(TelemetryServer* server) {
+	while (server->subscriberCount > 0) {
+		size_t last = server->subscriberCount - 1;
+		removeSubscriber(server, last, server->subscribers[last]->fd);
+	}
+	eventLoopRemove(server->loop, server->listenFd);
+	close(server->listenFd);
+	unlink(server->path);
+}
+
+// Função para pôr uma trama na fila de todos os subscritores
+void telemetryServerPublish(TelemetryServer* server, const WireFrame* frame) {
+	for (size_t i = 0; i < server->subscriberCount; i++) {
+		frameWriterAppend(&server->subscribers[i]->writer, frame);
+	}
+}
+
+// Função para escrever as filas; cada subscritor recebe um registo por lote
+void telemetryServerFlush(TelemetryServer* server) {
+	for (size_t i = 0; i < server->subscriberCount; i++) {
+		frameWriterFlush(&server->subscribers[i]->writer);
+	}
+	telemetryServerPrune(server);
+}
+
+// Função para retirar os subscritores cuja ligação fechou durante a escrita
+void telemetryServerPrune(TelemetryServer* server) {
+	size_t i = 0;
+	while (i < server->subscriberCount) {
+		TelemetrySubscriber* subscriber = server->subscribers[i];
+		if (subscriber->writer.fd == -1) {
+			// O FrameWriter já fechou o descritor
+			removeSubscriber(server, i, subscriber->fd);
+			continue;
+		}
+		i++;
+	}
+}
+
+// Função para subscrever o servidor e mostrar as tramas recebidas (um cliente como o VUI)
+int runTelemetrySubscriber(const char* path, const char* policyName) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+
+	int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd == -1 || connect(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+		perror("Failed to connect to telemetry socket");
+		if (fd != -1) {
+			close(fd);
+		}
+		return EXIT_FAILURE;
+	}
+	if (policyName != NULL && send(fd, policyName, strlen(policyName), 0) == -1) {
+		perror("Failed to send subscriber policy");
+	}
+
+	FrameReader* reader = malloc(sizeof(FrameReader));
+	if (reader == NULL) {
+		close(fd);
+		return EXIT_FAILURE;
+	}
+	frameReaderInit(reader, fd);
+
+	WireFrame frame;
+	while (frameReaderFill(reader) > 0) {
+		while (frameReaderNext(reader, &frame)) {
+			printf("Frame %u: %s %.2f, Heater %s\n", frame.sequence,
+				frame.type == WIRE_TEMPERATURES ? "Temperature" : "Control Output",
+				frame.sensorCount > 0 ? frame.values[0] : 0.0f, wireHeaterOn(&frame, 0) ? "ON" : "OFF");
+		}
+		fflush(stdout);
+	}
+
+	printf("Telemetry server closed the connection (%lu frames received)\n", reader->frames);
+	free(reader);
+	close(fd);
+	return EXIT_SUCCESS;
+}
+
+#endif // __linux__
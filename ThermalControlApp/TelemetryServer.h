@@ -0,0 +1,45 @@
+﻿// TelemetryServer.h : Distribuição das tramas a vários subscritores por um socket Unix (SOCK_SEQPACKET).
+
+#ifndef TELEMETRY_SERVER_H
+#define TELEMETRY_SERVER_H
+
+#include "ThermalControlApp.h"
+#include "FrameStream.h"
+
+#define TELEMETRY_MAX_SUBSCRIBERS 16
+
+#ifdef __linux__
+
+#include "EventLoop.h"
+
+// Estrutura TelemetrySubscriber: cada subscritor tem a sua fila e a sua política
+typedef struct {
+	FrameWriter writer;
+	int fd;                 // Guardado à parte: writer.fd passa a -1 quando a ligação fecha
+	unsigned id;
+} TelemetrySubscriber;
+
+// Estrutura TelemetryServer
+typedef struct {
+	int listenFd;
+	const char* path;
+	EventLoop* loop;
+	OverflowPolicy defaultPolicy;           // Política de quem não pede outra
+	TelemetrySubscriber* subscribers[TELEMETRY_MAX_SUBSCRIBERS];
+	size_t subscriberCount;
+	unsigned nextId;
+	unsigned long rejected;                 // Ligações recusadas com o servidor cheio
+	unsigned long disconnected;
+} TelemetryServer;
+
+// Funções do servidor
+int telemetryServerOpen(TelemetryServer* server, const char* path, EventLoop* loop, OverflowPolicy policy);
+void telemetryServerClose(TelemetryServer* server);
+void telemetryServerPublish(TelemetryServer* server, const WireFrame* frame);
+void telemetryServerFlush(TelemetryServer* server);
+void telemetryServerPrune(TelemetryServer* server);
+int runTelemetrySubscriber(const char* path, const char* policyName);
+
+#endif // __linux__
+
+#endif // TELEMETRY_SERVER_H
@@ -0,0 +1,1168 @@
+﻿// TelemetryStore.c : Cada coluna é comprimida com o código que melhor se ajusta aos seus dados
+// (delta-de-delta nos tempos, XOR nos floats, bits nos estados) e lida sem cópias a partir do mmap.
+
+#include "TelemetryStore.h"
+#include "TelemetryParser.h"
+#include "Decimation.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ctype.h>
+
+#define STORE_ENCODED_CAPACITY (sizeof(TelemetryStoreBlockHeader) + STORE_BLOCK_ROWS * 40 + \
+	STORE_MAX_DICTIONARY * STORE_MAX_STRING)
+
+// Estrutura BitWriter: escrita bit a bit, do bit mais significativo para o menos significativo
+typedef struct {
+	uint8_t* data;
+	size_t size;
+	uint64_t buffer;
+	int pending;
+} BitWriter;
+
+// Estrutura BitReader
+typedef struct {
+	const uint8_t* data;
+	size_t size;
+	size_t position;
+	uint64_t buffer;
+	int available;
+} BitReader;
+
+// Função para escrever até 32 bits
+static inline void bitWrite(BitWriter* writer, uint64_t value, int count) {
+	if (count == 0) {
+		return;
+	}
+	writer->buffer = (writer->buffer << count) | (value & ((1ull << count) - 1));
+	writer->pending += count;
+	while (writer->pending >= 8) {
+		writer->pending -= 8;
+		writer->data[writer->size++] = (uint8_t)(writer->buffer >> writer->pending);
+	}
+}
+
+// Função para completar o último byte; devolve o tamanho da coluna
+static size_t bitFinish(BitWriter* writer) {
+	if (writer->pending > 0) {
+		writer->data[writer->size++] = (uint8_t)(writer->buffer << (8 - writer->pending));
+		writer->pending = 0;
+	}
+	return writer->size;
+}
+
+// Função para ler até 32 bits; para lá do fim da coluna lê zeros
+static inline uint32_t bitRead(BitReader* reader, int count) {
+	if (count == 0) {
+		return 0;
+	}
+	while (reader->available < count) {
+		reader->buffer = (reader->buffer << 8) | (reader->position < reader->size ? reader->data[reader->position++] : 0);
+		reader->available += 8;
+	}
+	reader->available -= count;
+	return (uint32_t)((reader->buffer >> reader->available) & ((1ull << count) - 1));
+}
+
+static inline int64_t signExtend(uint64_t value, int bits) {
+	return (int64_t)(value << (64 - bits)) >> (64 - bits);
+}
+
+// Função para calcular os bits necessários para um índice menor do que count
+static int codeWidth(uint32_t count) {
+	return count <= 1 ? 0 : 32 - __builtin_clz(count - 1);
+}
+
+static double elapsedMs(const struct timespec* start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)(now.tv_sec - start->tv_sec) * 1e3 + (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static const char* storeColumnName(StoreColumn column) {
+	switch (column) {
+	case STORE_COLUMN_TIMESTAMPS: return "timestamps";
+	case STORE_COLUMN_KINDS: return "kinds";
+	case STORE_COLUMN_THERM1: return "THERM-01";
+	case STORE_COLUMN_THERM2: return "THERM-02";
+	case STORE_COLUMN_THERM3: return "THERM-03";
+	case STORE_COLUMN_THERM4: return "THERM-04";
+	case STORE_COLUMN_HEATERS: return "heaters";
+	case STORE_COLUMN_DICTIONARY: return "dictionary";
+	case STORE_COLUMN_CODES: return "codes";
+	default: return "unknown";
+	}
+}
+
+// Função para converter uma data do calendário gregoriano em dias desde 1970-01-01
+static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+	year -= month <= 2;
+	int64_t era = (year >= 0 ? year : year - 399) / 400;
+	unsigned yearOfEra = (unsigned)(year - era * 400);
+	unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + (int64_t)dayOfEra - 719468;
+}
+
+// Função inversa de daysFromCivil
+static void civilFromDays(int64_t days, int64_t* year, unsigned* month, unsigned* day) {
+	days += 719468;
+	int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	unsigned dayOfEra = (unsigned)(days - era * 146097);
+	unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+	*day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+	*month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+	*year = (int64_t)yearOfEra + era * 400 + (*month <= 2);
+}
+
+static bool parseDigits(const char** cursor, const char* end, int count, unsigned* value) {
+	*value = 0;
+	for (int i = 0; i < count; i++) {
+		if (*cursor >= end || (unsigned)(**cursor - '0') > 9) {
+			return false;
+		}
+		*value = *value * 10 + (unsigned)(**cursor - '0');
+		(*cursor)++;
+	}
+	return true;
+}
+
+static bool expectChar(const char** cursor, const char* end, char expected) {
+	if (*cursor >= end || **cursor != expected) {
+		return false;
+	}
+	(*cursor)++;
+	return true;
+}
+
+// Função para ler o timestamp do TSL ("%Y-%m-%dT%H:%M:%S.mmm") em ms, sem fuso horário
+bool telemetryStoreParseTimestamp(const char* text, size_t length, int64_t* timestamp) {
+	const char* cursor = text;
+	const char* end = text + length;
+	unsigned year, month, day, hour, minute, second, millisecond = 0;
+	if (!parseDigits(&cursor, end, 4, &year) || !expectChar(&cursor, end, '-') ||
+		!parseDigits(&cursor, end, 2, &month) || !expectChar(&cursor, end, '-') ||
+		!parseDigits(&cursor, end, 2, &day) || !expectChar(&cursor, end, 'T') ||
+		!parseDigits(&cursor, end, 2, &hour) || !expectChar(&cursor, end, ':') ||
+		!parseDigits(&cursor, end, 2, &minute) || !expectChar(&cursor, end, ':') ||
+		!parseDigits(&cursor, end, 2, &second)) {
+		return false;
+	}
+	if (cursor < end && (!expectChar(&cursor, end, '.') || !parseDigits(&cursor, end, 3, &millisecond))) {
+		return false;
+	}
+	if (cursor != end || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+		return false;
+	}
+	int64_t days = daysFromCivil(year, month, day);
+	*timestamp = ((days * 24 + hour) * 60 + minute) * 60000 + (int64_t)second * 1000 + millisecond;
+	return true;
+}
+
+// Função para escrever um número com um número fixo de dígitos, seguido de um separador
+static char* formatDigits(char* out, unsigned value, int count, char separator) {
+	for (int i = count - 1; i >= 0; i--) {
+		out[i] = (char)('0' + value % 10);
+		value /= 10;
+	}
+	out[count] = separator;
+	return out + count + 1;
+}
+
+// Função para escrever um timestamp no formato do TSL (STORE_TIMESTAMP_LENGTH caracteres e '\0')
+// Cada campo tem largura fixa; anos fora de 0000-9999 não cabem no formato e ficam nos extremos
+void telemetryStoreFormatTimestamp(char* out, int64_t timestamp) {
+	int64_t days = timestamp >= 0 ? timestamp / 86400000 : -((-timestamp + 86399999) / 86400000);
+	int64_t milliseconds = timestamp - days * 86400000;
+	int64_t year;
+	unsigned month, day;
+	civilFromDays(days, &year, &month, &day);
+	year = year < 0 ? 0 : year > 9999 ? 9999 : year;
+	out = formatDigits(out, (unsigned)year, 4, '-');
+	out = formatDigits(out, month, 2, '-');
+	out = formatDigits(out, day, 2, 'T');
+	out = formatDigits(out, (unsigned)(milliseconds / 3600000), 2, ':');
+	out = formatDigits(out, (unsigned)(milliseconds / 60000 % 60), 2, ':');
+	out = formatDigits(out, (unsigned)(milliseconds / 1000 % 60), 2, '.');
+	formatDigits(out, (unsigned)(milliseconds % 1000), 3, '\0');
+}
+
+// Função para comparar um ambiente gravado com o pedido (ECLIPSE = Eclipse, SUN_EXPOSURE = Sun Exposure)
+bool telemetryEnvironmentMatches(const char* stored, const char* name) {
+	for (; *stored != '\0' && *name != '\0'; stored++, name++) {
+		char a = *stored == '_' ? ' ' : (char)tolower((unsigned char)*stored);
+		char b = *name == '_' ? ' ' : (char)tolower((unsigned char)*name);
+		if (a != b) {
+			return false;
+		}
+	}
+	return *stored == *name;
+}
+
+// Função para obter os bits do índice que podem conter um ambiente
+uint32_t telemetryIndexEnvironmentMask(const TelemetryIndexHeader* index, const char* name) {
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < index->environmentCount; i++) {
+		if (telemetryEnvironmentMatches(index->environments[i], name)) {
+			mask |= 1u << i;
+		}
+	}
+	if (index->environmentCount == STORE_INDEX_MAX_ENVIRONMENTS) {
+		mask |= 1u << (STORE_INDEX_MAX_ENVIRONMENTS - 1); // Pode estar entre os que já não couberam
+	}
+	return mask;
+}
+
+// Função para obter o bit de um ambiente, acrescentando-o ao índice se for novo
+static uint32_t environmentBit(TelemetryIndexHeader* index, const char* name) {
+	for (uint32_t i = 0; i < index->environmentCount; i++) {
+		if (strcmp(index->environments[i], name) == 0) {
+			return 1u << i;
+		}
+	}
+	if (index->environmentCount == STORE_INDEX_MAX_ENVIRONMENTS) {
+		return 1u << (STORE_INDEX_MAX_ENVIRONMENTS - 1);
+	}
+	snprintf(index->environments[index->environmentCount], STORE_MAX_STRING, "%s", name);
+	return 1u << index->environmentCount++;
+}
+
+// Função para resumir um bloco numa entrada do índice (offset é preenchido por quem chama)
+void telemetryIndexBlock(TelemetryIndexHeader* index, TelemetryIndexEntry* entry, uint32_t count,
+	const int64_t* timestamps, const uint8_t* errors, const float (*temperatures)[STORE_BLOCK_ROWS],
+	const uint8_t* codes, const char* const* dictionary) {
+	uint32_t codeBits[STORE_MAX_DICTIONARY + 1] = { 0 };
+	entry->rowCount = count;
+	entry->sampleCount = 0;
+	entry->environmentMask = 0;
+	entry->reserved = 0;
+	entry->minTimestamp = INT64_MAX;
+	entry->maxTimestamp = INT64_MIN;
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		entry->minimum[s] = INFINITY;
+		entry->maximum[s] = -INFINITY;
+		entry->sum[s] = 0.0;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (timestamps[i] < entry->minTimestamp) {
+			entry->minTimestamp = timestamps[i];
+		}
+		if (timestamps[i] > entry->maxTimestamp) {
+			entry->maxTimestamp = timestamps[i];
+		}
+		if (errors[i]) {
+			continue;
+		}
+		entry->sampleCount++;
+		if (codeBits[codes[i]] == 0) {
+			codeBits[codes[i]] = environmentBit(index, dictionary[codes[i]]);
+		}
+		entry->environmentMask |= codeBits[codes[i]];
+		for (int s = 0; s < STORE_SENSORS; s++) {
+			float value = temperatures[s][i];
+			entry->minimum[s] = value < entry->minimum[s] ? value : entry->minimum[s];
+			entry->maximum[s] = value > entry->maximum[s] ? value : entry->maximum[s];
+			entry->sum[s] += value;
+		}
+	}
+	if (entry->sampleCount == 0) {
+		for (int s = 0; s < STORE_SENSORS; s++) {
+			entry->minimum[s] = NAN;
+			entry->maximum[s] = NAN;
+		}
+	}
+	index->blockCount++;
+	index->rowCount += count;
+}
+
+// Função para codificar os tempos do bloco: '0' repete o intervalo, senão prefixo e delta-de-delta
+static void encodeTimestamps(BitWriter* bits, const int64_t* timestamps, uint32_t count) {
+	int64_t previousDelta = 0;
+	for (uint32_t i = 1; i < count; i++) {
+		int64_t delta = timestamps[i] - timestamps[i - 1];
+		int64_t deltaOfDelta = delta - previousDelta;
+		previousDelta = delta;
+		if (deltaOfDelta == 0) {
+			bitWrite(bits, 0x0, 1);
+		}
+		else if (deltaOfDelta >= -64 && deltaOfDelta <= 63) {
+			bitWrite(bits, 0x2, 2);
+			bitWrite(bits, (uint64_t)deltaOfDelta, 7);
+		}
+		else if (deltaOfDelta >= -256 && deltaOfDelta <= 255) {
+			bitWrite(bits, 0x6, 3);
+			bitWrite(bits, (uint64_t)deltaOfDelta, 9);
+		}
+		else if (deltaOfDelta >= -2048 && deltaOfDelta <= 2047) {
+			bitWrite(bits, 0xE, 4);
+			bitWrite(bits, (uint64_t)deltaOfDelta, 12);
+		}
+		else {
+			bitWrite(bits, 0xF, 4);
+			bitWrite(bits, (uint64_t)deltaOfDelta >> 32, 32);
+			bitWrite(bits, (uint64_t)deltaOfDelta, 32);
+		}
+	}
+}
+
+static void decodeTimestamps(BitReader* bits, int64_t* timestamps, uint32_t count) {
+	int64_t delta = 0;
+	for (uint32_t i = 1; i < count; i++) {
+		if (bitRead(bits, 1) != 0) {
+			if (bitRead(bits, 1) == 0) {
+				delta += signExtend(bitRead(bits, 7), 7);
+			}
+			else if (bitRead(bits, 1) == 0) {
+				delta += signExtend(bitRead(bits, 9), 9);
+			}
+			else if (bitRead(bits, 1) == 0) {
+				delta += signExtend(bitRead(bits, 12), 12);
+			}
+			else {
+				uint64_t high = bitRead(bits, 32);
+				delta += (int64_t)(high << 32 | bitRead(bits, 32));
+			}
+		}
+		timestamps[i] = timestamps[i - 1] + delta;
+	}
+}
+
+// Função para codificar uma coluna de temperaturas: '0' repete o valor; '10' reutiliza a janela de
+// bits significativos do XOR anterior; '11' envia zeros à esquerda (5 bits), tamanho (5 bits) e bits
+static void encodeFloats(BitWriter* bits, const float* values, const uint8_t* errors, uint32_t count) {
+	bool first = true;
+	uint32_t previous = 0;
+	int previousLeading = -1;
+	int previousTrailing = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (errors[i]) {
+			continue;
+		}
+		uint32_t value;
+		memcpy(&value, &values[i], sizeof(value));
+		if (first) {
+			bitWrite(bits, value, 32);
+			first = false;
+			previous = value;
+			continue;
+		}
+		uint32_t xor = value ^ previous;
+		previous = value;
+		if (xor == 0) {
+			bitWrite(bits, 0x0, 1);
+			continue;
+		}
+		int leading = __builtin_clz(xor);
+		int trailing = __builtin_ctz(xor);
+		if (previousLeading >= 0 && leading >= previousLeading && trailing >= previousTrailing) {
+			bitWrite(bits, 0x2, 2);
+			bitWrite(bits, xor >> previousTrailing, 32 - previousLeading - previousTrailing);
+		}
+		else {
+			int meaningful = 32 - leading - trailing;
+			bitWrite(bits, 0x3, 2);
+			bitWrite(bits, (uint64_t)leading, 5);
+			bitWrite(bits, (uint64_t)(meaningful - 1), 5);
+			bitWrite(bits, xor >> trailing, meaningful);
+			previousLeading = leading;
+			previousTrailing = trailing;
+		}
+	}
+}
+
+static void decodeFloats(BitReader* bits, float* values, const uint8_t* errors, uint32_t count) {
+	bool first = true;
+	uint32_t previous = 0;
+	int leading = 0;
+	int meaningful = 32;
+	for (uint32_t i = 0; i < count; i++) {
+		if (errors[i]) {
+			values[i] = NAN;
+			continue;
+		}
+		if (first) {
+			previous = bitRead(bits, 32);
+			first = false;
+		}
+		else if (bitRead(bits, 1) != 0) {
+			if (bitRead(bits, 1) != 0) {
+				leading = (int)bitRead(bits, 5);
+				meaningful = (int)bitRead(bits, 5) + 1;
+			}
+			previous ^= bitRead(bits, meaningful) << (32 - leading - meaningful);
+		}
+		memcpy(&values[i], &previous, sizeof(previous));
+	}
+}
+
+// Função para libertar o que telemetryStoreCreate reservou, quando a criação falha
+static void releaseCreatedWriter(TelemetryStoreWriter* writer) {
+	free(writer->encoded);
+	free(writer->indexPath);
+	if (writer->file != NULL) {
+		fclose(writer->file);
+	}
+	writer->encoded = NULL;
+	writer->indexPath = NULL;
+	writer->file = NULL;
+}
+
+// Função para abrir um ficheiro novo; o cabeçalho é reescrito em telemetryStoreClose
+int telemetryStoreCreate(TelemetryStoreWriter* writer, const char* path) {
+	memset(writer, 0, sizeof(*writer));
+	writer->header.magic = STORE_MAGIC;
+	writer->header.version = STORE_VERSION;
+	writer->header.sensorCount = STORE_SENSORS;
+	writer->index.magic = STORE_INDEX_MAGIC;
+	writer->index.version = STORE_VERSION;
+	writer->offset = sizeof(writer->header);
+	writer->encoded = malloc(STORE_ENCODED_CAPACITY);
+	writer->indexPath = malloc(strlen(path) + sizeof(STORE_INDEX_SUFFIX));
+	writer->file = fopen(path, "wb");
+	if (writer->encoded == NULL || writer->indexPath == NULL || writer->file == NULL) {
+		perror("Failed to create telemetry store");
+		releaseCreatedWriter(writer);
+		return -1;
+	}
+	sprintf(writer->indexPath, "%s%s", path, STORE_INDEX_SUFFIX);
+	if (fwrite(&writer->header, sizeof(writer->header), 1, writer->file) != 1) {
+		perror("Failed to write telemetry store");
+		releaseCreatedWriter(writer);
+		return -1;
+	}
+	return 0;
+}
+
+// Função para codificar e escrever o bloco em construção
+static int flushBlock(TelemetryStoreWriter* writer) {
+	uint32_t count = writer->rowCount;
+	if (count == 0) {
+		return 0;
+	}
+
+	// Entrada do índice, calculada antes da codificação
+	if (writer->index.blockCount == writer->entryCapacity) {
+		size_t capacity = writer->entryCapacity > 0 ? writer->entryCapacity * 2 : 64;
+		TelemetryIndexEntry* entries = realloc(writer->entries, capacity * sizeof(*entries));
+		if (entries == NULL) {
+			perror("Failed to grow telemetry index");
+			return -1;
+		}
+		writer->entries = entries;
+		writer->entryCapacity = capacity;
+	}
+	const char* dictionary[STORE_MAX_DICTIONARY];
+	for (uint32_t i = 0; i < writer->dictionaryCount; i++) {
+		dictionary[i] = writer->dictionary[i];
+	}
+	TelemetryIndexEntry* entry = &writer->entries[writer->index.blockCount];
+	telemetryIndexBlock(&writer->index, entry, count, writer->timestamps, writer->errors,
+		(const float (*)[STORE_BLOCK_ROWS])writer->temperatures, writer->codes, dictionary);
+	entry->offset = writer->offset;
+
+	TelemetryStoreBlockHeader header;
+	memset(&header, 0, sizeof(header));
+	header.rowCount = count;
+	header.dictionaryCount = writer->dictionaryCount;
+	header.firstTimestamp = writer->timestamps[0];
+	header.lastTimestamp = writer->timestamps[count - 1];
+
+	uint8_t* out = writer->encoded + sizeof(header);
+	for (int column = 0; column < STORE_COLUMN_COUNT; column++) {
+		BitWriter bits = { out, 0, 0, 0 };
+		switch (column) {
+		case STORE_COLUMN_TIMESTAMPS:
+			encodeTimestamps(&bits, writer->timestamps, count);
+			break;
+		case STORE_COLUMN_KINDS:
+			for (uint32_t i = 0; i < count; i++) {
+				bitWrite(&bits, writer->errors[i], 1);
+			}
+			break;
+		case STORE_COLUMN_HEATERS:
+			for (uint32_t i = 0; i < count; i++) {
+				if (!writer->errors[i]) {
+					bitWrite(&bits, writer->heaters[i], STORE_SENSORS);
+				}
+			}
+			break;
+		case STORE_COLUMN_DICTIONARY:
+			for (uint32_t i = 0; i < writer->dictionaryCount; i++) {
+				size_t length = strlen(writer->dictionary[i]) + 1;
+				memcpy(out + bits.size, writer->dictionary[i], length);
+				bits.size += length;
+			}
+			break;
+		case STORE_COLUMN_CODES:
+			for (uint32_t i = 0; i < count; i++) {
+				bitWrite(&bits, writer->codes[i], codeWidth(writer->dictionaryCount));
+			}
+			break;
+		default:
+			encodeFloats(&bits, writer->temperatures[column - STORE_COLUMN_THERM1], writer->errors, count);
+			break;
+		}
+		header.columnSizes[column] = (uint32_t)bitFinish(&bits);
+		out += header.columnSizes[column];
+	}
+	header.size = (uint32_t)(out - writer->encoded);
+	memcpy(writer->encoded, &header, sizeof(header));
+
+	if (fwrite(writer->encoded, 1, header.size, writer->file) != header.size) {
+		perror("Failed to write telemetry store");
+		return -1;
+	}
+	writer->header.blockCount++;
+	writer->offset += header.size;
+	writer->rowCount = 0;
+	writer->dictionaryCount = 0;
+	return 0;
+}
+
+// Função para procurar (ou acrescentar) um texto no dicionário do bloco
+static int dictionaryCode(TelemetryStoreWriter* writer, const char* text) {
+	char truncated[STORE_MAX_STRING];
+	snprintf(truncated, sizeof(truncated), "%s", text);
+	for (uint32_t i = 0; i < writer->dictionaryCount; i++) {
+		if (strcmp(writer->dictionary[i], truncated) == 0) {
+			return (int)i;
+		}
+	}
+	if (writer->dictionaryCount == STORE_MAX_DICTIONARY) {
+		return -1;
+	}
+	memcpy(writer->dictionary[writer->dictionaryCount], truncated, sizeof(truncated));
+	return (int)writer->dictionaryCount++;
+}
+
+// Função para acrescentar uma linha; o bloco é escrito quando enche (linhas ou dicionário)
+int telemetryStoreAppend(TelemetryStoreWriter* writer, const TelemetryRecord* record) {
+	if (writer->rowCount == STORE_BLOCK_ROWS && flushBlock(writer) != 0) {
+		return -1;
+	}
+	const char* text = record->error ? record->message : record->environment;
+	int code = dictionaryCode(writer, text != NULL ? text : "");
+	if (code < 0) {
+		if (flushBlock(writer) != 0) {
+			return -1;
+		}
+		code = dictionaryCode(writer, text != NULL ? text : "");
+	}
+
+	uint32_t row = writer->rowCount++;
+	writer->timestamps[row] = record->timestamp;
+	writer->errors[row] = record->error;
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		writer->temperatures[s][row] = record->temperatures[s];
+	}
+	writer->heaters[row] = record->heaters;
+	writer->codes[row] = (uint8_t)code;
+
+	if (writer->header.rowCount == 0) {
+		writer->header.firstTimestamp = record->timestamp;
+	}
+	writer->header.lastTimestamp = record->timestamp;
+	writer->header.rowCount++;
+	writer->header.errorCount += record->error;
+	return 0;
+}
+
+// Função para escrever o índice ao lado do ficheiro
+static int writeIndex(TelemetryStoreWriter* writer) {
+	FILE* file = fopen(writer->indexPath, "wb");
+	if (file == NULL) {
+		perror("Failed to create telemetry index");
+		return -1;
+	}
+	int result = 0;
+	if (fwrite(&writer->index, sizeof(writer->index), 1, file) != 1 ||
+		fwrite(writer->entries, sizeof(TelemetryIndexEntry), writer->index.blockCount, file) != writer->index.blockCount) {
+		perror("Failed to write telemetry index");
+		result = -1;
+	}
+	if (fclose(file) != 0) {
+		result = -1;
+	}
+	return result;
+}
+
+// Função para escrever o último bloco, o cabeçalho final e o índice
+int telemetryStoreClose(TelemetryStoreWriter* writer) {
+	int result = flushBlock(writer);
+	if (result == 0 && (fseek(writer->file, 0, SEEK_SET) != 0 ||
+		fwrite(&writer->header, sizeof(writer->header), 1, writer->file) != 1)) {
+		perror("Failed to write telemetry store header");
+		result = -1;
+	}
+	if (fclose(writer->file) != 0) {
+		result = -1;
+	}
+	if (result == 0) {
+		result = writeIndex(writer);
+	}
+	free(writer->encoded);
+	free(writer->entries);
+	free(writer->indexPath);
+	return result;
+}
+
+// Função para mapear um ficheiro e validar o cabeçalho e os tamanhos dos blocos
+int telemetryStoreOpen(TelemetryStoreReader* reader, const char* path) {
+	memset(reader, 0, sizeof(*reader));
+	reader->fd = open(path, O_RDONLY);
+	struct stat info;
+	if (reader->fd < 0 || fstat(reader->fd, &info) != 0) {
+		perror("Failed to open telemetry store");
+		if (reader->fd >= 0) {
+			close(reader->fd);
+		}
+		return -1;
+	}
+	reader->size = (size_t)info.st_size;
+	if (reader->size < sizeof(TelemetryStoreHeader)) {
+		fprintf(stderr, "%s: not a telemetry store\n", path);
+		close(reader->fd);
+		return -1;
+	}
+	void* data = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+	if (data == MAP_FAILED) {
+		perror("Failed to map telemetry store");
+		close(reader->fd);
+		return -1;
+	}
+	reader->data = data;
+	memcpy(&reader->header, reader->data, sizeof(reader->header));
+	if (reader->header.magic != STORE_MAGIC || reader->header.version != STORE_VERSION ||
+		reader->header.sensorCount != STORE_SENSORS) {
+		fprintf(stderr, "%s: not a telemetry store (or unsupported version)\n", path);
+		telemetryStoreCloseReader(reader);
+		return -1;
+	}
+
+	reader->blockOffsets = malloc(((size_t)reader->header.blockCount + 1) * sizeof(size_t));
+	if (reader->blockOffsets == NULL) {
+		perror("Failed to open telemetry store");
+		telemetryStoreCloseReader(reader);
+		return -1;
+	}
+	size_t offset = sizeof(TelemetryStoreHeader);
+	for (uint32_t i = 0; i < reader->header.blockCount; i++) {
+		TelemetryStoreBlockHeader block;
+		uint64_t columns = 0;
+		if (offset + sizeof(block) <= reader->size) {
+			memcpy(&block, reader->data + offset, sizeof(block));
+			for (int c = 0; c < STORE_COLUMN_COUNT; c++) {
+				columns += block.columnSizes[c];
+			}
+		}
+		if (offset + sizeof(block) > reader->size || block.size > reader->size - offset ||
+			columns + sizeof(block) != block.size || block.rowCount == 0 || block.rowCount > STORE_BLOCK_ROWS ||
+			block.dictionaryCount > STORE_MAX_DICTIONARY) {
+			fprintf(stderr, "%s: block %u is truncated or corrupt\n", path, i);
+			telemetryStoreCloseReader(reader);
+			return -1;
+		}
+		reader->blockOffsets[i] = offset;
+		offset += block.size;
+	}
+	return 0;
+}
+
+void telemetryStoreCloseReader(TelemetryStoreReader* reader) {
+	munmap((void*)reader->data, reader->size);
+	close(reader->fd);
+	free(reader->blockOffsets);
+	reader->blockOffsets = NULL;
+}
+
+void telemetryStoreBlockHeader(const TelemetryStoreReader* reader, uint32_t index, TelemetryStoreBlockHeader* header) {
+	memcpy(header, reader->data + reader->blockOffsets[index], sizeof(*header));
+}
+
+// Função para descodificar um bloco; os textos do dicionário apontam para o mapa
+int telemetryStoreReadBlock(const TelemetryStoreReader* reader, uint32_t index, TelemetryBlock* block) {
+	TelemetryStoreBlockHeader header;
+	telemetryStoreBlockHeader(reader, index, &header);
+	const uint8_t* columns[STORE_COLUMN_COUNT];
+	const uint8_t* cursor = reader->data + reader->blockOffsets[index] + sizeof(header);
+	for (int c = 0; c < STORE_COLUMN_COUNT; c++) {
+		columns[c] = cursor;
+		cursor += header.columnSizes[c];
+	}
+
+	uint32_t count = header.rowCount;
+	block->rowCount = count;
+	block->timestamps[0] = header.firstTimestamp;
+	BitReader timestamps = { columns[STORE_COLUMN_TIMESTAMPS], header.columnSizes[STORE_COLUMN_TIMESTAMPS], 0, 0, 0 };
+	decodeTimestamps(&timestamps, block->timestamps, count);
+
+	BitReader kinds = { columns[STORE_COLUMN_KINDS], header.columnSizes[STORE_COLUMN_KINDS], 0, 0, 0 };
+	for (uint32_t i = 0; i < count; i++) {
+		block->errors[i] = (uint8_t)bitRead(&kinds, 1);
+	}
+
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		BitReader values = { columns[STORE_COLUMN_THERM1 + s], header.columnSizes[STORE_COLUMN_THERM1 + s], 0, 0, 0 };
+		decodeFloats(&values, block->temperatures[s], block->errors, count);
+	}
+
+	BitReader heaters = { columns[STORE_COLUMN_HEATERS], header.columnSizes[STORE_COLUMN_HEATERS], 0, 0, 0 };
+	for (uint32_t i = 0; i < count; i++) {
+		block->heaters[i] = block->errors[i] ? 0 : (uint8_t)bitRead(&heaters, STORE_SENSORS);
+	}
+
+	// Dicionário: header.dictionaryCount textos terminados em '\0'
+	const char* text = (const char*)columns[STORE_COLUMN_DICTIONARY];
+	const char* textEnd = text + header.columnSizes[STORE_COLUMN_DICTIONARY];
+	block->dictionaryCount = 0;
+	while (text < textEnd && block->dictionaryCount < header.dictionaryCount) {
+		const char* terminator = memchr(text, '\0', (size_t)(textEnd - text));
+		if (terminator == NULL) {
+			break;
+		}
+		block->dictionary[block->dictionaryCount++] = text;
+		text = terminator + 1;
+	}
+	if (block->dictionaryCount != header.dictionaryCount) {
+		fprintf(stderr, "Telemetry store block %u: corrupt dictionary\n", index);
+		return -1;
+	}
+
+	BitReader codes = { columns[STORE_COLUMN_CODES], header.columnSizes[STORE_COLUMN_CODES], 0, 0, 0 };
+	int width = codeWidth(header.dictionaryCount);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t code = bitRead(&codes, width);
+		if (code >= header.dictionaryCount) {
+			fprintf(stderr, "Telemetry store block %u: invalid dictionary code\n", index);
+			return -1;
+		}
+		block->codes[i] = (uint8_t)code;
+	}
+	return 0;
+}
+
+// Função para separar o próximo campo de uma linha do data.csv (campos separados por ", ")
+static void nextField(const char** cursor, const char* end, const char** field, size_t* length) {
+	const char* start = *cursor;
+	while (start < end && *start == ' ') {
+		start++;
+	}
+	const char* comma = memchr(start, ',', (size_t)(end - start));
+	const char* stop = comma != NULL ? comma : end;
+	*field = start;
+	*length = (size_t)(stop - start);
+	*cursor = comma != NULL ? comma + 1 : end;
+}
+
+static bool fieldEquals(const char* field, size_t length, const char* text) {
+	return length == strlen(text) && memcmp(field, text, length) == 0;
+}
+
+static void copyField(char* out, const char* field, size_t length) {
+	if (length >= STORE_MAX_STRING) {
+		length = STORE_MAX_STRING - 1;
+	}
+	memcpy(out, field, length);
+	out[length] = '\0';
+}
+
+// Função para ler uma linha do data.csv (writeToCSVCorrect ou writeToCSVError do TSL)
+bool telemetryStoreParseCsvLine(const char* line, const char* end, TelemetryRecord* record, char* text) {
+	const char* cursor = line;
+	const char* field;
+	size_t length;
+
+	nextField(&cursor, end, &field, &length);
+	record->error = fieldEquals(field, length, "null");
+	record->heaters = 0;
+	if (record->error) {
+		// "null" nas oito primeiras colunas, timestamp, "null" e a mensagem (que pode ter vírgulas)
+		for (int i = 1; i < 2 * STORE_SENSORS; i++) {
+			nextField(&cursor, end, &field, &length);
+			if (!fieldEquals(field, length, "null")) {
+				return false;
+			}
+		}
+		nextField(&cursor, end, &field, &length);
+		if (!telemetryStoreParseTimestamp(field, length, &record->timestamp)) {
+			return false;
+		}
+		nextField(&cursor, end, &field, &length);
+		while (cursor < end && *cursor == ' ') {
+			cursor++;
+		}
+		copyField(text, cursor, (size_t)(end - cursor));
+		for (int s = 0; s < STORE_SENSORS; s++) {
+			record->temperatures[s] = NAN;
+		}
+		record->environment = NULL;
+		record->message = text;
+		return fieldEquals(field, length, "null");
+	}
+
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		if (s > 0) {
+			nextField(&cursor, end, &field, &length);
+		}
+		const char* number = field;
+		if (!telemetryParseFloat(&number, field + length, &record->temperatures[s]) || number != field + length) {
+			return false;
+		}
+	}
+	for (int h = 0; h < STORE_SENSORS; h++) {
+		nextField(&cursor, end, &field, &length);
+		if (fieldEquals(field, length, "On")) {
+			record->heaters |= (uint8_t)(1u << h);
+		}
+		else if (!fieldEquals(field, length, "Off")) {
+			return false;
+		}
+	}
+	nextField(&cursor, end, &field, &length);
+	if (!telemetryStoreParseTimestamp(field, length, &record->timestamp)) {
+		return false;
+	}
+	nextField(&cursor, end, &field, &length);
+	copyField(text, field, length);
+	record->environment = text;
+	record->message = NULL;
+	nextField(&cursor, end, &field, &length);
+	return fieldEquals(field, length, "null") && cursor == end;
+}
+
+// Função para mapear um data.csv em memória (NULL em caso de erro)
+static const char* mapCsv(const char* csvPath, int* fd, size_t* size) {
+	*fd = open(csvPath, O_RDONLY);
+	struct stat info;
+	if (*fd < 0 || fstat(*fd, &info) != 0) {
+		perror(csvPath);
+		if (*fd >= 0) {
+			close(*fd);
+		}
+		return NULL;
+	}
+	*size = (size_t)info.st_size;
+	const char* data = *size > 0 ? mmap(NULL, *size, PROT_READ, MAP_PRIVATE, *fd, 0) : "";
+	if (data == MAP_FAILED) {
+		perror("Failed to map CSV");
+		close(*fd);
+		return NULL;
+	}
+	return data;
+}
+
+static void unmapCsv(const char* data, int fd, size_t size) {
+	if (size > 0) {
+		munmap((void*)data, size);
+	}
+	close(fd);
+}
+
+// Função para obter a próxima linha com dados (sem '\r', linhas vazias nem o cabeçalho)
+static bool nextCsvLine(const char** cursor, const char* end, const char** line, const char** lineEnd,
+	unsigned long* lineNumber) {
+	while (*cursor < end) {
+		const char* newline = memchr(*cursor, '\n', (size_t)(end - *cursor));
+		*line = *cursor;
+		*lineEnd = newline != NULL ? newline : end;
+		*cursor = newline != NULL ? newline + 1 : end;
+		(*lineNumber)++;
+		if (*lineEnd > *line && (*lineEnd)[-1] == '\r') {
+			(*lineEnd)--;
+		}
+		if (*lineEnd != *line && !(*lineNumber == 1 && strncmp(*line, "THERM-01", 8) == 0)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Função para percorrer as linhas válidas do CSV que começam entre os bytes from e to; visit recebe o byte
+// onde cada linha começa e pára a leitura ao devolver um valor diferente de 0
+int telemetryStoreScanCsv(const char* csvPath, uint64_t from, uint64_t to, TelemetryCsvVisitor visit, void* context) {
+	int fd;
+	size_t size;
+	const char* data = mapCsv(csvPath, &fd, &size);
+	if (data == NULL) {
+		return -1;
+	}
+	int result = 0;
+	unsigned long lineNumber = 0;
+	const char* cursor = data + (from < size ? from : size);
+	const char* end = data + (to < size ? to : size);
+	const char* line;
+	const char* lineEnd;
+	while (result == 0 && cursor < end && nextCsvLine(&cursor, data + size, &line, &lineEnd, &lineNumber)) {
+		TelemetryRecord record;
+		char text[STORE_MAX_STRING];
+		if (line < end && telemetryStoreParseCsvLine(line, lineEnd, &record, text)) {
+			result = visit(&record, (uint64_t)(line - data), context);
+		}
+	}
+	unmapCsv(data, fd, size);
+	return result;
+}
+
+// Função para converter um data.csv do TSL para o formato colunar
+int telemetryStoreImportCsv(const char* csvPath, const char* storePath) {
+	int fd;
+	size_t size;
+	const char* data = mapCsv(csvPath, &fd, &size);
+	if (data == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	TelemetryStoreWriter* writer = malloc(sizeof(*writer));
+	if (writer == NULL || telemetryStoreCreate(writer, storePath) != 0) {
+		free(writer);
+		unmapCsv(data, fd, size);
+		return EXIT_FAILURE;
+	}
+
+	// A pirâmide de resumos é atualizada linha a linha, junto com o ficheiro
+	DecimationPyramid pyramid;
+	decimationInit(&pyramid);
+	bool failed = false;
+	uint64_t rows = 0;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	unsigned long lineNumber = 0, rejected = 0, firstRejected = 0;
+	const char* cursor = data;
+	const char* line;
+	const char* lineEnd;
+	while (nextCsvLine(&cursor, data + size, &line, &lineEnd, &lineNumber)) {
+		TelemetryRecord record;
+		char text[STORE_MAX_STRING];
+		if (!telemetryStoreParseCsvLine(line, lineEnd, &record, text)) {
+			if (rejected++ == 0) {
+				firstRejected = lineNumber;
+			}
+			continue;
+		}
+		if (telemetryStoreAppend(writer, &record) != 0 || decimationAdd(&pyramid, &record, rows++) != 0) {
+			failed = true;
+			break;
+		}
+	}
+
+	TelemetryStoreHeader header = writer->header;
+	int result = telemetryStoreClose(writer);
+	struct stat stored;
+	if (result == 0 && !failed && (stat(storePath, &stored) != 0 ||
+		decimationSave(&pyramid, storePath, (uint64_t)stored.st_size) != 0)) {
+		result = -1;
+	}
+	double milliseconds = elapsedMs(&start);
+	free(writer);
+	unmapCsv(data, fd, size);
+	size_t pointCounts[DECIMATION_LEVELS];
+	memcpy(pointCounts, pyramid.pointCount, sizeof(pointCounts));
+	decimationFree(&pyramid);
+	if (result != 0 || failed) {
+		return EXIT_FAILURE;
+	}
+
+	printf("Imported %llu rows (%u error rows) from %s in %.1f ms\n", (unsigned long long)header.rowCount,
+		header.errorCount, csvPath, milliseconds);
+	if (rejected > 0) {
+		printf("Rejected %lu malformed lines (first at line %lu)\n", rejected, firstRejected);
+	}
+	printf("CSV: %zu bytes, store: %lld bytes (%.1fx smaller, %.2f bytes per row)\n", size,
+		(long long)stored.st_size, stored.st_size > 0 ? (double)size / (double)stored.st_size : 0.0,
+		header.rowCount > 0 ? (double)stored.st_size / (double)header.rowCount : 0.0);
+	printf("Decimation levels (complete points):");
+	for (int l = 0; l < DECIMATION_LEVELS; l++) {
+		printf(" %ux: %zu points%s", decimationLevelFactor(l), pointCounts[l], l + 1 < DECIMATION_LEVELS ? "," : "\n");
+	}
+	return EXIT_SUCCESS;
+}
+
+// Função para reconstruir o data.csv (mesmo formato de linhas do TSL)
+int telemetryStoreExportCsv(const char* storePath, const char* csvPath) {
+	TelemetryStoreReader reader;
+	if (telemetryStoreOpen(&reader, storePath) != 0) {
+		return EXIT_FAILURE;
+	}
+	FILE* out = fopen(csvPath, "w");
+	TelemetryBlock* block = malloc(sizeof(*block));
+	if (out == NULL || block == NULL) {
+		perror(csvPath);
+		if (out != NULL) {
+			fclose(out);
+		}
+		free(block);
+		telemetryStoreCloseReader(&reader);
+		return EXIT_FAILURE;
+	}
+	setvbuf(out, NULL, _IOFBF, 1 << 20);
+
+	int result = EXIT_SUCCESS;
+	fprintf(out, "%s\n", STORE_CSV_HEADER);
+	for (uint32_t b = 0; b < reader.header.blockCount && result == EXIT_SUCCESS; b++) {
+		if (telemetryStoreReadBlock(&reader, b, block) != 0) {
+			result = EXIT_FAILURE;
+			break;
+		}
+		for (uint32_t i = 0; i < block->rowCount; i++) {
+			char timestamp[STORE_TIMESTAMP_LENGTH + 1];
+			telemetryStoreFormatTimestamp(timestamp, block->timestamps[i]);
+			if (block->errors[i]) {
+				fprintf(out, "null, null, null, null, null, null, null, null, %s, null, %s\n", timestamp,
+					block->dictionary[block->codes[i]]);
+				continue;
+			}
+			fprintf(out, "%f, %f, %f, %f, %s, %s, %s, %s, %s, %s, null\n", block->temperatures[0][i],
+				block->temperatures[1][i], block->temperatures[2][i], block->temperatures[3][i],
+				block->heaters[i] & 1 ? "On" : "Off", block->heaters[i] & 2 ? "On" : "Off",
+				block->heaters[i] & 4 ? "On" : "Off", block->heaters[i] & 8 ? "On" : "Off", timestamp,
+				block->dictionary[block->codes[i]]);
+		}
+	}
+	if (fclose(out) != 0) {
+		perror(csvPath);
+		result = EXIT_FAILURE;
+	}
+	if (result == EXIT_SUCCESS) {
+		printf("Exported %llu rows to %s\n", (unsigned long long)reader.header.rowCount, csvPath);
+	}
+	free(block);
+	telemetryStoreCloseReader(&reader);
+	return result;
+}
+
+// Função para comparar uma linha do CSV com a mesma linha descodificada do ficheiro
+static bool sameRecord(const TelemetryRecord* record, const TelemetryBlock* block, uint32_t row) {
+	if (record->timestamp != block->timestamps[row] || record->error != (block->errors[row] != 0)) {
+		return false;
+	}
+	if (record->error) {
+		return strcmp(record->message, block->dictionary[block->codes[row]]) == 0;
+	}
+	for (int s = 0; s < STORE_SENSORS; s++) {
+		// Os floats têm de voltar bit a bit iguais (o XOR não perde precisão)
+		if (memcmp(&record->temperatures[s], &block->temperatures[s][row], sizeof(float)) != 0) {
+			return false;
+		}
+	}
+	return record->heaters == block->heaters[row] && strcmp(record->environment, block->dictionary[block->codes[row]]) == 0;
+}
+
+// Função para importar um data.csv e verificar que cada linha volta igual do ficheiro (--store-verify)
+// Verifica os codecs delta-de-delta e XOR sem depender da formatação dos números no CSV
+int telemetryStoreVerify(const char* csvPath, const char* storePath) {
+	if (telemetryStoreImportCsv(csvPath, storePath) != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+	int fd;
+	size_t size;
+	const char* data = mapCsv(csvPath, &fd, &size);
+	if (data == NULL) {
+		return EXIT_FAILURE;
+	}
+	TelemetryStoreReader reader;
+	TelemetryBlock* block = malloc(sizeof(*block));
+	if (block == NULL || telemetryStoreOpen(&reader, storePath) != 0) {
+		free(block);
+		unmapCsv(data, fd, size);
+		return EXIT_FAILURE;
+	}
+
+	int result = EXIT_SUCCESS;
+	uint64_t rows = 0;
+	uint32_t blockIndex = 0, row = 0;
+	block->rowCount = 0;
+	unsigned long lineNumber = 0;
+	const char* cursor = data;
+	const char* line;
+	const char* lineEnd;
+	while (result == EXIT_SUCCESS && nextCsvLine(&cursor, data + size, &line, &lineEnd, &lineNumber)) {
+		TelemetryRecord record;
+		char text[STORE_MAX_STRING];
+		if (!telemetryStoreParseCsvLine(line, lineEnd, &record, text)) {
+			continue; // Linhas rejeitadas também não foram importadas
+		}
+		if (row == block->rowCount) {
+			if (blockIndex == reader.header.blockCount || telemetryStoreReadBlock(&reader, blockIndex++, block) != 0) {
+				fprintf(stderr, "%s: store ends before line %lu\n", storePath, lineNumber);
+				result = EXIT_FAILURE;
+				break;
+			}
+			row = 0;
+		}
+		if (!sameRecord(&record, block, row)) {
+			fprintf(stderr, "%s: line %lu does not match row %llu of %s\n", csvPath, lineNumber,
+				(unsigned long long)rows, storePath);
+			result = EXIT_FAILURE;
+		}
+		row++;
+		rows++;
+	}
+	if (result == EXIT_SUCCESS && rows != reader.header.rowCount) {
+		fprintf(stderr, "%s: %llu rows stored, %llu read back\n", storePath,
+			(unsigned long long)reader.header.rowCount, (unsigned long long)rows);
+		result = EXIT_FAILURE;
+	}
+	if (result == EXIT_SUCCESS) {
+		printf("Verified %llu rows: timestamps, temperatures, heaters and texts round-trip exactly\n",
+			(unsigned long long)rows);
+	}
+	free(block);
+	telemetryStoreCloseReader(&reader);
+	unmapCsv(data, fd, size);
+	return result;
+}
+
+// Função para mostrar o conteúdo de um ficheiro e o tempo de descodificação de todos os blocos
+int runTelemetryStoreInfo(const char* path) {
+	TelemetryStoreReader reader;
+	if (telemetryStoreOpen(&reader, path) != 0) {
+		return EXIT_FAILURE;
+	}
+	TelemetryStoreHeader* header = &reader.header;
+	char first[STORE_TIMESTAMP_LENGTH + 1], last[STORE_TIMESTAMP_LENGTH + 1];
+	telemetryStoreFormatTimestamp(first, header->firstTimestamp);
+	telemetryStoreFormatTimestamp(last, header->lastTimestamp);
+	printf("%s: %llu rows (%u error rows) in %u blocks, %zu bytes (%.2f bytes per row)\n", path,
+		(unsigned long long)header->rowCount, header->errorCount, header->blockCount, reader.size,
+		header->rowCount > 0 ? (double)reader.size / (double)header->rowCount : 0.0);
+	printf("Time range: %s to %s\n", first, last);
+
+	uint64_t columnBytes[STORE_COLUMN_COUNT] = { 0 };
+	for (uint32_t b = 0; b < header->blockCount; b++) {
+		TelemetryStoreBlockHeader block;
+		telemetryStoreBlockHeader(&reader, b, &block);
+		for (int c = 0; c < STORE_COLUMN_COUNT; c++) {
+			columnBytes[c] += block.columnSizes[c];
+		}
+	}
+	for (int c = 0; c < STORE_COLUMN_COUNT; c++) {
+		printf("  %-12s %10llu bytes (%.2f bits per row)\n", storeColumnName((StoreColumn)c),
+			(unsigned long long)columnBytes[c],
+			header->rowCount > 0 ? 8.0 * (double)columnBytes[c] / (double)header->rowCount : 0.0);
+	}
+
+	TelemetryBlock* block = malloc(sizeof(*block));
+	if (block == NULL) {
+		telemetryStoreCloseReader(&reader);
+		return EXIT_FAILURE;
+	}
+	int result = EXIT_SUCCESS;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t b = 0; b < header->blockCount; b++) {
+		if (telemetryStoreReadBlock(&reader, b, block) != 0) {
+			result = EXIT_FAILURE;
+			break;
+		}
+	}
+	double milliseconds = elapsedMs(&start);
+	if (result == EXIT_SUCCESS) {
+		printf("Decoded all blocks in %.1f ms (%.1f M rows/s)\n", milliseconds,
+			milliseconds > 0.0 ? (double)header->rowCount / milliseconds / 1e3 : 0.0);
+	}
+	free(block);
+	telemetryStoreCloseReader(&reader);
+	return result;
+}
@@ -0,0 +1,176 @@
+﻿// TelemetryStore.h : Formato binário colunar e comprimido para a telemetria do data.csv do TSL.
+//
+// O ficheiro começa com um TelemetryStoreHeader, seguido de blocos de até STORE_BLOCK_ROWS linhas.
+// Cada bloco tem um TelemetryStoreBlockHeader e as colunas pela ordem de StoreColumn:
+//   timestamps    delta-de-delta em ms com códigos de tamanho variável (Gorilla); o primeiro vai no cabeçalho
+//   kinds         1 bit por linha (1 = linha de erro)
+//   THERM-01..04  XOR com o valor anterior da mesma coluna (Gorilla), só nas linhas sem erro
+//   heaters       4 bits por linha sem erro
+//   dictionary    textos do bloco terminados em '\0' (ambientes e mensagens de erro)
+//   codes         índice no dicionário, com os bits necessários: ambiente ou mensagem de erro
+// Os cabeçalhos ficam na ordem de bytes do anfitrião; um ficheiro de outra ordem falha no magic.
+//
+// Ao lado do ficheiro fica o índice (<ficheiro>.idx): um TelemetryIndexHeader com os nomes dos ambientes
+// e um TelemetryIndexEntry por bloco, com os limites de tempo e de cada sensor e o mapa dos ambientes.
+
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+
+#define STORE_MAGIC 0x54435453u     // "STCT" em little-endian
+#define STORE_VERSION 1
+#define STORE_SENSORS 4             // THERM-01..04 e HTR-1..4
+#define STORE_BLOCK_ROWS 4096
+#define STORE_MAX_DICTIONARY 255    // Textos diferentes por bloco
+#define STORE_MAX_STRING 128        // Textos mais longos são truncados
+#define STORE_NO_CODE 0xFF
+#define STORE_TIMESTAMP_LENGTH 23   // "AAAA-MM-DDTHH:MM:SS.mmm"
+#define STORE_CSV_HEADER "THERM-01, THERM-02, THERM-03, THERM-04, HTR-1, HTR-2, HTR-3, HTR-4, TIMESTAMP, ENVIRONMENT, ERROR"
+#define STORE_INDEX_MAGIC 0x49435453u   // "STCI"
+#define STORE_INDEX_SUFFIX ".idx"
+#define STORE_INDEX_MAX_ENVIRONMENTS 32 // O último bit junta os ambientes que já não cabem
+
+// Colunas de um bloco
+typedef enum {
+	STORE_COLUMN_TIMESTAMPS,
+	STORE_COLUMN_KINDS,
+	STORE_COLUMN_THERM1,
+	STORE_COLUMN_THERM2,
+	STORE_COLUMN_THERM3,
+	STORE_COLUMN_THERM4,
+	STORE_COLUMN_HEATERS,
+	STORE_COLUMN_DICTIONARY,
+	STORE_COLUMN_CODES,
+	STORE_COLUMN_COUNT
+} StoreColumn;
+
+// Estrutura TelemetryStoreHeader: início do ficheiro (reescrito ao fechar)
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t sensorCount;
+	uint32_t blockCount;
+	uint32_t errorCount;
+	uint64_t rowCount;
+	int64_t firstTimestamp;     // ms desde 1970 da hora escrita no CSV (sem fuso)
+	int64_t lastTimestamp;
+} TelemetryStoreHeader;
+
+// Estrutura TelemetryStoreBlockHeader: início de cada bloco
+typedef struct {
+	uint32_t size;              // Bytes do bloco, com este cabeçalho
+	uint32_t rowCount;
+	uint32_t dictionaryCount;
+	uint32_t columnSizes[STORE_COLUMN_COUNT];
+	int64_t firstTimestamp;
+	int64_t lastTimestamp;
+} TelemetryStoreBlockHeader;
+
+// Estrutura TelemetryIndexHeader: início do índice
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t environmentCount;
+	uint32_t blockCount;
+	uint32_t reserved;
+	uint64_t rowCount;
+	char environments[STORE_INDEX_MAX_ENVIRONMENTS][STORE_MAX_STRING];
+} TelemetryIndexHeader;
+
+// Estrutura TelemetryIndexEntry: resumo de um bloco
+typedef struct {
+	uint64_t offset;            // Início do bloco no ficheiro
+	uint32_t rowCount;
+	uint32_t sampleCount;       // Linhas sem erro
+	uint32_t environmentMask;   // Bit i = ambiente i do índice presente no bloco
+	uint32_t reserved;
+	int64_t minTimestamp;
+	int64_t maxTimestamp;
+	float minimum[STORE_SENSORS];   // NAN se o bloco só tiver linhas de erro
+	float maximum[STORE_SENSORS];
+	double sum[STORE_SENSORS];
+} TelemetryIndexEntry;
+
+// Estrutura TelemetryRecord: uma linha do data.csv
+typedef struct {
+	int64_t timestamp;
+	bool error;                 // Linha de erro: só timestamp e mensagem
+	float temperatures[STORE_SENSORS];
+	uint8_t heaters;            // Bit i = HTR-(i+1) ligado
+	const char* environment;
+	const char* message;
+} TelemetryRecord;
+
+// Estrutura TelemetryBlock: um bloco descodificado, coluna a coluna
+typedef struct {
+	uint32_t rowCount;
+	int64_t timestamps[STORE_BLOCK_ROWS];
+	uint8_t errors[STORE_BLOCK_ROWS];
+	float temperatures[STORE_SENSORS][STORE_BLOCK_ROWS];   // NAN nas linhas de erro
+	uint8_t heaters[STORE_BLOCK_ROWS];
+	uint8_t codes[STORE_BLOCK_ROWS];                       // Ambiente, ou mensagem nas linhas de erro
+	uint32_t dictionaryCount;
+	const char* dictionary[STORE_MAX_DICTIONARY];          // Aponta para o ficheiro mapeado
+} TelemetryBlock;
+
+// Estrutura TelemetryStoreWriter: linhas do bloco em construção
+typedef struct {
+	FILE* file;
+	TelemetryStoreHeader header;
+	uint32_t rowCount;
+	int64_t timestamps[STORE_BLOCK_ROWS];
+	uint8_t errors[STORE_BLOCK_ROWS];
+	float temperatures[STORE_SENSORS][STORE_BLOCK_ROWS];
+	uint8_t heaters[STORE_BLOCK_ROWS];
+	uint8_t codes[STORE_BLOCK_ROWS];
+	uint32_t dictionaryCount;
+	char dictionary[STORE_MAX_DICTIONARY][STORE_MAX_STRING];
+	uint8_t* encoded;           // Colunas codificadas do bloco
+	uint64_t offset;            // Bytes já escritos
+	char* indexPath;
+	TelemetryIndexHeader index;
+	TelemetryIndexEntry* entries;
+	size_t entryCapacity;
+} TelemetryStoreWriter;
+
+// Estrutura TelemetryStoreReader: ficheiro mapeado em memória
+typedef struct {
+	int fd;
+	const uint8_t* data;
+	size_t size;
+	TelemetryStoreHeader header;
+	size_t* blockOffsets;
+} TelemetryStoreReader;
+
+// Funções de escrita
+int telemetryStoreCreate(TelemetryStoreWriter* writer, const char* path);
+int telemetryStoreAppend(TelemetryStoreWriter* writer, const TelemetryRecord* record);
+int telemetryStoreClose(TelemetryStoreWriter* writer);
+
+// Funções de leitura
+int telemetryStoreOpen(TelemetryStoreReader* reader, const char* path);
+void telemetryStoreCloseReader(TelemetryStoreReader* reader);
+int telemetryStoreReadBlock(const TelemetryStoreReader* reader, uint32_t index, TelemetryBlock* block);
+void telemetryStoreBlockHeader(const TelemetryStoreReader* reader, uint32_t index, TelemetryStoreBlockHeader* header);
+
+// Funções do índice e dos timestamps do TSL
+void telemetryIndexBlock(TelemetryIndexHeader* index, TelemetryIndexEntry* entry, uint32_t count,
+	const int64_t* timestamps, const uint8_t* errors, const float (*temperatures)[STORE_BLOCK_ROWS],
+	const uint8_t* codes, const char* const* dictionary);
+uint32_t telemetryIndexEnvironmentMask(const TelemetryIndexHeader* index, const char* name);
+bool telemetryEnvironmentMatches(const char* stored, const char* name);
+bool telemetryStoreParseTimestamp(const char* text, size_t length, int64_t* timestamp);
+void telemetryStoreFormatTimestamp(char* out, int64_t timestamp);
+
+// Conversão de e para o data.csv; text recebe o ambiente ou a mensagem (STORE_MAX_STRING bytes)
+bool telemetryStoreParseCsvLine(const char* line, const char* end, TelemetryRecord* record, char* text);
+typedef int (*TelemetryCsvVisitor)(const TelemetryRecord* record, uint64_t offset, void* context);
+int telemetryStoreScanCsv(const char* csvPath, uint64_t from, uint64_t to, TelemetryCsvVisitor visit, void* context);
+int telemetryStoreImportCsv(const char* csvPath, const char* storePath);
+int telemetryStoreExportCsv(const char* storePath, const char* csvPath);
+int telemetryStoreVerify(const char* csvPath, const char* storePath);
+int runTelemetryStoreInfo(const char* path);
+
+#endif // TELEMETRY_STORE_H
@@ -1,6 +1,31 @@
 ﻿// ThermalControlApp.c : Defines the entry point for the application.
 
 #include "ThermalControlApp.h"
+#include "ZoneEngine.h"
+#include "PIDBatch.h"
+#include "SimClock.h"
+#include "MonteCarlo.h"
+#include "ThermalNetwork.h"
+#include "OrbitEnvironment.h"
+#include "FixedPointPID.h"
+#include "EventLoop.h"
+#include "WireProtocol.h"
+#include "ShmRing.h"
+#include "FrameStream.h"
+#include "TelemetryParser.h"
+#include "TelemetryServer.h"
+#include "IoBackend.h"
+#include "TelemetryLogger.h"
+#include "TelemetryStore.h"
+#include "TelemetryQuery.h"
+#include "Replay.h"
+#include "Decimation.h"
+#include "SeqLock.h"
+#include "ControlConfig.h"
+#include "RealTime.h"
+#include "LoopLatency.h"
+#include "ConsoleQueue.h"
+#include "project_config.h"
 
 int infoPipe[2];
 int responsePipe[2];
@@ -11,17 +36,100 @@ float setpointTemperature = 20.0f;
 PIDController pidController = { 1.0f, 0.1f, 0.01f, 0.0f, 0.0f }; // Exemplo de PID
 pthread_t simulationThread;
 pthread_t menuThread;
+SimClock simulationClock; // Relógio da simulação interativa
+
+// As variáveis acima só são alteradas pelo ciclo de simulação; o menu publica configurações novas
+SeqLock controllerState;      // ControllerSnapshot publicado no fim de cada passo
+ConfigDomain controlConfig;   // ControlConfig em vigor, trocada por read-copy-update
+ControlConfig menuConfig;     // Cópia do menu (único escritor de controlConfig)
+_Atomic uint64_t temperatureOverride = 0; // Temperatura da opção 5: versão << 32 | bits do float
+uint32_t menuTemperatureVersion = 0;
+uint32_t appliedConfigVersion = 0;
+uint32_t appliedGainsVersion = 0;
+uint32_t appliedTemperatureVersion = 0;
+
+#define CONFIG_READER_SIMULATION 0 // O ciclo de simulação é o único leitor de controlConfig
 
 #define MAX_BUFFER_SIZE 256  // Tamanho máximo do buffer para mensagens
+#define MAX_CATCH_UP_TICKS 16 // Ciclos atrasados recuperados de uma vez pelo temporizador
+#define INFO_RING_SLOTS 256   // Tramas no anel partilhado da infoPipe
 
-#define MIN_TEMPERATURE -25.0f
-#define MAX_TEMPERATURE 25.0f
+// Estado do menu orientado a linhas
+MenuState menuState = MENU_CHOOSE_OPTION;
+int firstOption = -1;  // Armazena a primeira escolha
+int secondOption = -1; // Armazena a segunda escolha
+float pendingKp;       // Valores já introduzidos durante a opção 3
+float pendingKi;
+unsigned long missedTicks = 0;         // Ciclos descartados por atraso do temporizador
 
-#define MIN_INTEGRAL_VALUE -10.0f   // Valor mínimo para a integral
-#define MAX_INTEGRAL_VALUE 10.0f     // Valor máximo para a integral
+// Tramas da infoPipe
+uint32_t infoSequence = 0;           // Número de sequência da próxima trama enviada
+WireFrame lastTemperatureFrame;      // Últimas tramas recebidas de cada tipo
+WireFrame lastCommandFrame;
+unsigned long framesReceived = 0;
+unsigned long frameErrors = 0;
+unsigned long framesDropped = 0;     // Tramas descartadas com o anel cheio
+InfoTransport infoTransport = TRANSPORT_PIPE;
+FrameWriter infoWriter;              // Fila de tramas por escrever em cada pipe
+FrameWriter responseWriter;
+FrameWriter exportWriter;            // Cópia das tramas para o FIFO TEMP_INFO_PIPE (--fifo)
+bool exportToFifo = false;
+OverflowPolicy overflowPolicy = OVERFLOW_DROP_OLDEST;
+IoBackend ioBackend;                 // Submissão das escritas e leituras de cada ciclo
+IoBackendKind ioBackendKind = IO_BACKEND_SYNC;
+bool readInfoOnFlush = false;        // A leitura da infoPipe vai no mesmo lote que as escritas (ciclo de eventos)
+FrameReader infoReader;              // Bytes lidos de cada pipe ainda por separar em tramas
+FrameReader responseReader;
+TelemetryLogger telemetryLogger;     // Registo CSV assíncrono (--log FICHEIRO)
+const char* logPath = NULL;
+RealTimeConfig realTime = { false, 0, REALTIME_DEFAULT_PRIORITY }; // Modo de tempo real (--rt CPU[:PRIORIDADE])
+RealTimeReport realTimeReport;       // Passos do modo de tempo real que ficaram em vigor
+LoopLatency loopLatency;             // Histogramas das fases do ciclo e do atraso do despertar
+StepReport stepReport;               // Mensagens do passo em curso, escritas depois das fases medidas
+ConsoleQueue consoleQueue;           // Relatórios dos passos para a thread da consola (--rt no Linux)
+bool consoleThreadActive = false;    // Menu e consola fora do ciclo de tempo real
 
-#define MAX_OUTPUT 100.0f // Define o limite máximo da saída do PID
-#define MIN_OUTPUT -100.0f // Define o limite mínimo da saída do PID
+// Estrutura MonitorSnapshot: estado do ciclo mostrado pela opção 6
+typedef struct {
+	unsigned long framesReceived;
+	float temperature;
+	bool heaterOn;
+	uint32_t temperatureSequence;
+	bool hasCommand;
+	float controlOutput;
+	uint32_t commandSequence;
+	unsigned long frameErrors;
+	unsigned long skippedBytes;
+	unsigned long framesDropped;
+	unsigned long reads;
+	unsigned long framesRead;
+	ChannelStats info;
+	ChannelStats fifo;
+	long steps;
+	unsigned long missedTicks;
+	unsigned long submits;
+	unsigned long operations;
+	size_t subscriberCount;
+	unsigned long disconnected;
+	unsigned long rejected;
+	unsigned subscriberIds[TELEMETRY_MAX_SUBSCRIBERS];
+	OverflowPolicy subscriberPolicies[TELEMETRY_MAX_SUBSCRIBERS];
+	ChannelStats subscribers[TELEMETRY_MAX_SUBSCRIBERS];
+} MonitorSnapshot;
+
+// Com a consola noutra thread o ciclo copia o estado para aqui; com o lock ocupado salta a cópia desse passo
+MonitorSnapshot monitorState;
+pthread_mutex_t monitorLock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef __linux__
+EventLoop mainLoop;                     // Ciclo de eventos da aplicação interativa
+int simulationTimer = -1;               // timerfd que marca o ritmo da simulação
+char stdinLine[MAX_BUFFER_SIZE];        // Linha do terminal ainda incompleta
+size_t stdinLength = 0;
+ShmRing infoRing;                       // Anel da infoPipe com --transport shm
+TelemetryServer telemetryServer;        // Subscritores das tramas no socket TELEMETRY_SOCKET (--serve)
+bool serveTelemetry = false;
+#endif
 
 // Função para criar pipes
 void createPipes() {
@@ -33,6 +141,15 @@ void createPipes() {
 		perror("Failed to create responsePipe");
 		exit(EXIT_FAILURE);
 	}
+
+	// O produtor nunca espera pelo leitor: com o pipe cheio as tramas ficam na fila do FrameWriter
+	fcntl(infoPipe[1], F_SETFL, fcntl(infoPipe[1], F_GETFL) | O_NONBLOCK);
+	fcntl(responsePipe[1], F_SETFL, fcntl(responsePipe[1], F_GETFL) | O_NONBLOCK);
+
+	frameWriterInit(&infoWriter, infoPipe[1], overflowPolicy);
+	frameReaderInit(&infoReader, infoPipe[0]);
+	frameWriterInit(&responseWriter, responsePipe[1], overflowPolicy);
+	frameReaderInit(&responseReader, responsePipe[0]);
 }
 
 // Função para limpar o terminal
@@ -50,16 +167,16 @@ void adjustTemperature(float adjustment) {
 		// Aumenta a temperatura com base no ajuste
 		currentTemperature += adjustment;
 
-		// Exibir temperatura atual independentemente dos limites
-		printf("Current Temperature: %.2f\n", currentTemperature);
+		// Guardar a temperatura atual independentemente dos limites (mostrada no fim do passo)
+		stepReport.reachedTemperature = currentTemperature;
 
 		// Limitar a temperatura dentro dos limites
 		if (currentTemperature > MAX_TEMPERATURE) {
-			printf("Maximum Temperature Reached: %.2f. Decreasing temperature...\n", currentTemperature);
+			stepReport.limit = 1;
 			currentTemperature -= 0.5f; // Diminuir um pouco a temperatura
 		}
 		else if (currentTemperature < MIN_TEMPERATURE) {
-			printf("Minimum Temperature Reached: %.2f. Increasing temperature...\n", currentTemperature);
+			stepReport.limit = -1;
 			currentTemperature += 0.5f; // Aumentar um pouco a temperatura
 		}
 	}
@@ -73,111 +190,450 @@ void adjustTemperature(float adjustment) {
 		}
 	}
 
-	// Formata a mensagem para o pipe
-	char message[MAX_BUFFER_SIZE];
-	snprintf(message, sizeof(message), "THERM-01_TEMP-%.2f;", currentTemperature);
-	writeToInfoPipe(message);
+	// Envia o comando do aquecedor (saída de controlo) para o pipe
+	sendInfoFrame(WIRE_HEATER_COMMAND, adjustment, adjustment > 0.0f);
+}
+
+// Função para mostrar no terminal o que um passo fez (fora das fases medidas do ciclo)
+static void printStepReport(const StepReport* report) {
+	if (report->controlled) {
+		printf("Error: %.2f, Control Output Before Limits: %.2f\n", report->error, report->controlOutput);
+		printf("Control Output After Limits: %.2f\n", report->controlOutput);
+		printf("Current Temperature: %.2f\n", report->reachedTemperature);
+		if (report->limit > 0) {
+			printf("Maximum Temperature Reached: %.2f. Decreasing temperature...\n", report->reachedTemperature);
+		}
+		else if (report->limit < 0) {
+			printf("Minimum Temperature Reached: %.2f. Increasing temperature...\n", report->reachedTemperature);
+		}
+		printf("Adjusted Temperature: %.2f (Adjustment: %.2f)\n", report->temperature, report->controlOutput);
+	}
+	else if (report->limit < 0) {
+		printf("Minimum Temperature Reached: %.2f\n", report->temperature);
+	}
+	else {
+		printf("Thermal Control Disabled. Decreasing Temperature: %.2f\n", report->temperature);
+	}
+}
+
+// Função para ajustar o ritmo do ciclo ao fator de aceleração da configuração
+static void applyLoopRate(const ControlConfig* config) {
+	if (config->timeWarp != simulationClock.timeWarp) {
+		simClockSetTimeWarp(&simulationClock, config->timeWarp);
+#ifdef __linux__
+		armSimulationTimer();
+#endif
+	}
+}
+
+// Função para aplicar a configuração em vigor (chamada pelo ciclo de simulação, sem locks nem esperas)
+static void applyControlConfig() {
+	const ControlConfig* config = configRead(&controlConfig);
+	if (config->version != appliedConfigVersion) {
+		setpointTemperature = config->setpoint;
+		thermalControlEnabled = config->thermalControlEnabled;
+		if (config->gainsVersion != appliedGainsVersion) {
+			pidController.Kp = config->Kp;
+			pidController.Ki = config->Ki;
+			pidController.Kd = config->Kd;
+			pidController.previousError = 0.0f;
+			pidController.integral = 0.0f;
+			appliedGainsVersion = config->gainsVersion;
+		}
+		applyLoopRate(config);
+		appliedConfigVersion = config->version;
+	}
+
+	uint64_t override = atomic_load_explicit(&temperatureOverride, memory_order_acquire);
+	if ((uint32_t)(override >> 32) != appliedTemperatureVersion) {
+		uint32_t bits = (uint32_t)override;
+		memcpy(&currentTemperature, &bits, sizeof(bits));
+		appliedTemperatureVersion = (uint32_t)(override >> 32);
+	}
+}
+
+// Função para publicar a cópia do menu como nova configuração
+static void publishMenuConfig() {
+	if (configPublish(&controlConfig, &menuConfig) != 0) {
+		printf("Configuration not changed.\n");
+	}
+}
+
+// Função para publicar o estado do controlador para o menu e para os leitores
+static void publishControllerState(float controlOutput) {
+	ControllerSnapshot snapshot = { currentTemperature, setpointTemperature, controlOutput, pidController,
+		simulationClock.simulatedTime, simulationClock.steps, thermalControlEnabled };
+	seqLockWrite(&controllerState, &snapshot);
+}
+
+// Função para inicializar os seqlocks a partir das variáveis globais (antes de arrancar a simulação)
+static int initControllerState() {
+	menuConfig = (ControlConfig){ setpointTemperature, pidController.Kp, pidController.Ki, pidController.Kd,
+		simulationClock.timeWarp, thermalControlEnabled, 1, 0 };
+	if (configDomainInit(&controlConfig, &menuConfig, 1) != 0) {
+		perror("Failed to create control configuration");
+		return -1;
+	}
+	appliedConfigVersion = 1;
+	ControllerSnapshot snapshot = { currentTemperature, setpointTemperature, 0.0f, pidController,
+		simulationClock.simulatedTime, simulationClock.steps, thermalControlEnabled };
+	_Static_assert(sizeof(ControllerSnapshot) <= SEQLOCK_MAX_SIZE, "ControllerSnapshot does not fit in the seqlock");
+	return seqLockInit(&controllerState, &snapshot, sizeof(snapshot));
+}
+
+// Função do passo PID do ciclo de simulação, partilhada com --replay
+float controlStep(PIDController* pid, float error) {
+	// Cálculo do controle PID
+	float controlOutput = pid->Kp * error +
+		pid->Ki * (pid->integral) + // Integral
+		pid->Kd * (error - pid->previousError); // Derivativo
+
+	// Atualiza o estado anterior do erro e a integral
+	pid->previousError = error;
+	pid->integral += error;
+
+	// Limitar a integral para evitar windup
+	if (pid->integral > MAX_INTEGRAL_VALUE) {
+		pid->integral = MAX_INTEGRAL_VALUE; // Um valor máximo
+	}
+	else if (pid->integral < MIN_INTEGRAL_VALUE) {
+		pid->integral = MIN_INTEGRAL_VALUE; // Um valor mínimo
+	}
+
+	// Limitar a saída do controle
+	if (controlOutput > MAX_OUTPUT) {
+		controlOutput = MAX_OUTPUT;
+	}
+	else if (controlOutput < MIN_OUTPUT) {
+		controlOutput = MIN_OUTPUT;
+	}
+	return controlOutput;
+}
+
+// Função para executar um ciclo da simulação (chamada pelo temporizador ou pela thread de simulação)
+void simulationStep() {
+	loopLatencyMark(&loopLatency, LOOP_PHASE_WAKE);
+	applyControlConfig();
+	loopLatencyMark(&loopLatency, LOOP_PHASE_READ_INPUT);
+	float controlOutput = 0.0f;
+	float error = setpointTemperature - currentTemperature;
+
+	// Armazenar a temperatura atual antes de qualquer ajuste
+	float previousTemperature = currentTemperature;
+
+	stepReport = (StepReport){ thermalControlEnabled, error, 0.0f, currentTemperature, 0, currentTemperature };
+
+	if (thermalControlEnabled) {
+		controlOutput = controlStep(&pidController, error);
+		loopLatencyMark(&loopLatency, LOOP_PHASE_COMPUTE);
+		stepReport.controlOutput = controlOutput;
+
+		// Ajusta a temperatura baseado na saída de controle
+		adjustTemperature(controlOutput);
+	}
+	else {
+		loopLatencyMark(&loopLatency, LOOP_PHASE_COMPUTE);
+		// Se o controlo térmico não estiver ativado, diminuir constantemente a temperatura
+		if (currentTemperature > MIN_TEMPERATURE) {
+			currentTemperature -= 0.5f; // Ajusta para diminuir a temperatura
+		}
+		else {
+			stepReport.limit = -1;
+		}
+	}
+	stepReport.temperature = currentTemperature;
+
+	// Envia a temperatura e o estado do aquecedor para o pipe
+	sendInfoFrame(WIRE_TEMPERATURES, currentTemperature, thermalControlEnabled && controlOutput > 0.0f);
+	loopLatencyMark(&loopLatency, LOOP_PHASE_WRITE_OUTPUT);
+
+	// Com a consola noutra thread o passo só deixa o relatório na fila dela
+	if (consoleThreadActive) {
+		consoleQueuePush(&consoleQueue, &stepReport);
+	}
+
+	// O ciclo só copia os valores para a fila; a formatação e a escrita são da thread do registo
+	if (logPath != NULL) {
+		struct timespec now;
+		clock_gettime(CLOCK_REALTIME, &now);
+		LogRecord record = {
+			(uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec, currentTemperature,
+			thermalControlEnabled && controlOutput > 0.0f,
+			currentTemperature <= MIN_TEMPERATURE || currentTemperature >= MAX_TEMPERATURE ? LOG_ROW_ERROR : LOG_ROW_OK
+		};
+		telemetryLoggerLog(&telemetryLogger, &record);
+	}
+	publishControllerState(controlOutput);
+	configQuiescent(&controlConfig, CONFIG_READER_SIMULATION); // Já não usa a configuração deste passo
+	loopLatencyMark(&loopLatency, LOOP_PHASE_LOG);
+
+	// Sem thread da consola, a escrita no terminal e o seu fflush ficam fora das fases
+	if (!consoleThreadActive) {
+		printStepReport(&stepReport);
+		fflush(stdout);
+		loopLatencyResume(&loopLatency);
+	}
+}
 
-	// Mostre a temperatura no terminal
-	printf("Adjusted Temperature: %.2f (Adjustment: %.2f)\n", currentTemperature, adjustment);
+// Função para colocar a thread do ciclo de controlo em tempo real (--rt)
+// O registo corre na sua própria thread e é afastado do núcleo reservado (a consola é afastada ao ser criada)
+static void enterRealTimeMode() {
+	realTimeEnter(&realTime, &realTimeReport);
+	if (logPath != NULL) {
+		realTimeMoveOffCore(&realTime, telemetryLogger.thread, &realTimeReport);
+	}
+	realTimePrintReport(&realTime, &realTimeReport);
 }
 
+// Função da thread de simulação (usada quando não há ciclo de eventos)
 void* simulateTemperature(void* arg) {
-	float dt = 1.0f; // Intervalo de tempo (em segundos) para simulação
 	simulateTemperatureActive = true;
 	clearTerminal();
+	if (realTime.enabled) {
+		enterRealTimeMode();
+	}
 
+	loopLatencyWake(&loopLatency);
 	while (simulateTemperatureActive) {
-		float controlOutput = 0.0f;
-		float error = setpointTemperature - currentTemperature;
+		simulationStep();
+		flushInfoPipe();
+		loopLatencyMark(&loopLatency, LOOP_PHASE_WRITE_OUTPUT);
+		loopLatencyCommit(&loopLatency);
 
-		// Armazenar a temperatura atual antes de qualquer ajuste
-		float previousTemperature = currentTemperature;
+		// Avança o tempo simulado (dt) e espera de acordo com o fator de aceleração
+		simClockTick(&simulationClock);
+		loopLatencyWake(&loopLatency);
+		loopLatencyLateness(&loopLatency, simulationClock.lateness);
+	}
 
+	configReaderOffline(&controlConfig, CONFIG_READER_SIMULATION);
+	return NULL;
+}
 
-		char buffer[MAX_BUFFER_SIZE]; // Buffer para armazenar a mensagem do pipe
+// Função para escrever uma trama na infoPipe
+// No pipe a trama fica no lote até flushInfoPipe, que o escreve com um único writev
+void writeToInfoPipe(const WireFrame* frame) {
+	if (exportToFifo) {
+		frameWriterAppend(&exportWriter, frame);
+	}
+#ifdef __linux__
+	if (serveTelemetry) {
+		telemetryServerPublish(&telemetryServer, frame);
+	}
+#endif
 
-		if (thermalControlEnabled) {
-			// Cálculo do controle PID
-			controlOutput = pidController.Kp * error +
-				pidController.Ki * (pidController.integral) + // Integral
-				pidController.Kd * (error - pidController.previousError); // Derivativo
+#ifdef __linux__
+	if (infoTransport == TRANSPORT_SHM) {
+		// Codifica diretamente na posição do anel, sem chamadas ao sistema
+		// O anel pertence ao consumidor do lado de tail, por isso com o anel cheio perde-se a trama nova
+		uint8_t* slot = shmRingBeginWrite(&infoRing);
+		if (slot == NULL) {
+			framesDropped++;
+			return;
+		}
+		shmRingCommitWrite(&infoRing, (uint32_t)wireEncodeFrame(frame, slot, WIRE_MAX_FRAME_SIZE));
+		return;
+	}
+#endif
 
-			// Atualiza o estado anterior do erro e a integral
-			pidController.previousError = error;
-			pidController.integral += error;
+	frameWriterAppend(&infoWriter, frame);
+}
 
-			// Limitar a integral para evitar windup
-			if (pidController.integral > MAX_INTEGRAL_VALUE) {
-				pidController.integral = MAX_INTEGRAL_VALUE; // Um valor máximo
-			}
-			else if (pidController.integral < MIN_INTEGRAL_VALUE) {
-				pidController.integral = MIN_INTEGRAL_VALUE; // Um valor mínimo
-			}
+#define IO_READ_INFO_PIPE UINT64_MAX // userData da leitura da infoPipe no lote de I/O
 
-			// Limitar a saída do controle
-			if (controlOutput > MAX_OUTPUT) {
-				controlOutput = MAX_OUTPUT;
-			}
-			else if (controlOutput < MIN_OUTPUT) {
-				controlOutput = MIN_OUTPUT;
-			}
+// Função para escrever as tramas acumuladas em todos os canais (uma vez por ciclo)
+// Um lote por canal e, no ciclo de eventos, a leitura da infoPipe vão numa só submissão ao backend
+void flushInfoPipe() {
+	FrameWriter* writers[2 + TELEMETRY_MAX_SUBSCRIBERS];
+	struct iovec iov[2 + TELEMETRY_MAX_SUBSCRIBERS][FRAME_BATCH_MAX];
+	int batches[2 + TELEMETRY_MAX_SUBSCRIBERS];
+	size_t writerCount = 0;
 
-			printf("Error: %.2f, Control Output Before Limits: %.2f\n", error, controlOutput);
-			printf("Control Output After Limits: %.2f\n", controlOutput);
+	if (infoTransport == TRANSPORT_PIPE) {
+		writers[writerCount++] = &infoWriter;
+	}
+	if (exportToFifo) {
+		frameWriterReconnect(&exportWriter);
+		writers[writerCount++] = &exportWriter;
+	}
+#ifdef __linux__
+	if (serveTelemetry) {
+		for (size_t i = 0; i < telemetryServer.subscriberCount; i++) {
+			writers[writerCount++] = &telemetryServer.subscribers[i]->writer;
+		}
+	}
+#endif
 
-			// Ajusta a temperatura baseado na saída de controle
-			adjustTemperature(controlOutput);
+	for (size_t i = 0; i < writerCount; i++) {
+		batches[i] = frameWriterPrepare(writers[i], iov[i]);
+		if (batches[i] > 0) {
+			// A leitura da infoPipe só corre depois da escrita do lote da infoPipe
+			bool linkRead = writers[i] == &infoWriter && readInfoOnFlush;
+			ioQueueWritev(&ioBackend, writers[i]->fd, iov[i], batches[i], i, linkRead);
 		}
-		else {
-			// Se o controlo térmico não estiver ativado, diminuir constantemente a temperatura
-			if (currentTemperature > MIN_TEMPERATURE) {
-				currentTemperature -= 0.5f; // Ajusta para diminuir a temperatura
-				printf("Thermal Control Disabled. Decreasing Temperature: %.2f\n", currentTemperature);
-			}
-			else {
-				printf("Minimum Temperature Reached: %.2f\n", currentTemperature);
+	}
+	if (readInfoOnFlush && infoTransport == TRANSPORT_PIPE) {
+		size_t space;
+		uint8_t* destination = frameReaderPrepareRead(&infoReader, &space);
+		ioQueueRead(&ioBackend, infoPipe[0], destination, space, IO_READ_INFO_PIPE);
+	}
+
+	IoCompletion completions[IO_BACKEND_MAX_OPERATIONS];
+	int completed = ioBackendSubmit(&ioBackend, completions, IO_BACKEND_MAX_OPERATIONS);
+	for (int c = 0; c < completed; c++) {
+		if (completions[c].userData == IO_READ_INFO_PIPE) {
+			if (completions[c].result > 0) {
+				frameReaderCommitRead(&infoReader, (size_t)completions[c].result);
 			}
+			continue;
 		}
+		size_t i = (size_t)completions[c].userData;
+		frameWriterComplete(writers[i], batches[i], completions[c].result);
+	}
 
-		// Prepara a mensagem para o pipe
-		snprintf(buffer, sizeof(buffer), "Current Temperature: %.2f, Control Output: %.2f", currentTemperature, controlOutput);
-		writeToInfoPipe(buffer); // Escreve no pipe
+	// Mais tramas do que cabem num lote: o resto segue com escritas diretas
+	for (size_t i = 0; i < writerCount; i++) {
+		if (writers[i]->count > 0 && !writers[i]->congested) {
+			frameWriterFlush(writers[i]);
+		}
+	}
 
-		// Ajusta o intervalo da simulação
-		usleep(500000);  // Simulação a cada 0.5 segundos
+	WireFrame frame;
+	while (readInfoOnFlush && frameReaderNext(&infoReader, &frame)) {
+		storeInfoFrame(&frame);
+	}
+#ifdef __linux__
+	if (serveTelemetry) {
+		telemetryServerPrune(&telemetryServer);
 	}
+#endif
+}
 
-	return NULL;
+// Função para mostrar os contadores de um canal de saída
+static void printChannel(const char* name, const ChannelStats* stats) {
+	printf("Channel %s: %s, written %lu in %lu writes, queued %zu (high water %zu), dropped %lu, coalesced %lu, would block %lu\n",
+		name, stats->connected ? "connected" : "waiting for reader", stats->frames, stats->batches, stats->queued,
+		stats->highWater, stats->droppedFrames, stats->coalescedFrames, stats->wouldBlock);
 }
 
-// Função para escrever na infoPipe
-void writeToInfoPipe(const char* message) {
-	if (write(infoPipe[1], message, strlen(message) + 1) == -1) {
-		perror("Failed to write to infoPipe");
+// Função para copiar o estado do ciclo mostrado pela opção 6 (chamada pela thread que o altera)
+static void captureMonitorState(MonitorSnapshot* monitor) {
+	memset(monitor, 0, sizeof(*monitor));
+	monitor->framesReceived = framesReceived;
+	monitor->temperature = lastTemperatureFrame.values[0];
+	monitor->heaterOn = wireHeaterOn(&lastTemperatureFrame, 0);
+	monitor->temperatureSequence = lastTemperatureFrame.sequence;
+	monitor->hasCommand = lastCommandFrame.sensorCount > 0;
+	monitor->controlOutput = lastCommandFrame.values[0];
+	monitor->commandSequence = lastCommandFrame.sequence;
+	monitor->frameErrors = frameErrors;
+	monitor->skippedBytes = infoReader.skippedBytes;
+	monitor->framesDropped = framesDropped;
+	monitor->reads = infoReader.reads;
+	monitor->framesRead = infoReader.frames;
+	frameWriterStats(&infoWriter, &monitor->info);
+	frameWriterStats(&exportWriter, &monitor->fifo);
+	monitor->steps = simulationClock.steps;
+	monitor->missedTicks = missedTicks;
+	monitor->submits = ioBackend.submits;
+	monitor->operations = ioBackend.operations;
+#ifdef __linux__
+	if (serveTelemetry) {
+		monitor->subscriberCount = telemetryServer.subscriberCount;
+		monitor->disconnected = telemetryServer.disconnected;
+		monitor->rejected = telemetryServer.rejected;
+		for (size_t i = 0; i < telemetryServer.subscriberCount; i++) {
+			monitor->subscriberIds[i] = telemetryServer.subscribers[i]->id;
+			monitor->subscriberPolicies[i] = telemetryServer.subscribers[i]->writer.policy;
+			frameWriterStats(&telemetryServer.subscribers[i]->writer, &monitor->subscribers[i]);
+		}
 	}
+#endif
 }
 
-// Função para ler da infoPipe
-void readFromInfoPipe(char* buffer, size_t bufferSize) {
-	if (read(infoPipe[0], buffer, bufferSize) == -1) {
-		perror("Failed to read from infoPipe");
+// Função para enviar uma trama de um sensor/aquecedor com a próxima sequência
+void sendInfoFrame(WireMessageType type, float value, bool heaterOn) {
+	WireFrame frame;
+	frame.type = (uint8_t)type;
+	frame.sensorCount = 1;
+	frame.heaterCount = 1;
+	frame.sequence = infoSequence++;
+	frame.timestamp = wireTimestampNow();
+	frame.heaters = 0;
+	frame.values[0] = value;
+	wireSetHeater(&frame, 0, heaterOn);
+	writeToInfoPipe(&frame);
+}
+
+// Função para ler uma trama da infoPipe
+// Cada read traz todas as tramas disponíveis; as seguintes são servidas do buffer do leitor
+bool readFromInfoPipe(WireFrame* frame) {
+#ifdef __linux__
+	if (infoTransport == TRANSPORT_SHM) {
+		// Descodifica diretamente da posição do anel; falso quando não há tramas
+		size_t frameSize;
+		uint32_t size;
+		const uint8_t* slot = shmRingBeginRead(&infoRing, &size);
+		if (slot == NULL) {
+			return false;
+		}
+		WireStatus status = wireDecodeFrame(slot, size, frame, &frameSize);
+		shmRingEndRead(&infoRing);
+		if (status != WIRE_OK) {
+			frameErrors++;
+			return false;
+		}
+		return true;
 	}
-	snprintf(buffer, bufferSize, "Simulated data from pipe");
+#endif
+
+	while (!frameReaderNext(&infoReader, frame)) {
+		ssize_t count = frameReaderFill(&infoReader);
+		if (count <= 0) {
+			if (count == -1 && errno != EAGAIN) {
+				perror("Failed to read from infoPipe");
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+// Função para guardar a última trama recebida de cada tipo
+void storeInfoFrame(const WireFrame* frame) {
+	framesReceived++;
+	if (frame->type == WIRE_TEMPERATURES) {
+		lastTemperatureFrame = *frame;
+	}
+	else if (frame->type == WIRE_HEATER_COMMAND) {
+		lastCommandFrame = *frame;
+	}
+}
+
+// Função para obter a última trama de temperaturas guardada por storeInfoFrame
+const WireFrame* lastInfoTemperatures() {
+	return &lastTemperatureFrame;
 }
 
 // Função para escrever na responsePipe
-void writeToResponsePipe(const char* message) {
-	if (write(responsePipe[1], message, strlen(message) + 1) == -1) {
-		perror("Failed to write to responsePipe");
+void writeToResponsePipe(const WireFrame* frame) {
+	if (frameWriterAppend(&responseWriter, frame)) {
+		frameWriterFlush(&responseWriter);
 	}
 }
 
 // Função para ler da responsePipe
-void readFromResponsePipe(char* buffer, size_t bufferSize) {
-	if (read(responsePipe[0], buffer, bufferSize) == -1) {
-		perror("Failed to read from responsePipe");
+bool readFromResponsePipe(WireFrame* frame) {
+	while (!frameReaderNext(&responseReader, frame)) {
+		ssize_t count = frameReaderFill(&responseReader);
+		if (count <= 0) {
+			if (count == -1 && errno != EAGAIN) {
+				perror("Failed to read from responsePipe");
+			}
+			return false;
+		}
 	}
+	return true;
 }
 
 // Função para configurar os parâmetros PID
@@ -187,254 +643,1055 @@ void setPIDParameters(float kp, float ki, float kd) {
 		return;
 	}
 
-	pidController.Kp = kp;
-	pidController.Ki = ki;
-	pidController.Kd = kd;
-	pidController.previousError = 0.0;
-	pidController.integral = 0.0;
+	// O ciclo de simulação aplica os ganhos (e repõe o estado do PID) no passo seguinte
+	menuConfig.Kp = kp;
+	menuConfig.Ki = ki;
+	menuConfig.Kd = kd;
+	menuConfig.gainsVersion++;
+	publishMenuConfig();
 	printf("PID parameters set: Kp=%.2f, Ki=%.2f, Kd=%.2f\n", kp, ki, kd);
 }
 
 float calculatePIDControl(float error) {
-	// Calcular a derivada
-	float derivative = error - pidController.previousError;
+	// O passo de referência é o mesmo usado pelo kernel em lote (PIDBatch.h)
+	return pidControlStep(error, currentTemperature, pidController.Kp, pidController.Ki, pidController.Kd,
+		&pidController.previousError, &pidController.integral);
+}
 
-	// Atualizar o erro anterior
-	pidController.previousError = error;
+// Função para definir o setpoint de temperatura
+void setSetpoint(float value) {
+	if (value >= MIN_TEMPERATURE && value <= MAX_TEMPERATURE) {
+		menuConfig.setpoint = value;
+		publishMenuConfig();
+		printf("Setpoint temperature set to: %.2f\n", value);
+	}
+	else {
+		printf("Setpoint value must be between %.2f and %.2f.\n", MIN_TEMPERATURE, MAX_TEMPERATURE);
+	}
+}
 
-	// Acumular a integral do erro
-	// Limitar a integral para evitar windup
-	if (currentTemperature >= MAX_TEMPERATURE && error > 0) {
-		// Prevenir acumulação da integral se a temperatura atual estiver saturada
-		pidController.integral = fmaxf(0.0f, pidController.integral);
+// Função para definir a temperatura atual
+void setCurrentTemperature(float value) {
+	if (value >= MIN_TEMPERATURE && value <= MAX_TEMPERATURE) {
+		// Um valor isolado não precisa de cópia: versão e temperatura vão na mesma palavra atómica
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		menuTemperatureVersion++;
+		atomic_store_explicit(&temperatureOverride, (uint64_t)menuTemperatureVersion << 32 | bits,
+			memory_order_release);
+		printf("Current temperature set to: %.2f\n", value);
 	}
-	else if (currentTemperature <= MIN_TEMPERATURE && error < 0) {
-		// Prevenir acumulação da integral se a temperatura atual estiver saturada
-		pidController.integral = fminf(0.0f, pidController.integral);
+	else {
+		printf("Error: Current temperature must be between %.2f and %.2f\n", MIN_TEMPERATURE, MAX_TEMPERATURE);
+	}
+}
+
+// Função para alterar o fator de aceleração da simulação (0 = sem limite)
+void setTimeWarp(float warp) {
+	if (warp < 0.0f) {
+		printf("Time warp must be a non-negative number.\n");
+		return;
+	}
+
+	// O ciclo passa a usar o novo ritmo no passo seguinte
+	menuConfig.timeWarp = warp;
+	publishMenuConfig();
+#ifdef __linux__
+	if (!consoleThreadActive) {
+		applyLoopRate(&menuConfig); // O menu corre no mesmo ciclo: o temporizador é rearmado já
+	}
+#endif
+	if (warp > 0.0f) {
+		printf("Time warp set to: %.1fx\n", warp);
 	}
 	else {
-		// Se a temperatura não estiver saturada, permita a acumulação
-		pidController.integral += error; // Acumula o erro
+		printf("Time warp set to: unbounded\n");
 	}
+}
 
-	// Calcular a saída do PID
-	float output = pidController.Kp * error +
-		pidController.Ki * pidController.integral +
-		pidController.Kd * derivative;
+// Função para mostrar a última mensagem da infoPipe e o estado do controlador
+void reads()
+{
+	MonitorSnapshot monitor;
+	if (consoleThreadActive) {
+		pthread_mutex_lock(&monitorLock);
+		monitor = monitorState;
+		pthread_mutex_unlock(&monitorLock);
+	}
+	else {
+		captureMonitorState(&monitor);
+	}
 
-	// Limitar a saída a uma faixa específica
-	if (output > MAX_OUTPUT) {
-		output = MAX_OUTPUT; // Limitar a saída ao máximo permitido
+	printf("Reading temperature from infoPipe...\n");
+	if (monitor.framesReceived > 0) {
+		// Exibe as últimas tramas recebidas
+		printf("Received: Temperature %.2f, Heater %s (frame %u)",
+			monitor.temperature, monitor.heaterOn ? "ON" : "OFF", monitor.temperatureSequence);
+		if (monitor.hasCommand) {
+			printf(", Control Output %.2f (frame %u)", monitor.controlOutput, monitor.commandSequence);
+		}
+		printf("\n");
+		if (monitor.frameErrors > 0 || monitor.skippedBytes > 0 || monitor.framesDropped > 0) {
+			printf("Invalid frames: %lu, skipped bytes: %lu, dropped frames: %lu\n", monitor.frameErrors,
+				monitor.skippedBytes, monitor.framesDropped);
+		}
+		if (infoTransport == TRANSPORT_PIPE && monitor.reads > 0) {
+			printf("Frames per read: %.2f\n", (double)monitor.framesRead / (double)monitor.reads);
+			printChannel("info", &monitor.info);
+		}
+	}
+	else {
+		printf("No data received from pipe.\n");
 	}
-	else if (output < MIN_OUTPUT) {
-		output = MIN_OUTPUT; // Limitar a saída ao mínimo permitido
+	if (exportToFifo) {
+		printChannel(TEMP_INFO_PIPE, &monitor.fifo);
 	}
+	if (logPath != NULL) {
+		printf("Log %s: %lu rows in %lu writes (%s), %lu dropped\n", logPath, atomic_load(&telemetryLogger.rows),
+			atomic_load(&telemetryLogger.writes), ioBackendName(telemetryLogger.io.kind), atomic_load(&telemetryLogger.dropped));
+	}
+	if (consoleThreadActive && atomic_load(&consoleQueue.dropped) > 0) {
+		printf("Console step reports dropped: %lu\n", atomic_load(&consoleQueue.dropped));
+	}
+	if (monitor.steps > 0) {
+		printf("I/O backend: %s, %.2f submissions per tick (%lu operations in %lu submissions)\n",
+			ioBackendName(ioBackend.kind), (double)monitor.submits / (double)monitor.steps,
+			monitor.operations, monitor.submits);
+	}
+#ifdef __linux__
+	if (serveTelemetry) {
+		printf("Subscribers on %s: %zu (%lu disconnected, %lu rejected)\n", TELEMETRY_SOCKET,
+			monitor.subscriberCount, monitor.disconnected, monitor.rejected);
+		for (size_t i = 0; i < monitor.subscriberCount; i++) {
+			char name[32];
+			snprintf(name, sizeof(name), "subscriber %u (%s)", monitor.subscriberIds[i],
+				overflowPolicyName(monitor.subscriberPolicies[i]));
+			printChannel(name, &monitor.subscribers[i]);
+		}
+	}
+#endif
 
-	return output; // Retornar a saída calculada
+	// Exibir temperatura atual e parâmetros do PID, todos do mesmo passo da simulação
+	ControllerSnapshot snapshot;
+	seqLockRead(&controllerState, &snapshot);
+	printf("Current Temperature: %.2f, Setpoint: %.2f, Control Output: %.2f\n", snapshot.currentTemperature,
+		snapshot.setpoint, snapshot.controlOutput);
+	printf("PID Controller Values:\n");
+	printf(" Kp: %.2f, Ki: %.2f, Kd: %.2f\n", snapshot.pid.Kp, snapshot.pid.Ki, snapshot.pid.Kd);
+	printf(" Previous Error: %.2f, Integral: %.2f\n", snapshot.pid.previousError, snapshot.pid.integral);
+	printf("Simulated Time: %.1f s (%ld steps, %lu missed)\n", snapshot.simulatedTime, snapshot.steps, monitor.missedTicks);
+	printf("State snapshot retries: %lu\n", atomic_load(&controllerState.retries));
+	if (realTime.enabled) {
+		realTimePrintReport(&realTime, &realTimeReport); // O menu limpa o terminal depois do arranque
+	}
+	configReclaim(&controlConfig); // reads() corre no contexto do menu, o escritor de controlConfig
+	printf("Configuration version %u (%lu published, %lu reclaimed, %zu awaiting grace period)\n",
+		configRead(&controlConfig)->version, controlConfig.published, controlConfig.reclaimed,
+		controlConfig.retiredCount);
+	printf("Press ESC and Enter to return to the menu.\n");
 }
 
-// Função para definir o setpoint de temperatura
-void setSetpoint(float value) {
-	float newSetpoint;
-	while (1) {
-		printf("Enter new setpoint temperature (%.2f to %.2f): ", MIN_TEMPERATURE, MAX_TEMPERATURE);
+// Função para converter uma linha num valor numérico
+static bool parseFloat(const char* line, float* value) {
+	char* end;
+	*value = strtof(line, &end);
+	if (end == line) {
+		return false;
+	}
+	while (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n') {
+		end++;
+	}
+	return *end == '\0';
+}
 
-		if (scanf("%f", &newSetpoint) == 1) {
-			if (newSetpoint >= MIN_TEMPERATURE && newSetpoint <= MAX_TEMPERATURE) {
-				setpointTemperature = newSetpoint;
-				printf("Setpoint temperature set to: %.2f\n", setpointTemperature);
-				break; // Sai do loop quando a entrada é válida
-			}
-			else {
-				printf("Setpoint value must be between %.2f and %.2f.\n", MIN_TEMPERATURE, MAX_TEMPERATURE);
-			}
+// Função para mostrar o menu principal
+void showMenu() {
+	clearTerminal(); // Limpa o terminal a cada iteração
+	printf("Thermal Control Application\n");
+
+	if (firstOption == -1) {
+		// Se nenhuma opção foi escolhida ainda
+		printf("1. Enable Thermal Control\n");
+		printf("2. Disable Thermal Control\n");
+	}
+	else if (secondOption == -1) {
+		// Se uma opção já foi escolhida, remove a possibilidade de repetição
+		if (firstOption == 1) {
+			printf("2. Disable Thermal Control\n");
 		}
 		else {
-			printf("Invalid input. Please enter a numeric value.\n");
-			while (getchar() != '\n'); // Limpa o buffer de entrada
+			printf("1. Enable Thermal Control\n");
 		}
 	}
+
+	// Exibe as outras opções
+	printf("3. Set PID Parameters\n");
+	printf("4. Set Setpoint Temperature\n");
+	printf("5. Set Current Temperature\n");
+	printf("6. Read from Pipe\n");
+	printf("7. Exit\n");
+	printf("8. Set Time Warp\n");
+	printf("9. Show Loop Latency\n");
+
+	printf("Choose an option: ");
+	fflush(stdout);
 }
 
-// Função para definir a temperatura atual
-void setCurrentTemperature(float value) {
-	if (value >= MIN_TEMPERATURE && value <= MAX_TEMPERATURE) {
-		currentTemperature = value;
-		printf("Current temperature set to: %.2f\n", currentTemperature);
-	}
-	else {
-		printf("Error: Current temperature must be between %.2f and %.2f\n", MIN_TEMPERATURE, MAX_TEMPERATURE);
+// Função para terminar a aplicação
+void exitProgram() {
+	menuConfig.thermalControlEnabled = false;
+	publishMenuConfig();
+	simulateTemperatureActive = false;
+	printf("Exiting program...\n");
+#ifdef __linux__
+	eventLoopStop(&mainLoop);
+#else
+	pthread_join(simulationThread, NULL); // Aguardar a conclusão da simulação;
+	configDomainDestroy(&controlConfig);
+	loopLatencyPrint(&loopLatency);
+	if (logPath != NULL) {
+		telemetryLoggerStop(&telemetryLogger); // Escreve as linhas em falta
 	}
+	exit(0);
+#endif
 }
 
-void reads()
-{
-	while (true)
-	{
-		printf("Reading temperature from infoPipe...\n");
-		char buffer[MAX_BUFFER_SIZE];
-		memset(buffer, 0, sizeof(buffer));  // Limpar o buffer
-		readFromInfoPipe(buffer, sizeof(buffer));  // Lê a mensagem do pipe
+// Função para ativar ou desativar o controlo térmico (opções 1 e 2)
+static void applyThermalControlOption(int option) {
+	menuConfig.thermalControlEnabled = option == 1;
+	publishMenuConfig();
+	printf(option == 1 ? "Thermal Control Enabled\n" : "Thermal Control Disabled\n");
+}
+
+// Função para tratar uma opção do menu principal
+// Devolve falso quando a opção espera por mais entrada (o menu não deve ser redesenhado)
+static bool handleMenuOption(int option) {
+	if (option == 7) {
+		exitProgram();
+		return false;
+	}
+
+	if (firstOption == -1) {
+		// Primeira escolha: ou ativa ou desativa o controlo térmico
+		if (option == 1 || option == 2) {
+			firstOption = option;
+			applyThermalControlOption(option);
+		}
+		else {
+			printf("Invalid option. Please choose 1 or 2.\n");
+		}
+		return true;
+	}
 
-		if (strlen(buffer) > 0) {
-			printf("Received: %s\n", buffer);  // Exibe a mensagem recebida
+	if (secondOption == -1) {
+		// Segunda escolha: a outra opção deve ser selecionada
+		if ((firstOption == 1 && option == 2) || (firstOption == 2 && option == 1)) {
+			secondOption = option;
+			applyThermalControlOption(option);
+		}
+		else {
+			printf("Invalid option. Please choose the remaining option (1 or 2).\n");
+		}
+		return true;
+	}
+
+	// Permitir apenas ajustes normais após as duas escolhas
+	switch (option) {
+	case 3:
+		menuState = MENU_ENTER_KP;
+		printf("Enter Kp: ");
+		return false;
+	case 4:
+		menuState = MENU_ENTER_SETPOINT;
+		printf("Enter new setpoint temperature (%.2f to %.2f): ", MIN_TEMPERATURE, MAX_TEMPERATURE);
+		return false;
+	case 5:
+		menuState = MENU_ENTER_CURRENT_TEMPERATURE;
+		printf("Enter Current Temperature %.2f and %.2f:\n", MIN_TEMPERATURE, MAX_TEMPERATURE);
+		return false;
+	case 6:
+		menuState = MENU_MONITOR;
+		reads();
+		return false;
+	case 8:
+		menuState = MENU_ENTER_TIME_WARP;
+		if (menuConfig.timeWarp > 0.0) {
+			printf("Current time warp: %.1fx\n", menuConfig.timeWarp);
 		}
 		else {
-			printf("No data received from pipe.\n");
+			printf("Current time warp: unbounded\n");
 		}
+		printf("Enter time warp (1 = real time, 10 = 10x, 0 = unbounded): ");
+		return false;
+	case 9:
+		menuState = MENU_LATENCY;
+		loopLatencyPrint(&loopLatency);
+		printf("Press ESC and Enter to return to the menu.\n");
+		return false;
+	default:
+		printf("Invalid option. Please try again.\n");
+		return true;
+	}
+}
 
-		// Exibir temperatura atual e parâmetros do PID
-		printf("Current Temperature: %.2f, Setpoint: %.2f\n", currentTemperature, setpointTemperature);
-		printf("PID Controller Values:\n");
-		printf(" Kp: %.2f, Ki: %.2f, Kd: %.2f\n", pidController.Kp, pidController.Ki, pidController.Kd);
-		printf(" Previous Error: %.2f, Integral: %.2f\n", pidController.previousError, pidController.integral);
+// Função para tratar uma linha introduzida pelo utilizador, de acordo com o estado do menu
+// Nunca bloqueia: cada pergunta é um estado e a resposta chega na linha seguinte
+void handleMenuLine(const char* line) {
+	float value = 0.0f;
+	bool numeric = parseFloat(line, &value);
+	bool redraw = true;
 
-		// Verifica se a tecla ESC foi pressionada
-		if (getchar() == 27) { // 27 é o código ASCII para ESC
+	switch (menuState) {
+	case MENU_CHOOSE_OPTION:
+		redraw = handleMenuOption(atoi(line));
+		break;
+	case MENU_ENTER_KP:
+	case MENU_ENTER_KI:
+		if (!numeric) {
+			printf("Invalid input. Please enter a numeric value.\n");
+			printf(menuState == MENU_ENTER_KP ? "Enter Kp: " : "Enter Ki: ");
+			redraw = false;
+			break;
+		}
+		if (menuState == MENU_ENTER_KP) {
+			pendingKp = value;
+			menuState = MENU_ENTER_KI;
+			printf("Enter Ki: ");
+		}
+		else {
+			pendingKi = value;
+			menuState = MENU_ENTER_KD;
+			printf("Enter Kd: ");
+		}
+		redraw = false;
+		break;
+	case MENU_ENTER_KD:
+		if (!numeric) {
+			printf("Invalid input. Please enter a numeric value.\n");
+			printf("Enter Kd: ");
+			redraw = false;
+			break;
+		}
+		setPIDParameters(pendingKp, pendingKi, value);
+		break;
+	case MENU_ENTER_SETPOINT:
+		// Repetir a pergunta até a entrada ser válida
+		if (numeric) {
+			setSetpoint(value);
+		}
+		else {
+			printf("Invalid input. Please enter a numeric value.\n");
+		}
+		if (!numeric || value < MIN_TEMPERATURE || value > MAX_TEMPERATURE) {
+			printf("Enter new setpoint temperature (%.2f to %.2f): ", MIN_TEMPERATURE, MAX_TEMPERATURE);
+			redraw = false;
+		}
+		break;
+	case MENU_ENTER_CURRENT_TEMPERATURE:
+		if (numeric) {
+			setCurrentTemperature(value);
+		}
+		else {
+			printf("Invalid input. Please enter a numeric value.\n");
+		}
+		break;
+	case MENU_ENTER_TIME_WARP:
+		setTimeWarp(numeric ? value : -1.0f);
+		break;
+	case MENU_MONITOR:
+		if (strchr(line, 27) != NULL) { // 27 é o código ASCII para ESC
 			printf("ESC pressed, exiting...\n");
 			break;
 		}
+#ifndef __linux__
+		// Sem ciclo de eventos, cada linha lê a próxima trama da infoPipe
+		{
+			WireFrame frame;
+			if (readFromInfoPipe(&frame)) {
+				storeInfoFrame(&frame);
+			}
+		}
+#endif
+		reads();
+		redraw = false;
+		break;
+	case MENU_LATENCY:
+		if (strchr(line, 27) != NULL) {
+			printf("ESC pressed, exiting...\n");
+			break;
+		}
+		loopLatencyPrint(&loopLatency);
+		printf("Press ESC and Enter to return to the menu.\n");
+		redraw = false;
+		break;
+	}
 
-		usleep(500000);  // Simulação a cada 0.5 segundos
+	if (redraw) {
+		menuState = MENU_CHOOSE_OPTION;
+		if (simulateTemperatureActive) {
+			showMenu();
+		}
 	}
-	return;
+	fflush(stdout);
 }
 
+// Função da thread do menu (usada quando não há ciclo de eventos)
 void* menuInput(void* arg) {
 	char command[MAX_BUFFER_SIZE];
-	int firstOption = -1;  // Armazena a primeira escolha
-	int secondOption = -1; // Armazena a segunda escolha
 
-	int option = 0;
+	showMenu();
+	while (simulateTemperatureActive && fgets(command, sizeof(command), stdin) != NULL) {
+		handleMenuLine(command);
+	}
+	return NULL;
+}
+
+#ifdef __linux__
+
+// Função para armar o temporizador da simulação de acordo com o fator de aceleração
+// Sem limite, a simulação corre em cada volta do ciclo em vez de usar o temporizador
+void armSimulationTimer() {
+	double period = simClockPeriod(&simulationClock);
+	eventTimerSetPeriod(simulationTimer, period);
+	eventLoopSetIdle(&mainLoop, period > 0.0 ? NULL : onSimulationIdle, NULL);
+}
+
+// Função para executar um ciclo e avançar o relógio
+static void runSimulationTick() {
+	simulationStep();
+	simClockAdvance(&simulationClock);
+	if (consoleThreadActive) {
+		return; // O monitor é escrito pela thread da consola
+	}
+	if (menuState == MENU_MONITOR) {
+		reads();
+	}
+	fflush(stdout);
+}
+
+// Função para deixar à thread da consola uma cópia do estado do ciclo
+// Com o lock ocupado pela consola a cópia fica para o passo seguinte, sem bloquear o ciclo
+static void publishMonitorState() {
+	if (consoleThreadActive && pthread_mutex_trylock(&monitorLock) == 0) {
+		captureMonitorState(&monitorState);
+		pthread_mutex_unlock(&monitorLock);
+	}
+}
+
+// Função chamada quando o temporizador da simulação expira
+void onSimulationTimer(int fd, uint32_t events, void* context) {
+	loopLatencyWake(&loopLatency); // A fase de despertar inclui a leitura do timerfd
+	uint64_t expirations = eventTimerRead(fd);
+	loopLatencyLateness(&loopLatency, eventTimerLateness(fd, expirations));
 
+	// Recuperar ciclos atrasados até um limite; os restantes são contados como perdidos
+	uint64_t ticks = expirations > MAX_CATCH_UP_TICKS ? MAX_CATCH_UP_TICKS : expirations;
+	missedTicks += (unsigned long)(expirations - ticks);
+	for (uint64_t i = 0; i < ticks && simulateTemperatureActive; i++) {
+		if (i > 0) {
+			// Os ciclos recuperados não têm despertar próprio; o writev conta para o último
+			loopLatencyCommit(&loopLatency);
+			loopLatencyResume(&loopLatency);
+		}
+		runSimulationTick();
+	}
+	loopLatencyResume(&loopLatency);
+	flushInfoPipe(); // Um só writev para todos os ciclos recuperados
+	if (ticks > 0) {
+		loopLatencyMark(&loopLatency, LOOP_PHASE_WRITE_OUTPUT);
+		loopLatencyCommit(&loopLatency);
+		publishMonitorState();
+	}
+}
+
+// Função chamada em cada volta do ciclo quando o fator de aceleração é ilimitado
+void onSimulationIdle(void* context) {
+	if (simulateTemperatureActive) {
+		loopLatencyWake(&loopLatency);
+		runSimulationTick();
+		loopLatencyResume(&loopLatency);
+		flushInfoPipe();
+		loopLatencyMark(&loopLatency, LOOP_PHASE_WRITE_OUTPUT);
+		loopLatencyCommit(&loopLatency);
+		publishMonitorState();
+	}
+}
+
+// Função chamada quando há dados na infoPipe: guarda a última trama para o monitor
+void onInfoPipeReadable(int fd, uint32_t events, void* context) {
+	WireFrame frame;
+
+	// Um read por evento; todas as tramas que chegaram juntas são separadas do buffer
+	if (frameReaderFill(&infoReader) == -1 && errno != EAGAIN) {
+		perror("Failed to read from infoPipe");
+	}
+	while (frameReaderNext(&infoReader, &frame)) {
+		storeInfoFrame(&frame);
+	}
+}
+
+// Função chamada quando o anel partilhado sinaliza o eventfd: lê todas as tramas pendentes
+void onInfoRingReadable(int fd, uint32_t events, void* context) {
+	WireFrame frame;
+	shmRingClearWakeup(&infoRing);
 	do {
-		clearTerminal(); // Limpa o terminal a cada iteração
-		printf("Thermal Control Application\n");
+		while (readFromInfoPipe(&frame)) {
+			storeInfoFrame(&frame);
+		}
+	} while (!shmRingPrepareWait(&infoRing));
+}
 
-		if (firstOption == -1) {
-			// Se nenhuma opção foi escolhida ainda
-			printf("1. Enable Thermal Control\n");
-			printf("2. Disable Thermal Control\n");
+// Função para ler a entrada do terminal, separar as linhas e tratar cada uma
+// Devolve falso no fim da entrada
+static bool readMenuInput(int fd) {
+	ssize_t count = read(fd, stdinLine + stdinLength, sizeof(stdinLine) - 1 - stdinLength);
+	if (count <= 0) {
+		return false;
+	}
+	stdinLength += (size_t)count;
+	stdinLine[stdinLength] = '\0';
+
+	char* lineStart = stdinLine;
+	char* newline;
+	while ((newline = strchr(lineStart, '\n')) != NULL) {
+		*newline = '\0';
+		handleMenuLine(lineStart);
+		lineStart = newline + 1;
+	}
+
+	// Guardar a linha incompleta; uma linha maior do que o buffer é tratada tal como está
+	stdinLength = strlen(lineStart);
+	if (stdinLength == sizeof(stdinLine) - 1) {
+		handleMenuLine(lineStart);
+		stdinLength = 0;
+	}
+	memmove(stdinLine, lineStart, stdinLength);
+	stdinLine[stdinLength] = '\0';
+	return true;
+}
+
+// Função chamada quando há entrada no terminal
+void onStdinReadable(int fd, uint32_t events, void* context) {
+	if (!readMenuInput(fd)) {
+		// Fim da entrada: terminar como a opção Exit
+		eventLoopRemove(&mainLoop, fd);
+		exitProgram();
+	}
+}
+
+// Função da thread da consola com --rt: menu, mensagens dos passos e monitor, fora do núcleo reservado
+void* consoleThread(void* arg) {
+	clearTerminal();
+	showMenu();
+	bool inputOpen = true;
+	while (simulateTemperatureActive) {
+		StepReport report;
+		bool drained = false;
+		while (consoleQueuePop(&consoleQueue, &report)) {
+			printStepReport(&report);
+			drained = true;
+		}
+		if (drained && menuState == MENU_MONITOR) {
+			reads();
+		}
+		fflush(stdout);
+
+		// A espera pelo terminal também marca o ritmo a que a fila é esvaziada
+		struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+		if (!inputOpen) {
+			poll(NULL, 0, CONSOLE_IDLE_MS);
 		}
-		else if (secondOption == -1) {
-			// Se uma opção já foi escolhida, remove a possibilidade de repetição
-			if (firstOption == 1) {
-				printf("2. Disable Thermal Control\n");
+		else if (poll(&input, 1, CONSOLE_IDLE_MS) > 0 && !readMenuInput(STDIN_FILENO)) {
+			inputOpen = false;
+			exitProgram(); // Fim da entrada: terminar como a opção Exit
+		}
+	}
+	return NULL;
+}
+
+// Função para correr a simulação, a infoPipe e o menu num único ciclo de eventos
+int runEventLoop() {
+	if (eventLoopInit(&mainLoop) != 0) {
+		return EXIT_FAILURE;
+	}
+
+	simulationTimer = eventTimerCreate();
+	if (simulationTimer == -1) {
+		eventLoopClose(&mainLoop);
+		return EXIT_FAILURE;
+	}
+
+	// A leitura da infoPipe também não pode bloquear o ciclo; é feita no lote de I/O de cada ciclo
+	fcntl(infoPipe[0], F_SETFL, fcntl(infoPipe[0], F_GETFL) | O_NONBLOCK);
+	readInfoOnFlush = true;
+
+	// Com --transport shm as tramas chegam pelo anel e o ciclo só espera pelo seu eventfd
+	if (infoTransport == TRANSPORT_SHM && shmRingCreate(&infoRing, INFO_RING_SLOTS, WIRE_MAX_FRAME_SIZE) != 0) {
+		close(simulationTimer);
+		eventLoopClose(&mainLoop);
+		return EXIT_FAILURE;
+	}
+
+	// Subscritores da telemetria, servidos pelo mesmo ciclo
+	if (serveTelemetry && telemetryServerOpen(&telemetryServer, TELEMETRY_SOCKET, &mainLoop, overflowPolicy) != 0) {
+		serveTelemetry = false;
+	}
+
+	int infoResult = infoTransport == TRANSPORT_SHM ?
+		eventLoopAdd(&mainLoop, infoRing.eventFd, EPOLLIN, onInfoRingReadable, NULL) :
+		eventLoopAdd(&mainLoop, infoPipe[0], EPOLLIN, onInfoPipeReadable, NULL);
+	// Com --rt o terminal fica com a thread da consola; o ciclo só trata o temporizador e as tramas
+	consoleThreadActive = realTime.enabled;
+	if (eventLoopAdd(&mainLoop, simulationTimer, EPOLLIN, onSimulationTimer, NULL) != 0 || infoResult != 0 ||
+		(!consoleThreadActive && eventLoopAdd(&mainLoop, STDIN_FILENO, EPOLLIN, onStdinReadable, NULL) != 0)) {
+		if (infoTransport == TRANSPORT_SHM) {
+			shmRingDestroy(&infoRing);
+		}
+		close(simulationTimer);
+		eventLoopClose(&mainLoop);
+		return EXIT_FAILURE;
+	}
+
+	simulateTemperatureActive = true;
+	pthread_t consoleId;
+	if (consoleThreadActive) {
+		consoleQueueInit(&consoleQueue);
+		captureMonitorState(&monitorState);
+		armSimulationTimer();
+		if (realTimeCreateThread(&realTime, &consoleId, consoleThread, NULL, &realTimeReport) != 0) {
+			fprintf(stderr, "Failed to create console thread\n");
+			simulateTemperatureActive = false;
+			consoleThreadActive = false;
+			eventLoopStop(&mainLoop);
+		}
+	}
+	else {
+		clearTerminal();
+		showMenu();
+		armSimulationTimer();
+	}
+
+	int result = eventLoopRun(&mainLoop);
+	if (consoleThreadActive) {
+		pthread_join(consoleId, NULL);
+	}
+
+	if (serveTelemetry) {
+		telemetryServerClose(&telemetryServer);
+	}
+	if (infoTransport == TRANSPORT_SHM) {
+		shmRingDestroy(&infoRing);
+	}
+	close(simulationTimer);
+	eventLoopClose(&mainLoop);
+	return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif // __linux__
+
+// Função para simular várias zonas em lote, sem menu nem pipes
+int runZoneSimulation(size_t zoneCount, long steps, double timeWarp, const OrbitTable* orbit,
+	const ControllerKind* kinds, size_t kindCount) {
+	ZoneEngine engine;
+	if (zoneEngineInit(&engine, zoneCount) != 0) {
+		fprintf(stderr, "Failed to allocate %zu zones\n", zoneCount);
+		return EXIT_FAILURE;
+	}
+
+	// Todas as zonas partem do estado atual da aplicação
+	for (size_t i = 0; i < zoneCount; i++) {
+		zoneEngineSetZone(&engine, i, currentTemperature, setpointTemperature, &pidController, true);
+	}
+
+	// As zonas são repartidas em grupos contíguos, um por tipo de controlador pedido
+	if (kindCount > 0) {
+		ZoneGroup groups[CONTROLLER_KIND_COUNT];
+		for (size_t g = 0; g < kindCount; g++) {
+			groups[g].begin = zoneCount * g / kindCount;
+			groups[g].end = zoneCount * (g + 1) / kindCount;
+			groups[g].kind = kinds[g];
+		}
+		zoneEngineSetGroups(&engine, groups, kindCount);
+	}
+
+	// Com ambiente orbital, as zonas ficam distribuídas ao longo da órbita e partilham a mesma tabela
+	if (orbit != NULL) {
+		for (size_t i = 0; i < zoneCount; i++) {
+			engine.orbitPhase[i] = (float)i / (float)zoneCount;
+		}
+		zoneEngineSetEnvironment(&engine, orbit, SIMULATION_DT, ORBIT_ENVIRONMENT_GAIN);
+	}
+
+	SimClock zoneClock;
+	simClockInit(&zoneClock, SIMULATION_DT, timeWarp);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long step = 0; step < steps; step++) {
+		zoneEngineStep(&engine);
+		simClockTick(&zoneClock);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+	float minimum = engine.temperature[0];
+	float maximum = engine.temperature[0];
+	double sum = 0.0;
+	for (size_t i = 0; i < zoneCount; i++) {
+		minimum = fminf(minimum, engine.temperature[i]);
+		maximum = fmaxf(maximum, engine.temperature[i]);
+		sum += engine.temperature[i];
+	}
+
+	printf("Zones: %zu, Steps: %ld, PID kernel: %s, Elapsed: %.3f s", zoneCount, steps,
+		pidBatchImplementationName(pidBatchGetImplementation()), elapsed);
+	if (elapsed > 0.0) {
+		printf(", Zone-steps/s: %.0f", (double)zoneCount * (double)steps / elapsed);
+	}
+	printf("\nSimulated Time: %.1f s\n", zoneClock.simulatedTime);
+	for (size_t g = 0; g < engine.groupCount; g++) {
+		printf("Group %zu: zones %zu-%zu, controller %s\n", g, engine.groups[g].begin, engine.groups[g].end,
+			controllerKindName(engine.groups[g].kind));
+	}
+	printf("Temperature: min %.2f, max %.2f, mean %.2f\n", minimum, maximum, sum / (double)zoneCount);
+
+	zoneEngineFree(&engine);
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+	size_t zoneCount = 0;
+	long zoneSteps = 1000;
+	double timeWarp = -1.0; // Por omissão: 1x no modo interativo, sem limite em lote
+	bool monteCarlo = false;
+	size_t networkNodes = 0;
+	double networkDt = 10.0;
+	bool useOrbit = false;
+	bool fixedComparison = false;
+	ControllerKind controllerKinds[CONTROLLER_KIND_COUNT];
+	size_t controllerKindCount = 0;
+	const char* outputPath = NULL;
+	long transportBenchmark = 0;
+	long parserBenchmark = 0;
+	const char* queryPath = NULL;
+	const char* replayPath = NULL;
+	const char* plotPath = NULL;
+	size_t plotPoints = 2000;
+	TelemetryQuery query = { INT64_MIN, INT64_MAX, -1, NULL };
+	TelemetryQueryKind queryKind = QUERY_RANGE;
+	float queryThreshold = 0.0f;
+	MonteCarloConfig monteCarloConfig;
+	monteCarloDefaultConfig(&monteCarloConfig);
+
+	// Argumentos da linha de comandos
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--zones") == 0 && i + 1 < argc) {
+			zoneCount = strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+			zoneSteps = strtol(argv[++i], NULL, 10);
+			monteCarloConfig.steps = zoneSteps;
+		}
+		else if (strcmp(argv[i], "--monte-carlo") == 0 && i + 1 < argc) {
+			monteCarlo = true;
+			char* end;
+			monteCarloConfig.runs = strtoul(argv[++i], &end, 10);
+			if (end == argv[i] || *end != '\0' || argv[i][0] == '-' || monteCarloConfig.runs == 0) {
+				fprintf(stderr, "Invalid run count: %s (use a positive integer)\n", argv[i]);
+				return EXIT_FAILURE;
 			}
-			else {
-				printf("1. Enable Thermal Control\n");
+		}
+		else if (strcmp(argv[i], "--network") == 0 && i + 1 < argc) {
+			networkNodes = strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc) {
+			char* end;
+			networkDt = strtod(argv[++i], &end);
+			if (end == argv[i] || *end != '\0' || !isfinite(networkDt) || networkDt <= 0.0) {
+				fprintf(stderr, "Invalid time step: %s (use a positive number of seconds)\n", argv[i]);
+				return EXIT_FAILURE;
 			}
 		}
-
-		// Exibe as outras opções
-		printf("3. Set PID Parameters\n");
-		printf("4. Set Setpoint Temperature\n");
-		printf("5. Set Current Temperature\n");
-		printf("6. Read from Pipe\n");
-		printf("7. Exit\n");
-
-		printf("Choose an option: ");
-
-		if (fgets(command, sizeof(command), stdin) != NULL) {
-			option = atoi(command);
-
-			if (firstOption == -1) {
-				// Primeira escolha: ou ativa ou desativa o controlo térmico
-				if (option == 1 || option == 2) {
-					firstOption = option;
-					if (option == 1) {
-						thermalControlEnabled = true;
-						printf("Thermal Control Enabled\n");
-					}
-					else if (option == 2) {
-						thermalControlEnabled = false;
-						printf("Thermal Control Disabled\n");
-					}
-				}
-				else if (option == 7) {
-					thermalControlEnabled = false;
-					simulateTemperatureActive = false;
-					pthread_join(simulationThread, NULL); // Aguardar a conclusão da simulação;
-					printf("Exiting program...\n");
-					exit(0);
-					continue;
-				}
-				else {
-					printf("Invalid option. Please choose 1 or 2.\n");
-					continue;
+		else if (strcmp(argv[i], "--controller") == 0 && i + 1 < argc) {
+			// Lista separada por vírgulas, p. ex. "p,pi,pid"
+			char list[MAX_BUFFER_SIZE];
+			snprintf(list, sizeof(list), "%s", argv[++i]);
+			controllerKindCount = 0;
+			for (char* name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+				if (controllerKindCount == CONTROLLER_KIND_COUNT ||
+					controllerKindFromName(name, &controllerKinds[controllerKindCount]) != 0) {
+					fprintf(stderr, "Invalid controller list: %s (use p, pi, pi-aw, pid)\n", argv[i]);
+					return EXIT_FAILURE;
 				}
+				controllerKindCount++;
 			}
-			else if (secondOption == -1) {
-				// Segunda escolha: a outra opção deve ser selecionada
-				if ((firstOption == 1 && option == 2) || (firstOption == 2 && option == 1)) {
-					secondOption = option;
-					if (option == 1) {
-						thermalControlEnabled = true;
-						printf("Thermal Control Enabled\n");
-					}
-					else if (option == 2) {
-						thermalControlEnabled = false;
-						printf("Thermal Control Disabled\n");
-					}
-				}
-				else if (option == 7) {
-					thermalControlEnabled = false;
-					simulateTemperatureActive = false;
-					pthread_join(simulationThread, NULL); // Aguardar a conclusão da simulação;
-					printf("Exiting program...\n");
-					exit(0);
-					continue;
-				}
-				else {
-					printf("Invalid option. Please choose the remaining option (1 or 2).\n");
-					continue;
-				}
+		}
+		else if (strcmp(argv[i], "--pid-fixed-compare") == 0) {
+			fixedComparison = true;
+		}
+		else if (strcmp(argv[i], "--orbit") == 0) {
+			useOrbit = true;
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			monteCarloConfig.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			monteCarloConfig.threads = (unsigned)strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+			outputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--warp") == 0 && i + 1 < argc) {
+			const char* value = argv[++i];
+			timeWarp = strcmp(value, "max") == 0 ? TIME_WARP_UNBOUNDED : strtod(value, NULL);
+			if (timeWarp < 0.0) {
+				timeWarp = TIME_WARP_UNBOUNDED;
+			}
+		}
+		else if (strcmp(argv[i], "--virtual-clock") == 0) {
+			timeWarp = TIME_WARP_UNBOUNDED;
+		}
+		else if (strcmp(argv[i], "--pid-kernel") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			if (strcmp(name, "scalar") == 0) {
+				pidBatchSetImplementation(PID_BATCH_SCALAR);
+			}
+			else if (strcmp(name, "sse") == 0) {
+				pidBatchSetImplementation(PID_BATCH_SSE);
+			}
+			else if (strcmp(name, "avx2") == 0) {
+				pidBatchSetImplementation(PID_BATCH_AVX2);
 			}
 			else {
-				// Permitir apenas ajustes normais após as duas escolhas
-				switch (option) {
-				case 3: {
-					float kp, ki, kd;
-					printf("Enter Kp: ");
-					scanf("%f", &kp);
-					printf("Enter Ki: ");
-					scanf("%f", &ki);
-					printf("Enter Kd: ");
-					scanf("%f", &kd);
-					setPIDParameters(kp, ki, kd);
-					break;
-				}
-				case 4:
-					setSetpoint(setpointTemperature);
-					break;
-				case 5:
-					float currentTemp;
-					printf("Enter Current Temperature %.2f and %.2f:\n", MIN_TEMPERATURE, MAX_TEMPERATURE);
-					scanf("%f", &currentTemp);
-					setCurrentTemperature(currentTemp);
-					break;
-				case 6:
-					reads();
-					break;
-				case 7:
-					thermalControlEnabled = false;
-					simulateTemperatureActive = false;
-					pthread_join(simulationThread, NULL); // Aguardar a conclusão da simulação;
-					printf("Exiting program...\n");
-					exit(0);
-					break;
-				default:
-					printf("Invalid option. Please try again.\n");
-					break;
-				}
+				fprintf(stderr, "Invalid PID kernel: %s (use scalar, sse or avx2)\n", name);
+				return EXIT_FAILURE;
 			}
 		}
-	} while (option != 7);
-}
+		else if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			if (strcmp(name, "pipe") == 0) {
+				infoTransport = TRANSPORT_PIPE;
+			}
+			else if (strcmp(name, "shm") == 0) {
+#ifdef __linux__
+				infoTransport = TRANSPORT_SHM;
+#else
+				fprintf(stderr, "The shared-memory transport is only available on Linux\n");
+				return EXIT_FAILURE;
+#endif
+			}
+			else {
+				fprintf(stderr, "Invalid transport: %s (use shm or pipe)\n", name);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--transport-bench") == 0 && i + 1 < argc) {
+			transportBenchmark = strtol(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--overflow") == 0 && i + 1 < argc) {
+			if (overflowPolicyFromName(argv[++i], &overflowPolicy) != 0) {
+				fprintf(stderr, "Invalid overflow policy: %s (use drop-oldest, drop-newest or coalesce)\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--io") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			if (strcmp(name, "uring") == 0) {
+				ioBackendKind = IO_BACKEND_URING;
+			}
+			else if (strcmp(name, "sync") == 0 || strcmp(name, "epoll") == 0) {
+				ioBackendKind = IO_BACKEND_SYNC;
+			}
+			else {
+				fprintf(stderr, "Invalid I/O backend: %s (use uring or epoll)\n", name);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+			logPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--rt") == 0 && i + 1 < argc) {
+			if (!realTimeParse(argv[++i], &realTime)) {
+				fprintf(stderr, "Invalid real-time mode: %s (use CPU or CPU:PRIORITY)\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--fifo") == 0) {
+			exportToFifo = true;
+		}
+		else if (strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--subscribe") == 0) {
+#ifdef __linux__
+			if (strcmp(argv[i], "--serve") == 0) {
+				serveTelemetry = true;
+			}
+			else {
+				// A política é opcional: --subscribe [drop-oldest|drop-newest|coalesce]
+				const char* policy = i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0 ? argv[++i] : NULL;
+				return runTelemetrySubscriber(TELEMETRY_SOCKET, policy);
+			}
+#else
+			fprintf(stderr, "The telemetry socket is only available on Linux\n");
+			return EXIT_FAILURE;
+#endif
+		}
+		else if (strcmp(argv[i], "--store-import") == 0 && i + 2 < argc) {
+			return telemetryStoreImportCsv(argv[i + 1], argv[i + 2]);
+		}
+		else if (strcmp(argv[i], "--store-export") == 0 && i + 2 < argc) {
+			return telemetryStoreExportCsv(argv[i + 1], argv[i + 2]);
+		}
+		else if (strcmp(argv[i], "--store-verify") == 0 && i + 2 < argc) {
+			return telemetryStoreVerify(argv[i + 1], argv[i + 2]);
+		}
+		else if (strcmp(argv[i], "--store-info") == 0 && i + 1 < argc) {
+			return runTelemetryStoreInfo(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--plot") == 0 && i + 1 < argc) {
+			plotPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--points") == 0 && i + 1 < argc) {
+			plotPoints = strtoul(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--query") == 0 && i + 1 < argc) {
+			queryPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--sensor") == 0 && i + 1 < argc) {
+			query.sensor = atoi(argv[++i]) - 1; // THERM-01 = 1
+			if (query.sensor < 0 || query.sensor >= STORE_SENSORS) {
+				fprintf(stderr, "Invalid sensor: %s (use 1 to %d)\n", argv[i], STORE_SENSORS);
+				return EXIT_FAILURE;
+			}
+		}
+		else if ((strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) && i + 1 < argc) {
+			int64_t* bound = strcmp(argv[i], "--from") == 0 ? &query.from : &query.to;
+			if (!telemetryStoreParseTimestamp(argv[i + 1], strlen(argv[i + 1]), bound)) {
+				fprintf(stderr, "Invalid timestamp: %s (use YYYY-MM-DDTHH:MM:SS[.mmm])\n", argv[i + 1]);
+				return EXIT_FAILURE;
+			}
+			i++;
+		}
+		else if (strcmp(argv[i], "--env") == 0 && i + 1 < argc) {
+			query.environment = argv[++i];
+		}
+		else if (strcmp(argv[i], "--aggregate") == 0) {
+			queryKind = QUERY_AGGREGATE;
+		}
+		else if (strcmp(argv[i], "--crossings") == 0 && i + 1 < argc) {
+			queryKind = QUERY_CROSSINGS;
+			queryThreshold = strtof(argv[++i], NULL);
+		}
+		else if (strcmp(argv[i], "--parser-bench") == 0 && i + 1 < argc) {
+			parserBenchmark = strtol(argv[++i], NULL, 10);
+		}
+		else {
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			fprintf(stderr, "Usage: %s [--zones N [--steps S] [--pid-kernel scalar|sse|avx2] [--controller p,pi,pi-aw,pid]] [--warp X|max] [--virtual-clock] [--orbit] [--transport shm|pipe] [--fifo] [--serve] [--log FILE] [--rt CPU[:PRIORITY]] [--io uring|epoll] [--overflow drop-oldest|drop-newest|coalesce]\n"
+				"       %s --monte-carlo RUNS [--steps S] [--seed N] [--threads T] [--output FILE]\n"
+				"       %s --network NODES [--steps S] [--dt SECONDS] [--orbit]\n"
+				"       %s --pid-fixed-compare [--steps S]\n"
+				"       %s --transport-bench MESSAGES\n"
+				"       %s --parser-bench LINES\n"
+				"       %s --subscribe [drop-oldest|drop-newest|coalesce]\n"
+				"       %s --store-import CSV STORE | --store-export STORE CSV | --store-info STORE | --store-verify CSV STORE\n"
+				"       %s --replay CSV|STORE [--warp X|max] [--output FILE]\n"
+				"       %s --plot STORE|CSV [--sensor 1-4] [--from TIME] [--to TIME] [--points N]\n"
+				"       %s --query STORE [--sensor 1-4] [--from TIME] [--to TIME] [--env NAME] [--aggregate | --crossings T]\n",
+				argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Consulta ao formato colunar com o índice de blocos
+	if (queryPath != NULL) {
+		if (queryKind != QUERY_RANGE && query.sensor < 0) {
+			query.sensor = 0; // Agregados e passagens são de um único sensor (THERM-01 por omissão)
+		}
+		return runTelemetryQuery(queryPath, &query, queryKind, queryThreshold);
+	}
+
+	// Vista resumida para gráficos, a partir da pirâmide de resumos
+	if (plotPath != NULL) {
+		return runDecimatedView(plotPath, &query, plotPoints);
+	}
+
+	// Reprodução de telemetria gravada (ritmo original por omissão)
+	if (replayPath != NULL) {
+		return runReplay(replayPath, timeWarp < 0.0 ? 1.0 : timeWarp, &pidController, setpointTemperature, outputPath);
+	}
+
+	// Modo Monte Carlo: simulações independentes para afinação do PID
+	if (monteCarlo) {
+		return runMonteCarlo(&monteCarloConfig, outputPath);
+	}
+
+	// Comparação de exatidão entre o PID em float e em vírgula fixa
+	if (fixedComparison) {
+		return runFixedPointComparison(&pidController, setpointTemperature, zoneSteps);
+	}
+
+	// Leitor de telemetria em texto comparado com sscanf
+	if (parserBenchmark > 0) {
+		return runParserBenchmark(parserBenchmark);
+	}
+
+	// Latência do pipe e do anel partilhado
+	if (transportBenchmark > 0) {
+#ifdef __linux__
+		return runTransportBenchmark(transportBenchmark);
+#else
+		fprintf(stderr, "The transport benchmark is only available on Linux\n");
+		return EXIT_FAILURE;
+#endif
+	}
+
+	// Tabela orbital única, partilhada só em leitura por todas as zonas ou painéis
+	OrbitTable orbit;
+	if (useOrbit) {
+		OrbitParameters parameters;
+		orbitDefaultParameters(&parameters);
+		if (orbitTableBuild(&orbit, &parameters, ORBIT_TABLE_DEFAULT_SIZE) != 0) {
+			fprintf(stderr, "Failed to build orbit table\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Modo rede térmica: quatro painéis aquecidos com solver implícito
+	if (networkNodes > 0) {
+		int result = runThermalNetwork(networkNodes, zoneSteps, networkDt, setpointTemperature, &pidController,
+			useOrbit ? &orbit : NULL);
+		if (useOrbit) {
+			orbitTableFree(&orbit);
+		}
+		return result;
+	}
+
+	// Modo em lote: simula várias zonas sem o menu interativo
+	if (zoneCount > 0) {
+		int result = runZoneSimulation(zoneCount, zoneSteps, timeWarp < 0.0 ? TIME_WARP_UNBOUNDED : timeWarp,
+			useOrbit ? &orbit : NULL, controllerKinds, controllerKindCount);
+		if (useOrbit) {
+			orbitTableFree(&orbit);
+		}
+		return result;
+	}
+
+	simClockInit(&simulationClock, SIMULATION_DT, timeWarp < 0.0 ? 1.0 : timeWarp);
 
-int main() {
 	createPipes(); // Cria os pipes
+	ioBackendInit(&ioBackend, ioBackendKind); // Sem io_uring continua com I/O síncrono
 	signal(SIGINT, SIG_IGN); // Ignora o sinal de interrupção
+	signal(SIGPIPE, SIG_IGN); // Um leitor que fecha o FIFO é tratado como EPIPE
+
+	// Cópia das tramas para o FIFO do TCF; ligado quando aparecer um leitor
+	if (exportToFifo) {
+		frameWriterOpenFifo(&exportWriter, TEMP_INFO_PIPE, overflowPolicy);
+	}
+	if (logPath != NULL && telemetryLoggerStart(&telemetryLogger, logPath, ioBackend.kind) != 0) {
+		return EXIT_FAILURE;
+	}
 
 	// Certifique-se de que currentTemperature está dentro dos limites ao iniciar
 	if (currentTemperature > MAX_TEMPERATURE) {
@@ -443,7 +1700,25 @@ int main() {
 	else if (currentTemperature < MIN_TEMPERATURE) {
 		currentTemperature = MIN_TEMPERATURE;
 	}
+	if (initControllerState() != 0) {
+		return EXIT_FAILURE;
+	}
+	loopLatencyInit(&loopLatency);
 
+#ifdef __linux__
+	// Simulação, infoPipe e menu partilham um único ciclo de eventos
+	if (realTime.enabled) {
+		enterRealTimeMode();
+	}
+	int result = runEventLoop();
+	loopLatencyPrint(&loopLatency);
+	configReaderOffline(&controlConfig, CONFIG_READER_SIMULATION);
+	configDomainDestroy(&controlConfig);
+	if (logPath != NULL) {
+		telemetryLoggerStop(&telemetryLogger); // Escreve as linhas em falta
+	}
+	return result;
+#else
 	if (pthread_create(&simulationThread, NULL, simulateTemperature, NULL) != 0) {
 		perror("Failed to create simulation thread");
 		return EXIT_FAILURE;
@@ -460,4 +1735,5 @@ int main() {
 	// Aqui você pode adicionar a limpeza de recursos, se necessário.
 
 	return EXIT_SUCCESS;
+#endif
 }
\ No newline at end of file
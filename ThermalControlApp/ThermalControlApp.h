@@ -10,7 +10,24 @@
 #include <stdbool.h>
 #include <signal.h>
 #include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdint.h>
+#include "WireProtocol.h"
 
+#define MIN_TEMPERATURE -25.0f
+#define MAX_TEMPERATURE 25.0f
+
+#define MIN_INTEGRAL_VALUE -10.0f   // Valor mínimo para a integral
+#define MAX_INTEGRAL_VALUE 10.0f     // Valor máximo para a integral
+
+#define MAX_OUTPUT 100.0f // Define o limite máximo da saída do PID
+#define MIN_OUTPUT -100.0f // Define o limite mínimo da saída do PID
+
+#define TEMPERATURE_DRIFT 0.5f // Variação por ciclo quando a temperatura está fora dos limites ou sem controlo
 
 // Estrutura PIDController
 typedef struct {
@@ -21,20 +38,79 @@ typedef struct {
 	float integral;
 } PIDController;
 
+// Estrutura ControllerSnapshot: estado publicado pelo ciclo de simulação no fim de cada passo
+typedef struct {
+	float currentTemperature;
+	float setpoint;
+	float controlOutput;
+	PIDController pid;
+	double simulatedTime;
+	long steps;
+	bool thermalControlEnabled;
+} ControllerSnapshot;
+
+// Estrutura StepReport: o que um passo da simulação mostra na consola, escrito depois das fases medidas
+typedef struct {
+	bool controlled;            // O passo calculou o PID
+	float error;
+	float controlOutput;
+	float reachedTemperature;   // Temperatura depois do ajuste, antes de corrigir os limites
+	int limit;                  // 1 = máximo atingido, -1 = mínimo atingido, 0 = dentro dos limites
+	float temperature;          // Temperatura no fim do passo
+} StepReport;
+
+// Estados do menu: cada pergunta ao utilizador é um estado, para que a entrada nunca bloqueie
+typedef enum {
+	MENU_CHOOSE_OPTION,
+	MENU_ENTER_KP,
+	MENU_ENTER_KI,
+	MENU_ENTER_KD,
+	MENU_ENTER_SETPOINT,
+	MENU_ENTER_CURRENT_TEMPERATURE,
+	MENU_ENTER_TIME_WARP,
+	MENU_MONITOR,
+	MENU_LATENCY            // Opção 9: cada linha volta a mostrar os histogramas, ESC regressa ao menu
+} MenuState;
+
+// Transporte das tramas da infoPipe
+typedef enum {
+	TRANSPORT_PIPE,     // pipe() anónimo (por omissão, disponível em todas as plataformas)
+	TRANSPORT_SHM       // Anel SPSC em memória partilhada (Linux)
+} InfoTransport;
+
 // Funções do aplicativo
 void createPipes();
 void clearTerminal();
 void adjustTemperature(float adjustment);
+void simulationStep();
 void* simulateTemperature(void* arg);
-void writeToInfoPipe(const char* message);
-void readFromInfoPipe(char* buffer, size_t bufferSize);
-void writeToResponsePipe(const char* message);
-void readFromResponsePipe(char* buffer, size_t bufferSize);
+void writeToInfoPipe(const WireFrame* frame);
+void flushInfoPipe();
+void sendInfoFrame(WireMessageType type, float value, bool heaterOn);
+bool readFromInfoPipe(WireFrame* frame);
+void storeInfoFrame(const WireFrame* frame);
+const WireFrame* lastInfoTemperatures();
+float controlStep(PIDController* pid, float error);
+void writeToResponsePipe(const WireFrame* frame);
+bool readFromResponsePipe(WireFrame* frame);
 void setPIDParameters(float kp, float ki, float kd);
 float calculatePIDControl(float error);
 void setSetpoint(float value);
 void setCurrentTemperature(float value);
 void* menuInput(void* arg);
+void showMenu();
+void handleMenuLine(const char* line);
+void exitProgram();
 void reads();
+void setTimeWarp(float warp);
+#ifdef __linux__
+void armSimulationTimer();
+void onSimulationTimer(int fd, uint32_t events, void* context);
+void onSimulationIdle(void* context);
+void onInfoPipeReadable(int fd, uint32_t events, void* context);
+void onInfoRingReadable(int fd, uint32_t events, void* context);
+void onStdinReadable(int fd, uint32_t events, void* context);
+int runEventLoop();
+#endif
 
 #endif // THERMAL_CONTROL_APP_H
@@ -0,0 +1,437 @@
+﻿// ThermalNetwork.c : Euler implícito sobre a matriz de condutâncias em CSR.
+// A radiação é linearizada em torno da temperatura atual, o que mantém a matriz
+// simétrica e o passo estável para qualquer dt; o sistema é resolvido por
+// gradiente conjugado com pré-condicionador de Jacobi.
+
+#include "ThermalNetwork.h"
+#include "PIDBatch.h"
+
+#define HEATER_MAX_POWER 200.0         // Potência máxima de cada aquecedor (W)
+#define SPACE_TEMPERATURE -270.15      // Fundo do espaço profundo (°C)
+#define NETWORK_MIN_NODES 10           // Espaço, estrutura e quatro painéis de um elemento com termístor
+#define PANEL_ABSORPTANCE 0.02         // Absortância efetiva dos painéis cobertos por MLI
+
+// Função para inicializar uma rede com nodeCount nós sem ligações
+int thermalNetworkInit(ThermalNetwork* network, size_t nodeCount) {
+	memset(network, 0, sizeof(*network));
+	network->nodeCount = nodeCount;
+	network->capacity = calloc(nodeCount, sizeof(double));
+	network->temperature = calloc(nodeCount, sizeof(double));
+	network->heaterPower = calloc(nodeCount, sizeof(double));
+	network->boundary = calloc(nodeCount, sizeof(uint8_t));
+	network->rhs = calloc(nodeCount, sizeof(double));
+	network->residual = calloc(nodeCount, sizeof(double));
+	network->direction = calloc(nodeCount, sizeof(double));
+	network->product = calloc(nodeCount, sizeof(double));
+	network->preconditioned = calloc(nodeCount, sizeof(double));
+	network->diagonal = calloc(nodeCount, sizeof(size_t));
+	network->rowStart = calloc(nodeCount + 1, sizeof(size_t));
+
+	if (network->capacity == NULL || network->temperature == NULL || network->heaterPower == NULL ||
+		network->boundary == NULL || network->rhs == NULL || network->residual == NULL ||
+		network->direction == NULL || network->product == NULL || network->preconditioned == NULL ||
+		network->diagonal == NULL || network->rowStart == NULL) {
+		thermalNetworkFree(network);
+		return -1;
+	}
+	return 0;
+}
+
+// Função para libertar a memória da rede
+void thermalNetworkFree(ThermalNetwork* network) {
+	free(network->capacity);
+	free(network->temperature);
+	free(network->heaterPower);
+	free(network->boundary);
+	free(network->links);
+	free(network->rowStart);
+	free(network->column);
+	free(network->value);
+	free(network->diagonal);
+	free(network->rhs);
+	free(network->residual);
+	free(network->direction);
+	free(network->product);
+	free(network->preconditioned);
+	memset(network, 0, sizeof(*network));
+}
+
+// Função para configurar um nó
+void thermalNetworkSetNode(ThermalNetwork* network, size_t node, double capacity, double temperature, bool boundary) {
+	if (node >= network->nodeCount) {
+		return;
+	}
+	network->capacity[node] = capacity;
+	network->temperature[node] = temperature;
+	network->boundary[node] = boundary ? 1 : 0;
+}
+
+// Função para acrescentar uma ligação (só antes de thermalNetworkFinalize)
+static int addLink(ThermalNetwork* network, size_t from, size_t to, ThermalLinkType type, double value) {
+	if (network->finalized || from >= network->nodeCount || to >= network->nodeCount || from == to) {
+		return -1;
+	}
+
+	if (network->linkCount == network->linkCapacity) {
+		size_t capacity = network->linkCapacity > 0 ? network->linkCapacity * 2 : 64;
+		ThermalLink* links = realloc(network->links, capacity * sizeof(ThermalLink));
+		if (links == NULL) {
+			return -1;
+		}
+		network->links = links;
+		network->linkCapacity = capacity;
+	}
+
+	ThermalLink* link = &network->links[network->linkCount++];
+	memset(link, 0, sizeof(*link));
+	link->from = from;
+	link->to = to;
+	link->type = type;
+	link->value = value;
+	return 0;
+}
+
+// Função para acrescentar uma ligação condutiva (G em W/K)
+int thermalNetworkAddConductor(ThermalNetwork* network, size_t from, size_t to, double conductance) {
+	return addLink(network, from, to, THERMAL_LINK_CONDUCTIVE, conductance);
+}
+
+// Função para acrescentar uma ligação radiativa (R = ε σ A F)
+int thermalNetworkAddRadiator(ThermalNetwork* network, size_t from, size_t to, double emissivity, double area, double viewFactor) {
+	return addLink(network, from, to, THERMAL_LINK_RADIATIVE, emissivity * STEFAN_BOLTZMANN * area * viewFactor);
+}
+
+// Função para definir a potência de um aquecedor
+void thermalNetworkSetHeater(ThermalNetwork* network, size_t node, double power) {
+	if (node < network->nodeCount) {
+		network->heaterPower[node] = power;
+	}
+}
+
+// Função para procurar a posição de (row, col) na matriz CSR
+static size_t findEntry(const ThermalNetwork* network, size_t row, size_t col) {
+	size_t low = network->rowStart[row];
+	size_t high = network->rowStart[row + 1];
+	while (low < high) {
+		size_t middle = (low + high) / 2;
+		if (network->column[middle] < col) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+// Função de comparação para ordenar colunas
+static int compareSize(const void* a, const void* b) {
+	size_t x = *(const size_t*)a;
+	size_t y = *(const size_t*)b;
+	return (x > y) - (x < y);
+}
+
+// Função para construir o padrão CSR a partir das ligações
+int thermalNetworkFinalize(ThermalNetwork* network) {
+	size_t n = network->nodeCount;
+	size_t* count = network->rowStart;
+
+	// Cada linha tem a diagonal e uma entrada por ligação (com repetições)
+	memset(count, 0, (n + 1) * sizeof(size_t));
+	for (size_t i = 0; i < n; i++) {
+		count[i + 1] = 1;
+	}
+	for (size_t k = 0; k < network->linkCount; k++) {
+		count[network->links[k].from + 1]++;
+		count[network->links[k].to + 1]++;
+	}
+	for (size_t i = 0; i < n; i++) {
+		count[i + 1] += count[i];
+	}
+
+	size_t* columns = malloc(count[n] * sizeof(size_t));
+	size_t* fill = malloc(n * sizeof(size_t));
+	if (columns == NULL || fill == NULL) {
+		free(columns);
+		free(fill);
+		return -1;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		fill[i] = count[i];
+		columns[fill[i]++] = i;
+	}
+	for (size_t k = 0; k < network->linkCount; k++) {
+		const ThermalLink* link = &network->links[k];
+		columns[fill[link->from]++] = link->to;
+		columns[fill[link->to]++] = link->from;
+	}
+
+	// Ordenar e remover repetições em cada linha, compactando no lugar
+	size_t written = 0;
+	for (size_t i = 0; i < n; i++) {
+		size_t begin = count[i];
+		size_t end = count[i + 1];
+		qsort(columns + begin, end - begin, sizeof(size_t), compareSize);
+		count[i] = written;
+		for (size_t k = begin; k < end; k++) {
+			if (k == begin || columns[k] != columns[k - 1]) {
+				columns[written++] = columns[k];
+			}
+		}
+	}
+	count[n] = written;
+	free(fill);
+
+	// Se a redução falhar, o bloco original continua válido (só maior)
+	size_t* shrunk = realloc(columns, (written > 0 ? written : 1) * sizeof(size_t));
+	double* value = calloc(written > 0 ? written : 1, sizeof(double));
+	if (value == NULL) {
+		free(shrunk != NULL ? shrunk : columns);
+		return -1;
+	}
+	free(network->column); // De uma chamada anterior que tenha falhado
+	free(network->value);
+	network->column = shrunk != NULL ? shrunk : columns;
+	network->value = value;
+
+	for (size_t i = 0; i < n; i++) {
+		network->diagonal[i] = findEntry(network, i, i);
+	}
+	for (size_t k = 0; k < network->linkCount; k++) {
+		ThermalLink* link = &network->links[k];
+		link->entry[0] = network->diagonal[link->from];
+		link->entry[1] = findEntry(network, link->from, link->to);
+		link->entry[2] = findEntry(network, link->to, link->from);
+		link->entry[3] = network->diagonal[link->to];
+	}
+
+	network->finalized = true;
+	return 0;
+}
+
+// Função para multiplicar a matriz CSR por um vetor
+static void multiply(const ThermalNetwork* network, const double* x, double* y) {
+	for (size_t i = 0; i < network->nodeCount; i++) {
+		double sum = 0.0;
+		for (size_t k = network->rowStart[i]; k < network->rowStart[i + 1]; k++) {
+			sum += network->value[k] * x[network->column[k]];
+		}
+		y[i] = sum;
+	}
+}
+
+static double dot(const double* a, const double* b, size_t n) {
+	double sum = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+// Função para avançar a rede um passo dt com Euler implícito:
+// (C/dt + G(Tⁿ)) Tⁿ⁺¹ = C/dt Tⁿ + Q, com os nós de fronteira passados para o segundo membro
+int thermalNetworkStep(ThermalNetwork* network, double dt) {
+	if (!network->finalized && thermalNetworkFinalize(network) != 0) {
+		return -1;
+	}
+
+	size_t n = network->nodeCount;
+	double* T = network->temperature;
+	double* b = network->rhs;
+	double* value = network->value;
+
+	memset(value, 0, network->rowStart[n] * sizeof(double));
+	for (size_t i = 0; i < n; i++) {
+		if (network->boundary[i]) {
+			value[network->diagonal[i]] = 1.0;
+			b[i] = T[i];
+		}
+		else {
+			value[network->diagonal[i]] = network->capacity[i] / dt;
+			b[i] = network->capacity[i] / dt * T[i] + network->heaterPower[i];
+		}
+	}
+
+	for (size_t k = 0; k < network->linkCount; k++) {
+		const ThermalLink* link = &network->links[k];
+		double g = link->value;
+		if (link->type == THERMAL_LINK_RADIATIVE) {
+			// R (Ti⁴ - Tj⁴) = R (Ti² + Tj²)(Ti + Tj) (Ti - Tj), avaliado em Tⁿ (Kelvin)
+			double ti = T[link->from] + KELVIN_OFFSET;
+			double tj = T[link->to] + KELVIN_OFFSET;
+			g *= (ti * ti + tj * tj) * (ti + tj);
+		}
+
+		bool fromFixed = network->boundary[link->from];
+		bool toFixed = network->boundary[link->to];
+		if (!fromFixed) {
+			value[link->entry[0]] += g;
+			if (toFixed) {
+				b[link->from] += g * T[link->to];
+			}
+			else {
+				value[link->entry[1]] -= g;
+			}
+		}
+		if (!toFixed) {
+			value[link->entry[3]] += g;
+			if (fromFixed) {
+				b[link->to] += g * T[link->from];
+			}
+			else {
+				value[link->entry[2]] -= g;
+			}
+		}
+	}
+
+	// Gradiente conjugado pré-condicionado, a partir de Tⁿ como estimativa inicial
+	double* r = network->residual;
+	double* p = network->direction;
+	double* Ap = network->product;
+	double* z = network->preconditioned;
+
+	multiply(network, T, Ap);
+	for (size_t i = 0; i < n; i++) {
+		r[i] = b[i] - Ap[i];
+		z[i] = r[i] / value[network->diagonal[i]];
+		p[i] = z[i];
+	}
+
+	double rz = dot(r, z, n);
+	double limit = THERMAL_SOLVER_TOLERANCE * THERMAL_SOLVER_TOLERANCE * dot(b, b, n);
+	int maxIterations = n > THERMAL_SOLVER_MAX_ITERATIONS ? (int)n : THERMAL_SOLVER_MAX_ITERATIONS;
+	int iteration = 0;
+	while (iteration < maxIterations && dot(r, r, n) > limit) {
+		multiply(network, p, Ap);
+		double alpha = rz / dot(p, Ap, n);
+		for (size_t i = 0; i < n; i++) {
+			T[i] += alpha * p[i];
+			r[i] -= alpha * Ap[i];
+			z[i] = r[i] / value[network->diagonal[i]];
+		}
+		double rzNext = dot(r, z, n);
+		double beta = rzNext / rz;
+		rz = rzNext;
+		for (size_t i = 0; i < n; i++) {
+			p[i] = z[i] + beta * p[i];
+		}
+		iteration++;
+	}
+
+	network->lastIterations = iteration;
+	return iteration < maxIterations ? 0 : -1;
+}
+
+// Função para simular um satélite com quatro painéis aquecidos (como os quatro aquecedores do TCF)
+// Cada painel é uma malha quadrada de nós que irradia para o espaço, com um aquecedor de película
+// distribuído por todos os nós; o termístor é um nó de capacidade pequena ligado ao centro do
+// painel, o que torna o sistema rígido para passos grandes
+// Com uma tabela orbital, cada painel absorve o fluxo ambiente desfasado de 1/4 de órbita
+int runThermalNetwork(size_t nodeCount, long steps, double dt, float setpoint, const PIDController* gains, const OrbitTable* orbit) {
+	if (nodeCount < NETWORK_MIN_NODES) {
+		fprintf(stderr, "Thermal network needs at least %d nodes (got %zu)\n", NETWORK_MIN_NODES, nodeCount);
+		return EXIT_FAILURE;
+	}
+	if (!isfinite(dt) || dt <= 0.0) {
+		fprintf(stderr, "Thermal network needs a positive time step (got %g)\n", dt);
+		return EXIT_FAILURE;
+	}
+	const size_t panels = 4;
+	size_t side = 1;
+	while (2 + panels * ((side + 1) * (side + 1) + 1) <= nodeCount) {
+		side++;
+	}
+	size_t panelNodes = side * side;
+	size_t total = 2 + panels * (panelNodes + 1);   // espaço + estrutura + painéis + termístores
+	const size_t space = 0;
+	const size_t structure = 1;
+
+	ThermalNetwork network;
+	if (thermalNetworkInit(&network, total) != 0) {
+		fprintf(stderr, "Failed to allocate thermal network\n");
+		return EXIT_FAILURE;
+	}
+
+	thermalNetworkSetNode(&network, space, 0.0, SPACE_TEMPERATURE, true);
+	thermalNetworkSetNode(&network, structure, 20000.0, 0.0, false);
+
+	size_t thermistor[4];
+	size_t firstNode[4];
+	PIDController pid[4];
+	for (size_t p = 0; p < panels; p++) {
+		size_t first = 2 + p * (panelNodes + 1);
+		for (size_t row = 0; row < side; row++) {
+			for (size_t col = 0; col < side; col++) {
+				size_t node = first + row * side + col;
+				// Painel de 900 J/K e 1 m², dividido em elementos quadrados (G entre vizinhos = k·espessura)
+				thermalNetworkSetNode(&network, node, 900.0 / panelNodes, 0.0, false);
+				thermalNetworkAddRadiator(&network, node, space, 0.05, 1.0 / panelNodes, 1.0);
+				if (col > 0) {
+					thermalNetworkAddConductor(&network, node, node - 1, 0.5);
+				}
+				if (row > 0) {
+					thermalNetworkAddConductor(&network, node, node - side, 0.5);
+				}
+			}
+		}
+		thermalNetworkAddConductor(&network, first, structure, 0.5);
+		firstNode[p] = first;
+		thermistor[p] = first + panelNodes;
+		thermalNetworkSetNode(&network, thermistor[p], 5.0, 0.0, false);
+		thermalNetworkAddConductor(&network, thermistor[p], first + panelNodes / 2, 50.0);
+		pid[p] = *gains;
+	}
+
+	if (thermalNetworkFinalize(&network) != 0) {
+		fprintf(stderr, "Failed to build thermal network matrix\n");
+		thermalNetworkFree(&network);
+		return EXIT_FAILURE;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long iterations = 0;
+	double duty[4] = { 0 };
+	for (long step = 0; step < steps; step++) {
+		// PID por painel: a saída positiva comanda a potência do aquecedor
+		for (size_t p = 0; p < panels; p++) {
+			float temperature = (float)network.temperature[thermistor[p]];
+			float output = pidControlStep(setpoint - temperature, temperature, pid[p].Kp, pid[p].Ki, pid[p].Kd,
+				&pid[p].previousError, &pid[p].integral);
+			duty[p] = output > 0.0f ? output / MAX_OUTPUT : 0.0;
+
+			double absorbed = 0.0;
+			if (orbit != NULL) {
+				double phase = orbitPhaseAt(orbit, step * dt, (double)p / panels);
+				absorbed = PANEL_ABSORPTANCE * orbitHeatFlux(orbit, phase);
+			}
+			double power = (duty[p] * HEATER_MAX_POWER + absorbed) / panelNodes;
+			for (size_t k = 0; k < panelNodes; k++) {
+				thermalNetworkSetHeater(&network, firstNode[p] + k, power);
+			}
+		}
+
+		if (thermalNetworkStep(&network, dt) != 0) {
+			fprintf(stderr, "Thermal solver did not converge at step %ld\n", step);
+			break;
+		}
+		iterations += network.lastIterations;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("Nodes: %zu, Links: %zu, Non-zeros: %zu, Steps: %ld, dt: %.1f s, Elapsed: %.3f s, Mean CG iterations: %.1f\n",
+		total, network.linkCount, network.rowStart[total], steps, dt, elapsed, steps > 0 ? (double)iterations / steps : 0.0);
+	for (size_t p = 0; p < panels; p++) {
+		printf("THERM-%02zu: %.2f C, Heater duty: %.0f%%\n", p + 1, network.temperature[thermistor[p]], duty[p] * 100.0);
+	}
+	printf("Structure: %.2f C\n", network.temperature[structure]);
+	if (orbit != NULL) {
+		double phase = orbitPhaseAt(orbit, steps * dt, 0.0);
+		printf("Orbit phase: %.3f (%s)\n", phase, orbitPeriodName(orbitEnvironment(orbit, phase)));
+	}
+
+	thermalNetworkFree(&network);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+﻿// ThermalNetwork.h : Modelo térmico de parâmetros concentrados (nós e ligações) com integração implícita.
+
+#ifndef THERMAL_NETWORK_H
+#define THERMAL_NETWORK_H
+
+#include "ThermalControlApp.h"
+#include <stdint.h>
+#include "OrbitEnvironment.h"
+
+#define STEFAN_BOLTZMANN 5.670374419e-8   // Constante de Stefan-Boltzmann (W/m²K⁴)
+#define KELVIN_OFFSET 273.15
+#define THERMAL_SOLVER_TOLERANCE 1e-10    // Resíduo relativo do gradiente conjugado
+#define THERMAL_SOLVER_MAX_ITERATIONS 1000   // Mínimo; redes maiores usam até nodeCount iterações
+
+// Tipos de ligação entre nós
+typedef enum {
+	THERMAL_LINK_CONDUCTIVE,   // Q = G (Ti - Tj), G em W/K
+	THERMAL_LINK_RADIATIVE     // Q = R (Ti⁴ - Tj⁴), R = ε σ A F em W/K⁴
+} ThermalLinkType;
+
+// Estrutura ThermalLink
+typedef struct {
+	size_t from;
+	size_t to;
+	ThermalLinkType type;
+	double value;
+	// Posições da ligação na matriz CSR: (from,from), (from,to), (to,from), (to,to)
+	size_t entry[4];
+} ThermalLink;
+
+// Estrutura ThermalNetwork
+typedef struct {
+	size_t nodeCount;
+	double* capacity;        // Capacidade térmica de cada nó (J/K)
+	double* temperature;     // Temperatura de cada nó (°C)
+	double* heaterPower;     // Potência injetada em cada nó (W)
+	uint8_t* boundary;       // 1 se o nó tem temperatura imposta (ex.: espaço profundo)
+
+	ThermalLink* links;
+	size_t linkCount;
+	size_t linkCapacity;
+
+	// Matriz (C/dt + G) em formato CSR, simétrica e definida positiva
+	size_t* rowStart;
+	size_t* column;
+	double* value;
+	size_t* diagonal;        // Posição da diagonal de cada linha
+	bool finalized;
+
+	// Vetores de trabalho do gradiente conjugado
+	double* rhs;
+	double* residual;
+	double* direction;
+	double* product;
+	double* preconditioned;
+	int lastIterations;      // Iterações do último passo
+} ThermalNetwork;
+
+// Funções da rede térmica
+int thermalNetworkInit(ThermalNetwork* network, size_t nodeCount);
+void thermalNetworkFree(ThermalNetwork* network);
+void thermalNetworkSetNode(ThermalNetwork* network, size_t node, double capacity, double temperature, bool boundary);
+int thermalNetworkAddConductor(ThermalNetwork* network, size_t from, size_t to, double conductance);
+int thermalNetworkAddRadiator(ThermalNetwork* network, size_t from, size_t to, double emissivity, double area, double viewFactor);
+void thermalNetworkSetHeater(ThermalNetwork* network, size_t node, double power);
+int thermalNetworkFinalize(ThermalNetwork* network);
+int thermalNetworkStep(ThermalNetwork* network, double dt);
+int runThermalNetwork(size_t nodeCount, long steps, double dt, float setpoint, const PIDController* gains, const OrbitTable* orbit);
+
+#endif // THERMAL_NETWORK_H
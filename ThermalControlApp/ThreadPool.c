@@ -0,0 +1,169 @@
+﻿// ThreadPool.c : Cada thread consome o seu intervalo de índices e, quando fica sem
+// trabalho, rouba metade do intervalo restante da thread mais carregada.
+
+#include "ThreadPool.h"
+
+#define THREAD_POOL_CACHE_LINE 64
+
+// Estrutura ThreadPoolWorker: intervalo [begin, end) ainda por executar
+typedef struct {
+	pthread_mutex_t lock;
+	size_t begin;
+	size_t end;
+	char padding[THREAD_POOL_CACHE_LINE]; // Evita partilha falsa entre threads vizinhas
+} ThreadPoolWorker;
+
+// Estrutura ThreadPool
+typedef struct {
+	ThreadPoolWorker* workers;
+	unsigned workerCount;
+	ThreadPoolTask task;
+	void* context;
+} ThreadPool;
+
+// Estrutura ThreadPoolArgument: argumento de cada thread
+typedef struct {
+	ThreadPool* pool;
+	unsigned id;
+} ThreadPoolArgument;
+
+// Função para obter o número de núcleos disponíveis
+unsigned threadPoolDefaultThreads() {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? (unsigned)cores : 1;
+}
+
+// Função para retirar o próximo índice do próprio intervalo
+static bool takeOwn(ThreadPoolWorker* worker, size_t* index) {
+	bool found = false;
+	pthread_mutex_lock(&worker->lock);
+	if (worker->begin < worker->end) {
+		*index = worker->begin++;
+		found = true;
+	}
+	pthread_mutex_unlock(&worker->lock);
+	return found;
+}
+
+// Função para roubar metade do trabalho restante da thread mais carregada
+static bool steal(ThreadPool* pool, ThreadPoolWorker* thief) {
+	for (;;) {
+		// Procurar a vítima com mais trabalho por executar
+		unsigned victimId = pool->workerCount;
+		size_t largest = 0;
+		for (unsigned i = 0; i < pool->workerCount; i++) {
+			ThreadPoolWorker* candidate = &pool->workers[i];
+			if (candidate == thief) {
+				continue;
+			}
+			pthread_mutex_lock(&candidate->lock);
+			size_t remaining = candidate->end - candidate->begin;
+			pthread_mutex_unlock(&candidate->lock);
+			if (remaining > largest) {
+				largest = remaining;
+				victimId = i;
+			}
+		}
+
+		if (victimId == pool->workerCount) {
+			return false; // Não há mais trabalho em nenhuma thread
+		}
+
+		ThreadPoolWorker* victim = &pool->workers[victimId];
+		size_t begin = 0;
+		size_t end = 0;
+		pthread_mutex_lock(&victim->lock);
+		size_t remaining = victim->end - victim->begin;
+		if (remaining > 0) {
+			// Fica com a metade final (arredondada para cima); a vítima mantém o início
+			size_t stolen = (remaining + 1) / 2;
+			end = victim->end;
+			begin = end - stolen;
+			victim->end = begin;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if (begin < end) {
+			pthread_mutex_lock(&thief->lock);
+			thief->begin = begin;
+			thief->end = end;
+			pthread_mutex_unlock(&thief->lock);
+			return true;
+		}
+		// A vítima esvaziou entretanto: procurar outra
+	}
+}
+
+// Função executada por cada thread
+static void* threadPoolWorkerMain(void* arg) {
+	ThreadPoolArgument* argument = (ThreadPoolArgument*)arg;
+	ThreadPool* pool = argument->pool;
+	ThreadPoolWorker* self = &pool->workers[argument->id];
+
+	for (;;) {
+		size_t index;
+		while (takeOwn(self, &index)) {
+			pool->task(index, pool->context);
+		}
+		if (!steal(pool, self)) {
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+// Função para executar task(i, context) para todos os i em [0, count)
+// threadCount = 0 usa todos os núcleos; a thread que chama também trabalha
+int threadPoolRun(size_t count, unsigned threadCount, ThreadPoolTask task, void* context) {
+	if (count == 0) {
+		return 0;
+	}
+	if (threadCount == 0) {
+		threadCount = threadPoolDefaultThreads();
+	}
+	if (threadCount > count) {
+		threadCount = (unsigned)count;
+	}
+
+	ThreadPool pool = { NULL, threadCount, task, context };
+	pool.workers = calloc(threadCount, sizeof(ThreadPoolWorker));
+	pthread_t* threads = calloc(threadCount, sizeof(pthread_t));
+	ThreadPoolArgument* arguments = calloc(threadCount, sizeof(ThreadPoolArgument));
+	if (pool.workers == NULL || threads == NULL || arguments == NULL) {
+		free(pool.workers);
+		free(threads);
+		free(arguments);
+		return -1;
+	}
+
+	// Distribuição inicial em blocos contíguos iguais
+	for (unsigned i = 0; i < threadCount; i++) {
+		pthread_mutex_init(&pool.workers[i].lock, NULL);
+		pool.workers[i].begin = count * i / threadCount;
+		pool.workers[i].end = count * (i + 1) / threadCount;
+		arguments[i].pool = &pool;
+		arguments[i].id = i;
+	}
+
+	unsigned started = 1;
+	for (unsigned i = 1; i < threadCount; i++) {
+		if (pthread_create(&threads[i], NULL, threadPoolWorkerMain, &arguments[i]) != 0) {
+			break; // O trabalho das threads em falta é roubado pelas restantes
+		}
+		started++;
+	}
+
+	threadPoolWorkerMain(&arguments[0]);
+	for (unsigned i = 1; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	for (unsigned i = 0; i < threadCount; i++) {
+		pthread_mutex_destroy(&pool.workers[i].lock);
+	}
+	free(pool.workers);
+	free(threads);
+	free(arguments);
+	return 0;
+}
@@ -0,0 +1,15 @@
+﻿// ThreadPool.h : Execução paralela de tarefas independentes com roubo de trabalho.
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "ThermalControlApp.h"
+
+// Tarefa executada uma vez por índice no intervalo [0, count)
+typedef void (*ThreadPoolTask)(size_t index, void* context);
+
+// Funções do conjunto de threads
+unsigned threadPoolDefaultThreads();
+int threadPoolRun(size_t count, unsigned threadCount, ThreadPoolTask task, void* context);
+
+#endif // THREAD_POOL_H
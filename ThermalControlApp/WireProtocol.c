@@ -0,0 +1,148 @@
+﻿// WireProtocol.c : Codificação e descodificação da trama binária, campo a campo com memcpy.
+// Em anfitriões little-endian as conversões reduzem-se a cópias.
+
+#include "WireProtocol.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define WIRE_SWAP16(x) __builtin_bswap16(x)
+#define WIRE_SWAP32(x) __builtin_bswap32(x)
+#define WIRE_SWAP64(x) __builtin_bswap64(x)
+#else
+#define WIRE_SWAP16(x) (x)
+#define WIRE_SWAP32(x) (x)
+#define WIRE_SWAP64(x) (x)
+#endif
+
+// Offsets dos campos do cabeçalho
+#define WIRE_OFFSET_MAGIC 0
+#define WIRE_OFFSET_VERSION 4
+#define WIRE_OFFSET_TYPE 5
+#define WIRE_OFFSET_LENGTH 6
+#define WIRE_OFFSET_SENSOR_COUNT 8
+#define WIRE_OFFSET_HEATER_COUNT 10
+#define WIRE_OFFSET_SEQUENCE 12
+#define WIRE_OFFSET_TIMESTAMP 16
+#define WIRE_OFFSET_HEATERS 24
+
+static inline void putU16(uint8_t* buffer, uint16_t value) {
+	value = WIRE_SWAP16(value);
+	memcpy(buffer, &value, sizeof(value));
+}
+
+static inline void putU32(uint8_t* buffer, uint32_t value) {
+	value = WIRE_SWAP32(value);
+	memcpy(buffer, &value, sizeof(value));
+}
+
+static inline void putU64(uint8_t* buffer, uint64_t value) {
+	value = WIRE_SWAP64(value);
+	memcpy(buffer, &value, sizeof(value));
+}
+
+static inline uint16_t getU16(const uint8_t* buffer) {
+	uint16_t value;
+	memcpy(&value, buffer, sizeof(value));
+	return WIRE_SWAP16(value);
+}
+
+static inline uint32_t getU32(const uint8_t* buffer) {
+	uint32_t value;
+	memcpy(&value, buffer, sizeof(value));
+	return WIRE_SWAP32(value);
+}
+
+static inline uint64_t getU64(const uint8_t* buffer) {
+	uint64_t value;
+	memcpy(&value, buffer, sizeof(value));
+	return WIRE_SWAP64(value);
+}
+
+// Função para calcular o tamanho de uma trama com sensorCount valores
+size_t wireFrameSize(uint16_t sensorCount) {
+	return WIRE_HEADER_SIZE + (size_t)sensorCount * sizeof(float);
+}
+
+// Função para codificar uma trama; devolve o número de bytes escritos ou 0 se não couber
+size_t wireEncodeFrame(const WireFrame* frame, uint8_t* buffer, size_t bufferSize) {
+	if (frame->sensorCount > WIRE_MAX_SENSORS || frame->heaterCount > WIRE_MAX_HEATERS) {
+		return 0;
+	}
+
+	size_t size = wireFrameSize(frame->sensorCount);
+	if (size > bufferSize) {
+		return 0;
+	}
+
+	putU32(buffer + WIRE_OFFSET_MAGIC, WIRE_MAGIC);
+	buffer[WIRE_OFFSET_VERSION] = WIRE_VERSION;
+	buffer[WIRE_OFFSET_TYPE] = frame->type;
+	putU16(buffer + WIRE_OFFSET_LENGTH, (uint16_t)size);
+	putU16(buffer + WIRE_OFFSET_SENSOR_COUNT, frame->sensorCount);
+	putU16(buffer + WIRE_OFFSET_HEATER_COUNT, frame->heaterCount);
+	putU32(buffer + WIRE_OFFSET_SEQUENCE, frame->sequence);
+	putU64(buffer + WIRE_OFFSET_TIMESTAMP, frame->timestamp);
+	putU64(buffer + WIRE_OFFSET_HEATERS, frame->heaters);
+
+	uint8_t* values = buffer + WIRE_HEADER_SIZE;
+	for (uint16_t i = 0; i < frame->sensorCount; i++) {
+		uint32_t bits;
+		memcpy(&bits, &frame->values[i], sizeof(bits));
+		putU32(values + i * sizeof(float), bits);
+	}
+
+	return size;
+}
+
+// Função para validar o cabeçalho e obter o tamanho da trama sem a descodificar
+// Basta ter o cabeçalho no buffer; WIRE_TRUNCATED com *frameSize > 0 indica quantos bytes faltam ler
+WireStatus wirePeekFrame(const uint8_t* buffer, size_t size, size_t* frameSize) {
+	*frameSize = 0;
+	if (size < WIRE_HEADER_SIZE) {
+		return WIRE_TRUNCATED;
+	}
+	if (getU32(buffer + WIRE_OFFSET_MAGIC) != WIRE_MAGIC) {
+		return WIRE_BAD_MAGIC;
+	}
+	if (buffer[WIRE_OFFSET_VERSION] != WIRE_VERSION) {
+		return WIRE_BAD_VERSION;
+	}
+
+	uint16_t sensorCount = getU16(buffer + WIRE_OFFSET_SENSOR_COUNT);
+	uint16_t length = getU16(buffer + WIRE_OFFSET_LENGTH);
+	if (sensorCount > WIRE_MAX_SENSORS || getU16(buffer + WIRE_OFFSET_HEATER_COUNT) > WIRE_MAX_HEATERS ||
+		length != wireFrameSize(sensorCount)) {
+		return WIRE_BAD_LENGTH;
+	}
+
+	*frameSize = length;
+	return size < length ? WIRE_TRUNCATED : WIRE_OK;
+}
+
+// Função para descodificar uma trama; *frameSize recebe o número de bytes consumidos
+WireStatus wireDecodeFrame(const uint8_t* buffer, size_t size, WireFrame* frame, size_t* frameSize) {
+	WireStatus status = wirePeekFrame(buffer, size, frameSize);
+	if (status != WIRE_OK) {
+		return status;
+	}
+
+	frame->type = buffer[WIRE_OFFSET_TYPE];
+	frame->sensorCount = getU16(buffer + WIRE_OFFSET_SENSOR_COUNT);
+	frame->heaterCount = getU16(buffer + WIRE_OFFSET_HEATER_COUNT);
+	frame->sequence = getU32(buffer + WIRE_OFFSET_SEQUENCE);
+	frame->timestamp = getU64(buffer + WIRE_OFFSET_TIMESTAMP);
+	frame->heaters = getU64(buffer + WIRE_OFFSET_HEATERS);
+
+	const uint8_t* values = buffer + WIRE_HEADER_SIZE;
+	for (uint16_t i = 0; i < frame->sensorCount; i++) {
+		uint32_t bits = getU32(values + i * sizeof(float));
+		memcpy(&frame->values[i], &bits, sizeof(bits));
+	}
+
+	return WIRE_OK;
+}
+
+static const char* wireStatusNames[] = { "ok", "truncated", "bad magic", "bad version", "bad length" };
+
+const char* wireStatusName(WireStatus status) {
+	return status <= WIRE_BAD_LENGTH ? wireStatusNames[status] : "unknown";
+}
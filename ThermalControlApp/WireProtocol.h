@@ -0,0 +1,81 @@
+﻿// WireProtocol.h : Trama binária de formato fixo para as mensagens de temperatura e aquecedores.
+//
+// Disposição da trama (little-endian, sem preenchimento):
+//   0  uint32 magic        WIRE_MAGIC
+//   4  uint8  version      WIRE_VERSION
+//   5  uint8  type         WireMessageType
+//   6  uint16 length       Tamanho total da trama em bytes
+//   8  uint16 sensorCount  Número de floats em values[]
+//  10  uint16 heaterCount  Número de bits válidos em heaters
+//  12  uint32 sequence     Número de sequência do emissor
+//  16  uint64 timestamp    Instante de envio (ns, CLOCK_MONOTONIC)
+//  24  uint64 heaters      Bit i = aquecedor i ligado
+//  32  float  values[sensorCount]
+
+#ifndef WIRE_PROTOCOL_H
+#define WIRE_PROTOCOL_H
+
+// Não depende do resto da aplicação, para poder ser partilhado pelos dois lados do pipe
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define WIRE_MAGIC 0x53435453u      // "STCS" em little-endian
+#define WIRE_VERSION 1
+#define WIRE_HEADER_SIZE 32         // Cabeçalho mais o campo dos aquecedores
+#define WIRE_MAX_SENSORS 64
+#define WIRE_MAX_HEATERS 64
+#define WIRE_MAX_FRAME_SIZE (WIRE_HEADER_SIZE + WIRE_MAX_SENSORS * 4)
+
+// Tipos de mensagem
+typedef enum {
+	WIRE_TEMPERATURES = 1,      // TSL -> TCF: temperaturas dos sensores e estado dos aquecedores
+	WIRE_HEATER_COMMAND = 2     // TCF -> TSL: comando dos aquecedores e saída de controlo
+} WireMessageType;
+
+// Resultado da descodificação
+typedef enum {
+	WIRE_OK,
+	WIRE_TRUNCATED,     // Faltam bytes para a trama completa
+	WIRE_BAD_MAGIC,
+	WIRE_BAD_VERSION,
+	WIRE_BAD_LENGTH     // length não corresponde a sensorCount ou contagens acima do máximo
+} WireStatus;
+
+// Estrutura WireFrame: trama descodificada, no formato do anfitrião
+typedef struct {
+	uint8_t type;
+	uint16_t sensorCount;
+	uint16_t heaterCount;
+	uint32_t sequence;
+	uint64_t timestamp;
+	uint64_t heaters;
+	float values[WIRE_MAX_SENSORS];
+} WireFrame;
+
+// Funções da trama
+size_t wireFrameSize(uint16_t sensorCount);
+size_t wireEncodeFrame(const WireFrame* frame, uint8_t* buffer, size_t bufferSize);
+WireStatus wirePeekFrame(const uint8_t* buffer, size_t size, size_t* frameSize);
+WireStatus wireDecodeFrame(const uint8_t* buffer, size_t size, WireFrame* frame, size_t* frameSize);
+const char* wireStatusName(WireStatus status);
+
+// Função para obter o instante atual em nanossegundos (CLOCK_MONOTONIC)
+static inline uint64_t wireTimestampNow() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static inline void wireSetHeater(WireFrame* frame, unsigned heater, bool on) {
+	uint64_t bit = 1ull << heater;
+	frame->heaters = on ? (frame->heaters | bit) : (frame->heaters & ~bit);
+}
+
+static inline bool wireHeaterOn(const WireFrame* frame, unsigned heater) {
+	return (frame->heaters >> heater) & 1u;
+}
+
+#endif // WIRE_PROTOCOL_H
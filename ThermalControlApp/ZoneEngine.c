@@ -0,0 +1,155 @@
+﻿// ZoneEngine.c : Simulação de N zonas térmicas num único passo sobre arrays contíguos.
+
+#include "ZoneEngine.h"
+
+// Número de arrays float e de arrays de bytes guardados no bloco de memória
+#define ZONE_FLOAT_ARRAYS 10
+
+// Função para inicializar o motor com um número fixo de zonas
+int zoneEngineInit(ZoneEngine* engine, size_t count) {
+	memset(engine, 0, sizeof(*engine));
+	if (count == 0) {
+		return -1;
+	}
+
+	size_t capacity = (count + ZONE_ENGINE_PADDING - 1) / ZONE_ENGINE_PADDING * ZONE_ENGINE_PADDING;
+	size_t floatBytes = capacity * sizeof(float);
+	size_t totalBytes = floatBytes * ZONE_FLOAT_ARRAYS + capacity;
+
+	// Um só bloco alinhado: todos os arrays ficam contíguos e alinhados à linha de cache
+	void* storage = NULL;
+	if (posix_memalign(&storage, ZONE_ENGINE_ALIGNMENT, totalBytes) != 0) {
+		return -1;
+	}
+	memset(storage, 0, totalBytes);
+
+	char* cursor = (char*)storage;
+	engine->temperature = (float*)cursor; cursor += floatBytes;
+	engine->setpoint = (float*)cursor; cursor += floatBytes;
+	engine->Kp = (float*)cursor; cursor += floatBytes;
+	engine->Ki = (float*)cursor; cursor += floatBytes;
+	engine->Kd = (float*)cursor; cursor += floatBytes;
+	engine->previousError = (float*)cursor; cursor += floatBytes;
+	engine->integral = (float*)cursor; cursor += floatBytes;
+	engine->output = (float*)cursor; cursor += floatBytes;
+	engine->error = (float*)cursor; cursor += floatBytes;
+	engine->orbitPhase = (float*)cursor; cursor += floatBytes;
+	engine->controlEnabled = (uint8_t*)cursor;
+
+	engine->count = count;
+	engine->capacity = capacity;
+	engine->storage = storage;
+
+	// Por omissão todas as zonas usam o PID completo
+	ZoneGroup all = { 0, count, CONTROLLER_PID };
+	if (zoneEngineSetGroups(engine, &all, 1) != 0) {
+		zoneEngineFree(engine);
+		return -1;
+	}
+	return 0;
+}
+
+// Função para libertar a memória do motor
+void zoneEngineFree(ZoneEngine* engine) {
+	free(engine->storage);
+	free(engine->groups);
+	memset(engine, 0, sizeof(*engine));
+}
+
+// Função para configurar o estado inicial de uma zona
+void zoneEngineSetZone(ZoneEngine* engine, size_t zone, float temperature, float setpoint, const PIDController* pid, bool enabled) {
+	if (zone >= engine->count) {
+		return;
+	}
+
+	engine->temperature[zone] = temperature;
+	engine->setpoint[zone] = setpoint;
+	engine->Kp[zone] = pid->Kp;
+	engine->Ki[zone] = pid->Ki;
+	engine->Kd[zone] = pid->Kd;
+	engine->previousError[zone] = pid->previousError;
+	engine->integral[zone] = pid->integral;
+	engine->output[zone] = 0.0f;
+	engine->controlEnabled[zone] = enabled ? 1 : 0;
+}
+
+// Função para definir os grupos de zonas (intervalos dentro de [0, count))
+int zoneEngineSetGroups(ZoneEngine* engine, const ZoneGroup* groups, size_t groupCount) {
+	for (size_t g = 0; g < groupCount; g++) {
+		if (groups[g].begin > groups[g].end || groups[g].end > engine->count || groups[g].kind >= CONTROLLER_KIND_COUNT) {
+			return -1;
+		}
+	}
+
+	ZoneGroup* copy = malloc((groupCount > 0 ? groupCount : 1) * sizeof(ZoneGroup));
+	if (copy == NULL) {
+		return -1;
+	}
+	memcpy(copy, groups, groupCount * sizeof(ZoneGroup));
+
+	free(engine->groups);
+	engine->groups = copy;
+	engine->groupCount = groupCount;
+	return 0;
+}
+
+// Função para associar uma tabela orbital partilhada (só de leitura) ao motor
+// As fases iniciais de cada zona ficam em engine->orbitPhase
+void zoneEngineSetEnvironment(ZoneEngine* engine, const OrbitTable* orbit, double dt, float environmentGain) {
+	engine->orbit = orbit;
+	engine->orbitPhaseStep = orbit != NULL ? (float)(dt / orbit->period) : 0.0f;
+	engine->environmentGain = environmentGain;
+}
+
+// Função para avançar todas as zonas um ciclo de simulação
+// O controlo usa o kernel de cada grupo (ControllerVariants) e a planta segue adjustTemperature()
+void zoneEngineStep(ZoneEngine* engine) {
+	size_t count = engine->count;
+	float* restrict temperature = engine->temperature;
+	const float* restrict setpoint = engine->setpoint;
+	float* restrict output = engine->output;
+	float* restrict error = engine->error;
+	const uint8_t* restrict controlEnabled = engine->controlEnabled;
+
+	for (size_t i = 0; i < count; i++) {
+		error[i] = setpoint[i] - temperature[i];
+	}
+
+	// Despacho uma vez por grupo; zonas sem controlo mantêm o estado e recebem saída 0
+	for (size_t g = 0; g < engine->groupCount; g++) {
+		const ZoneGroup* group = &engine->groups[g];
+		size_t b = group->begin;
+		ControllerKernel kernel = controllerGetKernel(group->kind);
+		kernel(group->end - b, error + b, temperature + b, engine->Kp + b, engine->Ki + b, engine->Kd + b,
+			controlEnabled + b, engine->previousError + b, engine->integral + b, output + b);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		float current = temperature[i];
+
+		if (controlEnabled[i]) {
+			current = zonePlantStep(current, output[i]);
+		}
+		else if (current > MIN_TEMPERATURE) {
+			// Sem controlo térmico a temperatura desce até ao limite inferior
+			current -= TEMPERATURE_DRIFT;
+		}
+
+		temperature[i] = current;
+	}
+
+	// Ambiente orbital: uma consulta à tabela por zona, sem ramificações por período
+	const OrbitTable* orbit = engine->orbit;
+	if (orbit != NULL) {
+		float* restrict phase = engine->orbitPhase;
+		float gain = engine->environmentGain;
+		float meanHeatFlux = orbit->meanHeatFlux;
+		float phaseStep = engine->orbitPhaseStep;
+
+		for (size_t i = 0; i < count; i++) {
+			temperature[i] += gain * (orbitHeatFlux(orbit, phase[i]) - meanHeatFlux);
+			float next = phase[i] + phaseStep;
+			phase[i] = next - floorf(next);
+		}
+	}
+}
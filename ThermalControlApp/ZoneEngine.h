@@ -0,0 +1,65 @@
+﻿// ZoneEngine.h : Motor de simulação multi-zona em estrutura de arrays (SoA).
+
+#ifndef ZONE_ENGINE_H
+#define ZONE_ENGINE_H
+
+#include "ThermalControlApp.h"
+#include "OrbitEnvironment.h"
+#include "ControllerVariants.h"
+#include <stdint.h>
+
+#define ZONE_ENGINE_ALIGNMENT 64   // Alinhamento de cada array (uma linha de cache)
+#define ZONE_ENGINE_PADDING 16     // Cada array é arredondado a múltiplos de 16 floats
+#define ORBIT_ENVIRONMENT_GAIN 0.001f  // Ganho por omissão do ambiente orbital (°C por ciclo por W/m²)
+
+// Estrutura ZoneGroup: intervalo contíguo de zonas com o mesmo tipo de controlador
+typedef struct {
+	size_t begin;
+	size_t end;
+	ControllerKind kind;
+} ZoneGroup;
+
+// Estrutura ZoneEngine: cada campo é um array contíguo com um elemento por zona
+typedef struct {
+	size_t count;             // Número de zonas simuladas
+	size_t capacity;          // Número de elementos alocados por array
+	float* temperature;       // Temperatura atual de cada zona
+	float* setpoint;          // Setpoint de cada zona
+	float* Kp;
+	float* Ki;
+	float* Kd;
+	float* previousError;
+	float* integral;
+	float* output;            // Saída do controlo no último passo
+	float* error;             // Erro do último passo (entrada do kernel PID em lote)
+	float* orbitPhase;        // Fase da órbita de cada zona [0, 1)
+	uint8_t* controlEnabled;  // 1 se o controlo térmico da zona estiver ativo
+	void* storage;            // Bloco único que contém todos os arrays
+	ZoneGroup* groups;        // Grupos de zonas; o kernel é escolhido uma vez por grupo
+	size_t groupCount;
+	const OrbitTable* orbit;  // Ambiente orbital partilhado (NULL = sem ambiente)
+	float orbitPhaseStep;     // Avanço da fase por ciclo (dt / período)
+	float environmentGain;    // °C por ciclo por W/m² acima do fluxo médio da órbita
+} ZoneEngine;
+
+// Modelo da planta de uma zona com o controlo ativo (igual a adjustTemperature)
+static inline float zonePlantStep(float temperature, float controlOutput) {
+	temperature += controlOutput;
+	if (temperature > MAX_TEMPERATURE) {
+		temperature -= TEMPERATURE_DRIFT;
+	}
+	else if (temperature < MIN_TEMPERATURE) {
+		temperature += TEMPERATURE_DRIFT;
+	}
+	return temperature;
+}
+
+// Funções do motor multi-zona
+int zoneEngineInit(ZoneEngine* engine, size_t count);
+void zoneEngineFree(ZoneEngine* engine);
+void zoneEngineSetZone(ZoneEngine* engine, size_t zone, float temperature, float setpoint, const PIDController* pid, bool enabled);
+int zoneEngineSetGroups(ZoneEngine* engine, const ZoneGroup* groups, size_t groupCount);
+void zoneEngineSetEnvironment(ZoneEngine* engine, const OrbitTable* orbit, double dt, float environmentGain);
+void zoneEngineStep(ZoneEngine* engine);
+
+#endif // ZONE_ENGINE_H
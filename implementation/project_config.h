@@ -3,5 +3,6 @@
 
 #define TEMP_INFO_PIPE "/tmp/temp_info_pipe"
 #define RESPONSE_PIPE "/tmp/response_pipe"
+#define TELEMETRY_SOCKET "/tmp/stcs_telemetry_socket"
 
 #endif //PROJECT_CONFIG_H
\ No newline at end of file